@@ -18,6 +18,7 @@
 
 #include "android_autobrightness_algorithm.h"
 #include "brightness_params.h"
+#include "chrono.h"
 #include "device_config.h"
 #include "event_loop.h"
 #include "event_loop_handler_registration.h"
@@ -35,10 +36,20 @@ namespace
 
 char const* const log_tag = "AndroidAutobrightnessAlgorithm";
 auto const null_handler = [](auto){};
-auto constexpr smoothing_factor_slow = 2000.0;
-auto constexpr smoothing_factor_fast = 200.0;
-auto constexpr hysteresis_factor = 0.1;
-auto constexpr debounce_delay = std::chrono::seconds{4};
+auto constexpr default_smoothing_factor_slow = 2000.0;
+auto constexpr default_smoothing_factor_fast = 200.0;
+auto constexpr default_hysteresis_factor = 0.1;
+auto constexpr default_debounce_delay_ms = 4000.0;
+auto constexpr min_hysteresis = 2.0;
+
+double get_double(
+    repowerd::DeviceConfig const& device_config,
+    std::string const& name,
+    double default_value)
+{
+    try { return std::stod(device_config.get(name, "")); }
+    catch (...) { return default_value; }
+}
 
 std::vector<int> parse_int_array(std::string const& str)
 {
@@ -103,12 +114,21 @@ double exponential_smoothing(
 
 repowerd::AndroidAutobrightnessAlgorithm::AndroidAutobrightnessAlgorithm(
     DeviceConfig const& device_config,
+    std::shared_ptr<Chrono> const& chrono,
     std::shared_ptr<Log> const& log)
     : brightness_spline{create_brightness_spline(device_config)},
       max_brightness{get_max_brightness(device_config)},
+      smoothing_factor_fast{
+          get_double(device_config, "autoBrightnessSmoothingFast", default_smoothing_factor_fast)},
+      smoothing_factor_slow{
+          get_double(device_config, "autoBrightnessSmoothingSlow", default_smoothing_factor_slow)},
+      hysteresis_factor{
+          get_double(device_config, "autoBrightnessHysteresis", default_hysteresis_factor)},
+      debounce_delay{static_cast<int64_t>(
+          get_double(device_config, "autoBrightnessDebounceMs", default_debounce_delay_ms))},
+      chrono{chrono},
       log{log},
-      started{false},
-      debouncing_seqnum{0}
+      started{false}
 {
     reset();
 }
@@ -120,6 +140,7 @@ bool repowerd::AndroidAutobrightnessAlgorithm::init(EventLoop& event_loop)
     if (!brightness_spline) return false;
 
     this->event_loop = &event_loop;
+    debounce_timeout = chrono->create_timeout(event_loop, [this] { debounce(); });
     return true;
 }
 
@@ -164,6 +185,21 @@ void repowerd::AndroidAutobrightnessAlgorithm::stop()
     }
 }
 
+bool repowerd::AndroidAutobrightnessAlgorithm::light_is_stable()
+{
+    if (!started || !have_previous_light_values())
+        return false;
+
+    // Stable when the averages and the latest light value are all within
+    // the hysteresis band of the applied light, so debouncing won't change
+    // the brightness
+    auto const hysteresis = std::max(applied_light * hysteresis_factor, min_hysteresis);
+
+    return fabs(fast_average - applied_light) < hysteresis &&
+           fabs(slow_average - applied_light) < hysteresis &&
+           fabs(last_light - applied_light) < hysteresis;
+}
+
 repowerd::HandlerRegistration repowerd::AndroidAutobrightnessAlgorithm::register_autobrightness_handler(
     AutobrightnessHandler const& handler)
 {
@@ -175,23 +211,26 @@ repowerd::HandlerRegistration repowerd::AndroidAutobrightnessAlgorithm::register
 
 void repowerd::AndroidAutobrightnessAlgorithm::reset()
 {
+    have_light_values = false;
     last_light = 0.0;
     last_light_tp = {};
     applied_light = 0.0;
     fast_average = 0.0;
     slow_average = 0.0;
     debouncing = false;
-    ++debouncing_seqnum;
+    // The debounce timeout is created when the algorithm is initialized
+    if (debounce_timeout)
+        debounce_timeout->cancel();
 }
 
 bool repowerd::AndroidAutobrightnessAlgorithm::have_previous_light_values()
 {
-    return last_light_tp != std::chrono::steady_clock::time_point{};
+    return have_light_values;
 }
 
 void repowerd::AndroidAutobrightnessAlgorithm::update_averages(double light)
 {
-    auto const now = std::chrono::steady_clock::now();
+    auto const now = chrono->steady_now();
 
     if (!have_previous_light_values())
     {
@@ -211,6 +250,7 @@ void repowerd::AndroidAutobrightnessAlgorithm::update_averages(double light)
         slow_average = exponential_smoothing(slow_average, light, slow_factor);
     }
 
+    have_light_values = true;
     last_light_tp = now;
     last_light = light;
 }
@@ -221,50 +261,40 @@ void repowerd::AndroidAutobrightnessAlgorithm::schedule_debounce()
         return;
 
     debouncing = true;
-    ++debouncing_seqnum;
-
-    log->log(log_tag, "schedule_debounce(), seqnum=%d", debouncing_seqnum);
-
-    event_loop->schedule_in(
-        debounce_delay,
-        [this, expected_debouncing_seqnum=debouncing_seqnum]
-        {
-            if (debouncing_seqnum != expected_debouncing_seqnum)
-            {
-                log->log(log_tag, "debounce() ignored, expected_seqnum=%d, actual_seqnum=%d",
-                         expected_debouncing_seqnum, debouncing_seqnum);
-                return;
-            }
-
-            auto constexpr min_hysteresis = 2.0;
-
-            debouncing = false;
-            update_averages(last_light);
-
-            auto const hysteresis = std::max(applied_light * hysteresis_factor, min_hysteresis);
-            auto const slow_delta = slow_average - applied_light;
-            auto const fast_delta = fast_average - applied_light;
-            log->log(log_tag,
-                     "debounce(), seqnum=%d, applied_light=%.2f, hysteresis=%.2f, "
-                     "slow_average=%.2f, fast_average=%.2f, slow_delta=%.2f, "
-                     "fast_delta=%.2f",
-                     expected_debouncing_seqnum, applied_light, hysteresis, slow_average,
-                     fast_average, slow_delta, fast_delta);
-
-            if ((slow_delta >= hysteresis && fast_delta >= hysteresis) ||
-                (-slow_delta >= hysteresis && -fast_delta >= hysteresis))
-            {
-                log->log(log_tag, "debounce(), apply light %.2f", fast_average);
-                notify_brightness(brightness_spline->interpolate(fast_average));
-                applied_light = fast_average;
-            }
-
-            auto const hysteresis_last_light =
-                std::max(last_light * hysteresis_factor, min_hysteresis);
-
-            if (fabs(fast_average - last_light) >= hysteresis_last_light)
-                schedule_debounce();
-        });
+
+    log->log(log_tag, "schedule_debounce()");
+
+    debounce_timeout->arm_in(debounce_delay);
+}
+
+void repowerd::AndroidAutobrightnessAlgorithm::debounce()
+{
+    debouncing = false;
+    update_averages(last_light);
+
+    auto const hysteresis = std::max(applied_light * hysteresis_factor, min_hysteresis);
+    auto const slow_delta = slow_average - applied_light;
+    auto const fast_delta = fast_average - applied_light;
+    log->log(log_tag,
+             "debounce(), applied_light=%.2f, hysteresis=%.2f, "
+             "slow_average=%.2f, fast_average=%.2f, slow_delta=%.2f, "
+             "fast_delta=%.2f",
+             applied_light, hysteresis, slow_average,
+             fast_average, slow_delta, fast_delta);
+
+    if ((slow_delta >= hysteresis && fast_delta >= hysteresis) ||
+        (-slow_delta >= hysteresis && -fast_delta >= hysteresis))
+    {
+        log->log(log_tag, "debounce(), apply light %.2f", fast_average);
+        notify_brightness(brightness_spline->interpolate(fast_average));
+        applied_light = fast_average;
+    }
+
+    auto const hysteresis_last_light =
+        std::max(last_light * hysteresis_factor, min_hysteresis);
+
+    if (fabs(fast_average - last_light) >= hysteresis_last_light)
+        schedule_debounce();
 }
 
 void repowerd::AndroidAutobrightnessAlgorithm::notify_brightness(double brightness)
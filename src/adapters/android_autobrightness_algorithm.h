@@ -25,15 +25,18 @@
 
 namespace repowerd
 {
+class Chrono;
 class DeviceConfig;
 class Log;
 class MonotoneSpline;
+class Timeout;
 
 class AndroidAutobrightnessAlgorithm : public AutobrightnessAlgorithm
 {
 public:
     AndroidAutobrightnessAlgorithm(
         DeviceConfig const& device_config,
+        std::shared_ptr<Chrono> const& chrono,
         std::shared_ptr<Log> const& log);
 
     ~AndroidAutobrightnessAlgorithm();
@@ -43,6 +46,7 @@ public:
     void new_light_value(double light) override;
     void start() override;
     void stop() override;
+    bool light_is_stable() override;
 
     HandlerRegistration register_autobrightness_handler(
         AutobrightnessHandler const& handler) override;
@@ -52,22 +56,31 @@ private:
     bool have_previous_light_values();
     void update_averages(double light);
     void schedule_debounce();
+    void debounce();
     void notify_brightness(double brightness);
 
     EventLoop* event_loop;
     std::unique_ptr<MonotoneSpline> const brightness_spline;
     double const max_brightness;
+    double const smoothing_factor_fast;
+    double const smoothing_factor_slow;
+    double const hysteresis_factor;
+    std::chrono::milliseconds const debounce_delay;
+    std::shared_ptr<Chrono> const chrono;
     std::shared_ptr<Log> const log;
     AutobrightnessHandler autobrightness_handler;
 
     bool started;
+    bool have_light_values;
     std::chrono::steady_clock::time_point last_light_tp;
     double last_light;
     double applied_light;
     double fast_average;
     double slow_average;
     bool debouncing;
-    int debouncing_seqnum;
+    // Rearmed for each debounce period, so that a single timer is ever
+    // pending, and cancelled debounces don't wake up the loop
+    std::unique_ptr<Timeout> debounce_timeout;
 };
 
 }
@@ -46,7 +46,7 @@ repowerd::AndroidBacklight::~AndroidBacklight()
 
 void repowerd::AndroidBacklight::set_brightness(double value)
 {
-    int const value_abs = round(value * 255);
+    int const value_abs = round(value * max_raw_brightness());
 
     light_state_t state;
     memset(&state, 0, sizeof(light_state_t));
@@ -63,3 +63,8 @@ double repowerd::AndroidBacklight::get_brightness()
 {
     return brightness;
 }
+
+int repowerd::AndroidBacklight::max_raw_brightness()
+{
+    return 255;
+}
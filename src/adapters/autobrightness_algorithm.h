@@ -39,6 +39,9 @@ public:
     virtual void new_light_value(double light) = 0;
     virtual void start() = 0;
     virtual void stop() = 0;
+    // Whether the light values have settled, so that light changes the
+    // algorithm would react to are unlikely
+    virtual bool light_is_stable() = 0;
 
     virtual HandlerRegistration register_autobrightness_handler(
         AutobrightnessHandler const& handler) = 0;
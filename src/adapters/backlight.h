@@ -28,6 +28,8 @@ public:
 
     virtual void set_brightness(double) = 0;
     virtual double get_brightness() = 0;
+    // The number of distinct non-zero levels the hardware supports
+    virtual int max_raw_brightness() = 0;
 
     static double constexpr unknown_brightness = -1.0;
 
@@ -21,17 +21,18 @@
 #include "backlight.h"
 #include "brightness_params.h"
 #include "chrono.h"
+#include "device_config.h"
 #include "device_quirks.h"
 #include "event_loop_handler_registration.h"
 #include "light_sensor.h"
 
 #include "src/core/log.h"
 
+#include <algorithm>
 #include <cmath>
 #include <chrono>
+#include <future>
 #include <string>
-#include <thread>
-#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -53,9 +54,17 @@ double dim_brightness_percent(repowerd::DeviceConfig const& device_config)
     return static_cast<double>(brightness_params.dim_value) / brightness_params.max_value;
 }
 
+repowerd::BrightnessEasing transition_easing(repowerd::DeviceConfig const& device_config)
+{
+    return repowerd::brightness_easing_from_string(
+        device_config.get("brightnessTransitionEasing", "linear"),
+        repowerd::BrightnessEasing::linear);
+}
+
 }
 
 repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
     std::shared_ptr<Backlight> const& backlight,
     std::shared_ptr<LightSensor> const& light_sensor,
     std::shared_ptr<AutobrightnessAlgorithm> const& autobrightness_algorithm,
@@ -71,13 +80,23 @@ repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
       normal_before_display_on_autobrightness{
           quirks.normal_before_display_on_autobrightness()},
       ab_supported{autobrightness_algorithm->init(event_loop)},
+      brightness_curve{
+          BrightnessCurve::from_device_config(device_config, backlight->max_raw_brightness())},
+      transition_easing{::transition_easing(device_config)},
+      transition_frame{0},
+      event_loop{event_loop_reactor},
       brightness_handler{null_handler},
       dim_brightness{dim_brightness_percent(device_config)},
       normal_brightness{normal_brightness_percent(device_config)},
       user_normal_brightness{normal_brightness},
+      last_set_brightness{Backlight::unknown_brightness},
+      last_backlight_value{Backlight::unknown_brightness},
       active_brightness_type{ActiveBrightnessType::off},
-      ab_active{false}
+      ab_active{false},
+      reduced_light_sampling{false}
 {
+    transition_timeout = chrono->create_timeout(event_loop, [this] { run_transition_frame(); });
+
     if (ab_supported)
     {
         ab_handler_registration = autobrightness_algorithm->register_autobrightness_handler(
@@ -99,39 +118,47 @@ repowerd::BacklightBrightnessControl::BacklightBrightnessControl(
         light_handler_registration = light_sensor->register_light_handler(
             [this] (double light)
             {
-                event_loop.enqueue(
+                event_loop.post(
                     [this, light]
                     {
                         this->autobrightness_algorithm->new_light_value(light);
+                        update_light_sampling();
                     });
             });
     }
 }
 
+repowerd::BacklightBrightnessControl::~BacklightBrightnessControl()
+{
+    // Requests are asynchronous, so make sure none is still pending or
+    // running while members are destroyed
+    flush();
+}
+
 void repowerd::BacklightBrightnessControl::disable_autobrightness()
 {
     if (!ab_supported) return;
 
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         {
             if (ab_active)
             {
                 autobrightness_algorithm->stop();
-                light_sensor->disable_light_events();
+                disable_light_events();
                 normal_brightness = user_normal_brightness;
                 ab_active = false;
                 if (active_brightness_type == ActiveBrightnessType::normal)
                     transition_to_brightness_value(normal_brightness, TransitionSpeed::slow);
             }
-        }).get();
+        });
 }
 
 void repowerd::BacklightBrightnessControl::enable_autobrightness()
 {
     if (!ab_supported) return;
 
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         { 
             if (!ab_active)
@@ -143,22 +170,22 @@ void repowerd::BacklightBrightnessControl::enable_autobrightness()
                 }
                 ab_active = true;
             }
-        }).get();
+        });
 }
 
 void repowerd::BacklightBrightnessControl::set_dim_brightness()
 {
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         { 
             transition_to_brightness_value(dim_brightness, TransitionSpeed::normal);
             active_brightness_type = ActiveBrightnessType::dim;
-        }).get();
+        });
 }
 
 void repowerd::BacklightBrightnessControl::set_normal_brightness()
 {
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         { 
             if (ab_active && active_brightness_type == ActiveBrightnessType::off)
@@ -174,12 +201,12 @@ void repowerd::BacklightBrightnessControl::set_normal_brightness()
             }
 
             active_brightness_type = ActiveBrightnessType::normal;
-        }).get();
+        });
 }
 
 void repowerd::BacklightBrightnessControl::set_normal_brightness_value(double v)
 {
-    event_loop.enqueue(
+    event_loop.post(
         [this,v]
         { 
             user_normal_brightness = v;
@@ -188,19 +215,21 @@ void repowerd::BacklightBrightnessControl::set_normal_brightness_value(double v)
                 normal_brightness = user_normal_brightness;
                 transition_to_brightness_value(normal_brightness, TransitionSpeed::normal);
             }
-        }).get();
+        });
 }
 
-void repowerd::BacklightBrightnessControl::set_off_brightness()
+void repowerd::BacklightBrightnessControl::set_off_brightness(
+    std::function<void()> const& brightness_off)
 {
-    event_loop.enqueue(
-        [this]
+    event_loop.post(
+        [this, brightness_off]
         { 
             transition_to_brightness_value(0, TransitionSpeed::normal);
             active_brightness_type = ActiveBrightnessType::off;
             autobrightness_algorithm->stop();
-            light_sensor->disable_light_events();
-        }).get();
+            disable_light_events();
+            when_transition_idle(brightness_off);
+        });
 }
 
 repowerd::HandlerRegistration
@@ -213,65 +242,201 @@ repowerd::BacklightBrightnessControl::register_brightness_handler(
         [this] { brightness_handler = null_handler; });
 }
 
+void repowerd::BacklightBrightnessControl::cancel_brightness_transition()
+{
+    event_loop.post(
+        [this]
+        {
+            if (transition)
+            {
+                log->log(log_tag, "Transitioning brightness %.2f => %.2f cancelled at %.2f",
+                         transition->from(), transition->to(), get_brightness_value());
+                stop_transition();
+                notify_transition_idle();
+            }
+        });
+}
+
+void repowerd::BacklightBrightnessControl::flush()
+{
+    auto const idle = std::make_shared<std::promise<void>>();
+    auto idle_future = idle->get_future();
+
+    event_loop.post(
+        [this, idle]
+        {
+            when_transition_idle([idle] { idle->set_value(); });
+        });
+
+    idle_future.get();
+}
+
 void repowerd::BacklightBrightnessControl::transition_to_brightness_value(
     double brightness, TransitionSpeed transition_speed)
 {
-    auto const step = 0.01;
-    auto const backlight_brightness = get_brightness_value();
-    auto const starting_brightness =
-        backlight_brightness == Backlight::unknown_brightness ?
-        brightness - step : backlight_brightness;
-    auto const num_steps = std::ceil(std::fabs(starting_brightness - brightness) / step);
-    auto const step_time = (transition_speed == TransitionSpeed::slow ||
-                            starting_brightness == 0.0
-                            || brightness == 0.0) ?
-                            100000us / num_steps : 1000us;
+    // Already on the way there, so let the transition in progress finish
+    if (transition && transition->to() == brightness)
+        return;
 
-    if (starting_brightness != brightness)
-    {
-        log->log(log_tag, "Transitioning brightness %.2f => %.2f in %.2f steps %.2fus each",
-                 starting_brightness, brightness, num_steps, step_time.count());
-    }
+    // Retarget from wherever an interrupted transition has got to
+    auto const interrupted = static_cast<bool>(transition);
+    stop_transition();
 
-    auto current_brightness = starting_brightness;
+    auto const starting_brightness = get_brightness_value();
 
-    if (current_brightness < brightness)
+    if (starting_brightness == Backlight::unknown_brightness)
     {
-        while (current_brightness < brightness)
-        {
-            current_brightness += step;
-            if (current_brightness > brightness) current_brightness = brightness;
-            set_brightness_value(current_brightness);
-            chrono->sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(step_time));
-        }
+        set_brightness_value(brightness);
+        brightness_handler(brightness);
+        notify_transition_idle();
+        return;
     }
-    else if (current_brightness > brightness)
+
+    if (starting_brightness == brightness)
     {
-        while (current_brightness > brightness)
-        {
-            current_brightness -= step;
-            if (current_brightness < brightness) current_brightness = brightness;
-            set_brightness_value(current_brightness);
-            chrono->sleep_for(std::chrono::duration_cast<std::chrono::nanoseconds>(step_time));
-        }
+        if (interrupted)
+            brightness_handler(brightness);
+        notify_transition_idle();
+        return;
     }
 
-    if (starting_brightness != brightness)
+    auto const step = 0.01;
+    auto const num_steps = std::ceil(std::fabs(starting_brightness - brightness) / step);
+    auto const duration = (transition_speed == TransitionSpeed::slow ||
+                           starting_brightness == 0.0 ||
+                           brightness == 0.0) ?
+                          std::chrono::microseconds{100000} :
+                          std::chrono::microseconds{static_cast<int64_t>(num_steps * 1000)};
+
+    transition = std::make_unique<BrightnessAnimation>(
+        starting_brightness, brightness, duration,
+        brightness_curve.raw_levels_between(starting_brightness, brightness),
+        transition_easing);
+    transition_start = chrono->steady_now();
+    transition_frame = 0;
+
+    log->log(log_tag, "Transitioning brightness %.2f => %.2f in %d steps %.2fus each",
+             starting_brightness, brightness, transition->num_frames(),
+             static_cast<double>(transition->frame_interval().count()));
+
+    // Show the first frame right away, so that the new request takes
+    // effect immediately even when it interrupts another transition
+    run_transition_frame();
+}
+
+void repowerd::BacklightBrightnessControl::run_transition_frame()
+{
+    if (!transition)
+        return;
+
+    if (transition_frame < transition->num_frames())
     {
-        log->log(log_tag, "Transitioning brightness %.2f => %.2f done",
-                 starting_brightness, current_brightness);
+        set_brightness_value(transition->frame_value(transition_frame));
+        ++transition_frame;
+
+        auto const next_time = transition_frame < transition->num_frames() ?
+                               transition->frame_time(transition_frame) :
+                               transition->duration();
+        // Schedule relative to the start of the transition, so that timer
+        // latency doesn't accumulate over frames
+        auto const delay = std::max(
+            std::chrono::nanoseconds{0},
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                transition_start + next_time - chrono->steady_now()));
+
+        transition_timeout->arm_in(delay);
     }
+    else
+    {
+        auto const brightness = transition->to();
 
-    if (starting_brightness != brightness)
+        log->log(log_tag, "Transitioning brightness %.2f => %.2f done",
+                 transition->from(), brightness);
+
+        stop_transition();
         brightness_handler(brightness);
+        notify_transition_idle();
+    }
+}
+
+void repowerd::BacklightBrightnessControl::stop_transition()
+{
+    transition.reset();
+    transition_timeout->cancel();
+}
+
+void repowerd::BacklightBrightnessControl::when_transition_idle(
+    std::function<void()> const& handler)
+{
+    if (transition)
+        transition_idle_handlers.push_back(handler);
+    else
+        handler();
+}
+
+void repowerd::BacklightBrightnessControl::notify_transition_idle()
+{
+    auto const handlers = std::move(transition_idle_handlers);
+    transition_idle_handlers.clear();
+
+    for (auto const& handler : handlers)
+        handler();
 }
 
 void repowerd::BacklightBrightnessControl::set_brightness_value(double brightness)
 {
-    backlight->set_brightness(brightness);
+    auto const backlight_value = brightness_curve.backlight_value_for(brightness);
+
+    // With non-linear curves, consecutive transition frames often map to
+    // the same raw level, so don't write it again
+    if (backlight_value != last_backlight_value)
+        backlight->set_brightness(backlight_value);
+
+    last_set_brightness = brightness;
+    last_backlight_value = backlight_value;
+}
+
+void repowerd::BacklightBrightnessControl::update_light_sampling()
+{
+    // Sample light less often while the light is stable, and go back to
+    // the full rate as soon as it changes
+    auto const light_is_stable = autobrightness_algorithm->light_is_stable();
+
+    if (light_is_stable && !reduced_light_sampling)
+    {
+        log->log(log_tag, "Light is stable, reducing light sampling");
+        light_sensor->enable_reduced_light_sampling();
+        reduced_light_sampling = true;
+    }
+    else if (!light_is_stable && reduced_light_sampling)
+    {
+        log->log(log_tag, "Light changed, restoring full light sampling");
+        light_sensor->disable_reduced_light_sampling();
+        reduced_light_sampling = false;
+    }
+}
+
+void repowerd::BacklightBrightnessControl::disable_light_events()
+{
+    light_sensor->disable_light_events();
+    reduced_light_sampling = false;
 }
 
 double repowerd::BacklightBrightnessControl::get_brightness_value()
 {
-    return backlight->get_brightness();
+    auto const backlight_value = backlight->get_brightness();
+    last_backlight_value = backlight_value;
+
+    if (backlight_value == Backlight::unknown_brightness)
+        return Backlight::unknown_brightness;
+
+    // Mapping back from the backlight value is only accurate to a raw
+    // level, so prefer the exact value we set if it's still in effect
+    if (last_set_brightness != Backlight::unknown_brightness &&
+        brightness_curve.backlight_value_for(last_set_brightness) == backlight_value)
+    {
+        return last_set_brightness;
+    }
+
+    return brightness_curve.brightness_for(backlight_value);
 }
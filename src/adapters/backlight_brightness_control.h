@@ -19,10 +19,15 @@
 #pragma once
 
 #include "src/core/brightness_control.h"
+#include "brightness_animation.h"
+#include "brightness_curve.h"
 #include "brightness_notification.h"
 #include "event_loop.h"
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace repowerd
 {
@@ -34,11 +39,13 @@ class DeviceConfig;
 class DeviceQuirks;
 class LightSensor;
 class Log;
+class Timeout;
 
 class BacklightBrightnessControl : public BrightnessControl, public BrightnessNotification
 {
 public:
     BacklightBrightnessControl(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
         std::shared_ptr<Backlight> const& backlight,
         std::shared_ptr<LightSensor> const& light_sensor,
         std::shared_ptr<AutobrightnessAlgorithm> const& autobrightness_algorithm,
@@ -46,23 +53,38 @@ public:
         std::shared_ptr<Log> const& log,
         DeviceConfig const& device_config,
         DeviceQuirks const& device_quirks);
+    ~BacklightBrightnessControl();
 
     void disable_autobrightness() override;
     void enable_autobrightness() override;
     void set_dim_brightness() override;
     void set_normal_brightness() override;
     void set_normal_brightness_value(double) override;
-    void set_off_brightness() override;
+    void set_off_brightness(std::function<void()> const& brightness_off) override;
 
     HandlerRegistration register_brightness_handler(
         BrightnessHandler const& handler) override;
 
+    // Stops any brightness transition in progress, leaving the brightness
+    // at its current intermediate value
+    void cancel_brightness_transition();
+
+    // Waits until all previously requested brightness changes are applied,
+    // including any brightness transition they started
+    void flush();
+
 private:
     enum class ActiveBrightnessType {normal, dim, off};
     enum class TransitionSpeed {normal, slow};
     void transition_to_brightness_value(double brightness, TransitionSpeed transition_speed);
+    void run_transition_frame();
+    void stop_transition();
+    void when_transition_idle(std::function<void()> const& handler);
+    void notify_transition_idle();
     void set_brightness_value(double brightness);
     double get_brightness_value();
+    void update_light_sampling();
+    void disable_light_events();
 
     std::shared_ptr<Backlight> const backlight;
     std::shared_ptr<LightSensor> const light_sensor;
@@ -71,6 +93,16 @@ private:
     std::shared_ptr<Log> const log;
     bool const normal_before_display_on_autobrightness;
     bool const ab_supported;
+    BrightnessCurve const brightness_curve;
+    BrightnessEasing const transition_easing;
+
+    // Transition state, only accessed from the event loop thread. The
+    // timeout is rearmed for each frame and must outlive the loop.
+    std::unique_ptr<BrightnessAnimation> transition;
+    std::chrono::steady_clock::time_point transition_start;
+    int transition_frame;
+    std::unique_ptr<Timeout> transition_timeout;
+    std::vector<std::function<void()>> transition_idle_handlers;
 
     EventLoop event_loop;
     HandlerRegistration light_handler_registration;
@@ -80,8 +112,11 @@ private:
     double dim_brightness;
     double normal_brightness;
     double user_normal_brightness;
+    double last_set_brightness;
+    double last_backlight_value;
     ActiveBrightnessType active_brightness_type;
     bool ab_active;
+    bool reduced_light_sampling;
 };
 
 }
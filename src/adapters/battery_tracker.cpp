@@ -0,0 +1,298 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "battery_tracker.h"
+#include "device_config.h"
+#include "event_loop.h"
+#include "event_loop_handler_registration.h"
+#include "event_loop_timeout.h"
+#include "temporary_suspend_inhibition.h"
+
+#include "src/core/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+auto const null_batteryinfo_handler = [](repowerd::BatteryInfo*){};
+auto const null_handler = []{};
+
+double get_critical_temperature(repowerd::DeviceConfig const& device_config)
+try
+{
+    auto const ct_str = device_config.get("shutdownBatteryTemperature", "680");
+    return ((double)std::stoi(ct_str)) * 0.1;
+}
+catch (...)
+{
+    return 68.0;
+}
+
+std::chrono::milliseconds get_level_change_min_interval(
+    repowerd::DeviceConfig const& device_config)
+try
+{
+    return std::chrono::milliseconds{
+        std::stoi(device_config.get("batteryLevelChangeMinIntervalMs", "10000"))};
+}
+catch (...)
+{
+    return std::chrono::milliseconds{10000};
+}
+
+double get_level_change_min_percentage_delta(
+    repowerd::DeviceConfig const& device_config)
+try
+{
+    return std::stod(device_config.get("batteryLevelChangeMinPercentageDelta", "1.0"));
+}
+catch (...)
+{
+    return 1.0;
+}
+
+bool is_state(uint32_t state, repowerd::BatteryState battery_state)
+{
+    return state == static_cast<uint32_t>(battery_state);
+}
+
+}
+
+repowerd::BatteryTracker::BatteryTracker(
+    std::shared_ptr<Log> const& log,
+    std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
+    DeviceConfig const& device_config,
+    EventLoop& event_loop,
+    char const* log_tag,
+    std::function<bool()> const& is_using_battery_power)
+    : log{log},
+      temporary_suspend_inhibition{temporary_suspend_inhibition},
+      critical_temperature{get_critical_temperature(device_config)},
+      level_change_min_interval{get_level_change_min_interval(device_config)},
+      level_change_min_percentage_delta{get_level_change_min_percentage_delta(device_config)},
+      event_loop(event_loop),
+      log_tag{log_tag},
+      is_using_battery_power{is_using_battery_power},
+      level_change_timeout{
+          std::make_unique<EventLoopTimeout>(
+              event_loop, [this] { deliver_pending_level_changes(); })},
+      power_source_change_handler{null_handler},
+      power_source_critical_handler{null_handler},
+      power_source_level_change_handler{null_batteryinfo_handler}
+{
+}
+
+repowerd::BatteryTracker::~BatteryTracker() = default;
+
+repowerd::HandlerRegistration repowerd::BatteryTracker::register_power_source_change_handler(
+    PowerSourceChangeHandler const& handler)
+{
+    return EventLoopHandlerRegistration{
+        event_loop,
+            [this, &handler] { this->power_source_change_handler = handler; },
+            [this] { this->power_source_change_handler = null_handler; }};
+}
+
+repowerd::HandlerRegistration repowerd::BatteryTracker::register_power_source_critical_handler(
+    PowerSourceCriticalHandler const& handler)
+{
+    return EventLoopHandlerRegistration{
+        event_loop,
+            [this, &handler] { this->power_source_critical_handler = handler; },
+            [this] { this->power_source_critical_handler = null_handler; }};
+}
+
+repowerd::HandlerRegistration repowerd::BatteryTracker::register_power_source_level_change_handler(
+    PowerSourceLevelChangeHandler const& handler)
+{
+    return EventLoopHandlerRegistration{
+        event_loop,
+            [this, &handler] { this->power_source_level_change_handler = handler; },
+            [this] { this->power_source_level_change_handler = null_batteryinfo_handler; }};
+}
+
+std::unordered_map<std::string,repowerd::BatteryInfo> const&
+repowerd::BatteryTracker::batteries() const
+{
+    return batteries_;
+}
+
+void repowerd::BatteryTracker::add_battery(
+    std::string const& name, BatteryInfo const& battery_info)
+{
+    batteries_[name] = battery_info;
+    power_source_change_handler();
+    deliver_level_change(name, std::chrono::steady_clock::now());
+}
+
+void repowerd::BatteryTracker::remove_battery(std::string const& name)
+{
+    batteries_.erase(name);
+    level_changes.erase(name);
+}
+
+void repowerd::BatteryTracker::update_battery(
+    std::string const& name, BatteryInfo const& new_info)
+{
+    auto const old_info = batteries_[name];
+
+    log->log(log_tag, "update_battery(%s), "
+             "is_present=%d, state=%d, percentage=%.2f, temperature=%.2f",
+             name.c_str(),
+             new_info.is_present,
+             new_info.state,
+             new_info.percentage,
+             new_info.temperature);
+
+    batteries_[name] = new_info;
+
+    bool critical{false};
+    bool change{false};
+
+    if (old_info.is_present != new_info.is_present)
+    {
+        change = true;
+    }
+
+    if (new_info.is_present && old_info.state != new_info.state)
+    {
+        if (is_state(new_info.state, BatteryState::discharging) ||
+            (is_state(old_info.state, BatteryState::discharging) &&
+             (is_state(new_info.state, BatteryState::charging) ||
+              is_state(new_info.state, BatteryState::fully_charged) ||
+              is_state(new_info.state, BatteryState::pending_charge))))
+        {
+            change = true;
+        }
+    }
+
+    if (new_info.is_present && old_info.percentage != new_info.percentage)
+    {
+        if (new_info.percentage <= 1.0 && is_using_battery_power())
+        {
+            log->log(log_tag, "Battery energy percentage is at critical level %.1f%%\n",
+                     new_info.percentage);
+            critical = true;
+        }
+    }
+
+    if (new_info.is_present && old_info.temperature != new_info.temperature)
+    {
+        if (new_info.temperature >= critical_temperature)
+        {
+            log->log(log_tag, "Battery temperature is at critical level %.1f (limit is %.1f)\n",
+                     new_info.temperature, critical_temperature);
+            critical = true;
+        }
+    }
+
+    if (critical || change)
+    {
+        temporary_suspend_inhibition->inhibit_suspend_for(
+            std::chrono::seconds{2}, log_tag);
+    }
+
+    if (critical)
+        power_source_critical_handler();
+
+    if (change)
+        power_source_change_handler();
+
+    // State transitions and critical levels are always delivered right
+    // away, only plain level changes are coalesced
+    auto const urgent =
+        critical ||
+        old_info.state != new_info.state ||
+        old_info.is_present != new_info.is_present;
+
+    notify_level_change(name, urgent);
+}
+
+void repowerd::BatteryTracker::notify_level_change(
+    std::string const& name, bool urgent)
+{
+    auto const now = std::chrono::steady_clock::now();
+    auto const iter = level_changes.find(name);
+
+    if (urgent || iter == level_changes.end())
+    {
+        deliver_level_change(name, now);
+        return;
+    }
+
+    auto& level_change = iter->second;
+    auto const percentage_delta = std::abs(
+        batteries_[name].percentage - level_change.battery_info.percentage);
+
+    // Changes that don't move the level enough, e.g., temperature jitter,
+    // are dropped, and cancel any change still waiting to be delivered
+    if (percentage_delta < level_change_min_percentage_delta)
+    {
+        level_change.pending = false;
+    }
+    else if (now >= level_change.time + level_change_min_interval)
+    {
+        deliver_level_change(name, now);
+    }
+    else
+    {
+        level_change.pending = true;
+        arm_level_change_timeout(now);
+    }
+}
+
+void repowerd::BatteryTracker::deliver_level_change(
+    std::string const& name, std::chrono::steady_clock::time_point now)
+{
+    auto& battery_info = batteries_[name];
+    level_changes[name] = LevelChangeNotification{battery_info, now, false};
+
+    power_source_level_change_handler(&battery_info);
+}
+
+void repowerd::BatteryTracker::deliver_pending_level_changes()
+{
+    auto const now = std::chrono::steady_clock::now();
+
+    for (auto const& level_change : level_changes)
+    {
+        if (level_change.second.pending &&
+            now >= level_change.second.time + level_change_min_interval)
+        {
+            deliver_level_change(level_change.first, now);
+        }
+    }
+
+    arm_level_change_timeout(now);
+}
+
+void repowerd::BatteryTracker::arm_level_change_timeout(
+    std::chrono::steady_clock::time_point now)
+{
+    auto next_time = std::chrono::steady_clock::time_point::max();
+
+    for (auto const& level_change : level_changes)
+    {
+        if (level_change.second.pending)
+            next_time = std::min(next_time, level_change.second.time + level_change_min_interval);
+    }
+
+    if (next_time != std::chrono::steady_clock::time_point::max())
+        level_change_timeout->arm_in(next_time - now);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include "src/core/power_source.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace repowerd
+{
+class DeviceConfig;
+class EventLoop;
+class Log;
+class TemporarySuspendInhibition;
+class Timeout;
+
+// Battery states, using the same values as UPower
+enum class BatteryState : uint32_t
+{
+    unknown = 0,
+    charging,
+    discharging,
+    empty,
+    fully_charged,
+    pending_charge,
+    pending_discharge
+};
+
+// Turns battery updates from a power source into change, critical and
+// level change notifications, coalescing level changes that arrive faster
+// than batteryLevelChangeMinIntervalMs. Apart from the handler
+// registrations, all calls must be made in the event loop thread, and the
+// tracker should be destroyed in that thread or after the loop has stopped.
+class BatteryTracker
+{
+public:
+    BatteryTracker(
+        std::shared_ptr<Log> const& log,
+        std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
+        DeviceConfig const& device_config,
+        EventLoop& event_loop,
+        char const* log_tag,
+        std::function<bool()> const& is_using_battery_power);
+    ~BatteryTracker();
+
+    HandlerRegistration register_power_source_change_handler(
+        PowerSourceChangeHandler const& handler);
+
+    HandlerRegistration register_power_source_critical_handler(
+        PowerSourceCriticalHandler const& handler);
+
+    HandlerRegistration register_power_source_level_change_handler(
+        PowerSourceLevelChangeHandler const& handler);
+
+    std::unordered_map<std::string,BatteryInfo> const& batteries() const;
+    void add_battery(std::string const& name, BatteryInfo const& battery_info);
+    void remove_battery(std::string const& name);
+    void update_battery(std::string const& name, BatteryInfo const& new_info);
+
+private:
+    struct LevelChangeNotification
+    {
+        BatteryInfo battery_info;
+        std::chrono::steady_clock::time_point time;
+        bool pending;
+    };
+
+    void notify_level_change(std::string const& name, bool urgent);
+    void deliver_level_change(
+        std::string const& name, std::chrono::steady_clock::time_point now);
+    void deliver_pending_level_changes();
+    void arm_level_change_timeout(std::chrono::steady_clock::time_point now);
+
+    std::shared_ptr<Log> const log;
+    std::shared_ptr<TemporarySuspendInhibition> const temporary_suspend_inhibition;
+    double const critical_temperature;
+    std::chrono::milliseconds const level_change_min_interval;
+    double const level_change_min_percentage_delta;
+    EventLoop& event_loop;
+    char const* const log_tag;
+    std::function<bool()> const is_using_battery_power;
+    std::unique_ptr<Timeout> const level_change_timeout;
+
+    PowerSourceChangeHandler power_source_change_handler;
+    PowerSourceCriticalHandler power_source_critical_handler;
+    PowerSourceLevelChangeHandler power_source_level_change_handler;
+
+    std::unordered_map<std::string,BatteryInfo> batteries_;
+    // The last level change delivered for each battery
+    std::unordered_map<std::string,LevelChangeNotification> level_changes;
+};
+
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "brightness_animation.h"
+
+#include <algorithm>
+
+std::chrono::microseconds constexpr repowerd::BrightnessAnimation::min_frame_interval;
+
+namespace
+{
+
+int calculate_num_frames(std::chrono::microseconds duration, int raw_levels_crossed)
+{
+    auto const max_frames = static_cast<int>(
+        duration / repowerd::BrightnessAnimation::min_frame_interval);
+
+    return std::max(1, std::min(raw_levels_crossed, max_frames));
+}
+
+double ease(repowerd::BrightnessEasing easing, double t)
+{
+    switch (easing)
+    {
+    case repowerd::BrightnessEasing::ease_in_out:
+        return t * t * (3.0 - 2.0 * t);
+    case repowerd::BrightnessEasing::ease_out:
+        return 1.0 - (1.0 - t) * (1.0 - t);
+    case repowerd::BrightnessEasing::linear:
+    default:
+        return t;
+    }
+}
+
+}
+
+repowerd::BrightnessEasing repowerd::brightness_easing_from_string(
+    std::string const& str, BrightnessEasing default_easing)
+{
+    if (str == "linear")
+        return BrightnessEasing::linear;
+    else if (str == "ease_in_out")
+        return BrightnessEasing::ease_in_out;
+    else if (str == "ease_out")
+        return BrightnessEasing::ease_out;
+    else
+        return default_easing;
+}
+
+repowerd::BrightnessAnimation::BrightnessAnimation(
+    double from,
+    double to,
+    std::chrono::microseconds duration,
+    int raw_levels_crossed,
+    BrightnessEasing easing)
+    : from_{from},
+      to_{to},
+      duration_{duration},
+      easing{easing},
+      num_frames_{calculate_num_frames(duration, raw_levels_crossed)}
+{
+}
+
+double repowerd::BrightnessAnimation::from() const
+{
+    return from_;
+}
+
+double repowerd::BrightnessAnimation::to() const
+{
+    return to_;
+}
+
+std::chrono::microseconds repowerd::BrightnessAnimation::duration() const
+{
+    return duration_;
+}
+
+int repowerd::BrightnessAnimation::num_frames() const
+{
+    return num_frames_;
+}
+
+std::chrono::microseconds repowerd::BrightnessAnimation::frame_interval() const
+{
+    return duration_ / num_frames_;
+}
+
+std::chrono::microseconds repowerd::BrightnessAnimation::frame_time(int frame) const
+{
+    return duration_ * frame / num_frames_;
+}
+
+double repowerd::BrightnessAnimation::frame_value(int frame) const
+{
+    if (frame >= num_frames_ - 1)
+        return to_;
+
+    auto const t = static_cast<double>(frame + 1) / num_frames_;
+    return from_ + (to_ - from_) * ease(easing, t);
+}
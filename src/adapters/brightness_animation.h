@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace repowerd
+{
+
+enum class BrightnessEasing { linear, ease_in_out, ease_out };
+
+// Parses "linear", "ease_in_out" or "ease_out", returning default_easing
+// for any other value
+BrightnessEasing brightness_easing_from_string(
+    std::string const& str, BrightnessEasing default_easing);
+
+// A brightness ramp split into evenly spaced frames. There is a frame for
+// each raw backlight level the ramp crosses, so that frames change the
+// panel brightness, but frames are never closer than min_frame_interval.
+// The first frame is shown at the start of the animation, and the
+// animation lasts one frame interval after the last one.
+class BrightnessAnimation
+{
+public:
+    static std::chrono::microseconds constexpr min_frame_interval{1000};
+
+    BrightnessAnimation(
+        double from,
+        double to,
+        std::chrono::microseconds duration,
+        int raw_levels_crossed,
+        BrightnessEasing easing);
+
+    double from() const;
+    double to() const;
+    std::chrono::microseconds duration() const;
+    int num_frames() const;
+    std::chrono::microseconds frame_interval() const;
+
+    // Frames are numbered from 0 to num_frames() - 1. The time is relative
+    // to the start of the animation, and the last frame has exactly the
+    // target brightness.
+    std::chrono::microseconds frame_time(int frame) const;
+    double frame_value(int frame) const;
+
+private:
+    double const from_;
+    double const to_;
+    std::chrono::microseconds const duration_;
+    BrightnessEasing const easing;
+    int const num_frames_;
+};
+
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "brightness_curve.h"
+#include "brightness_params.h"
+#include "device_config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace
+{
+
+// Enough entries for at least one per raw level where the steepest
+// supported curve changes fastest
+int const raw_level_lut_entries_per_level = 4;
+
+repowerd::BrightnessCurve::Type curve_type_from_string(std::string const& str)
+{
+    if (str == "gamma")
+        return repowerd::BrightnessCurve::Type::gamma;
+    else if (str == "cie_lightness")
+        return repowerd::BrightnessCurve::Type::cie_lightness;
+    else
+        return repowerd::BrightnessCurve::Type::linear;
+}
+
+double string_to_double(std::string const& value, double default_value)
+{
+    try { return std::stod(value); }
+    catch (...) { return default_value; }
+}
+
+double curve_gamma(repowerd::DeviceConfig const& device_config)
+{
+    auto const default_gamma = 2.2;
+    auto const gamma = string_to_double(
+        device_config.get("brightnessCurveGamma", "2.2"), default_gamma);
+
+    // pow(t, 1 / gamma) is meaningless for these, and they would fill
+    // the lookup tables with NaN
+    if (!std::isfinite(gamma) || gamma <= 0.0)
+        return default_gamma;
+
+    return gamma;
+}
+
+// Light output, from 0 to 1, for perceived brightness from 0 to 1
+double light_for(repowerd::BrightnessCurve::Type type, double gamma, double t)
+{
+    switch (type)
+    {
+    case repowerd::BrightnessCurve::Type::gamma:
+        return std::pow(t, gamma);
+    case repowerd::BrightnessCurve::Type::cie_lightness:
+    {
+        auto const lightness = 100.0 * t;
+        if (lightness > 8.0)
+            return std::pow((lightness + 16.0) / 116.0, 3.0);
+        else
+            return lightness / 903.3;
+    }
+    case repowerd::BrightnessCurve::Type::linear:
+    default:
+        return t;
+    }
+}
+
+double perceived_for(repowerd::BrightnessCurve::Type type, double gamma, double y)
+{
+    switch (type)
+    {
+    case repowerd::BrightnessCurve::Type::gamma:
+        return std::pow(y, 1.0 / gamma);
+    case repowerd::BrightnessCurve::Type::cie_lightness:
+    {
+        auto const lightness = y > 0.008856 ?
+            116.0 * std::cbrt(y) - 16.0 : 903.3 * y;
+        return lightness / 100.0;
+    }
+    case repowerd::BrightnessCurve::Type::linear:
+    default:
+        return y;
+    }
+}
+
+}
+
+repowerd::BrightnessCurve repowerd::BrightnessCurve::from_device_config(
+    DeviceConfig const& device_config, int max_raw_brightness)
+{
+    return BrightnessCurve{
+        curve_type_from_string(device_config.get("brightnessCurve", "linear")),
+        curve_gamma(device_config),
+        BrightnessParams::from_device_config(device_config),
+        max_raw_brightness};
+}
+
+repowerd::BrightnessCurve::BrightnessCurve(
+    Type type,
+    double gamma,
+    BrightnessParams const& brightness_params,
+    int max_raw_brightness)
+    : type_{type},
+      max_raw_brightness{std::max(max_raw_brightness, 1)},
+      brightness_levels{std::max(brightness_params.max_value, 1)}
+{
+    if (type_ == Type::linear)
+        return;
+
+    auto const min = brightness_params.max_value > 0 ?
+        std::min(std::max(static_cast<double>(brightness_params.min_value) /
+                          brightness_params.max_value, 0.0), 0.99) :
+        0.0;
+
+    auto const to_backlight_value =
+        [&] (double brightness)
+        {
+            if (brightness <= min) return brightness;
+            auto const t = (brightness - min) / (1.0 - min);
+            return min + (1.0 - min) * light_for(type_, gamma, t);
+        };
+
+    auto const to_brightness =
+        [&] (double backlight_value)
+        {
+            if (backlight_value <= min) return backlight_value;
+            auto const y = (backlight_value - min) / (1.0 - min);
+            return min + (1.0 - min) * perceived_for(type_, gamma, y);
+        };
+
+    auto const lut_size =
+        raw_level_lut_entries_per_level * this->max_raw_brightness + 1;
+    raw_level_lut.reserve(lut_size);
+
+    for (int i = 0; i < lut_size; ++i)
+    {
+        auto const brightness = static_cast<double>(i) / (lut_size - 1);
+        auto const raw = static_cast<int>(
+            std::round(to_backlight_value(brightness) * this->max_raw_brightness));
+        // Never turn the backlight off for non-zero brightness
+        raw_level_lut.push_back(i > 0 ? std::max(raw, 1) : 0);
+    }
+
+    brightness_lut.reserve(this->max_raw_brightness + 1);
+
+    for (int raw = 0; raw <= this->max_raw_brightness; ++raw)
+    {
+        brightness_lut.push_back(
+            to_brightness(static_cast<double>(raw) / this->max_raw_brightness));
+    }
+}
+
+repowerd::BrightnessCurve::Type repowerd::BrightnessCurve::type() const
+{
+    return type_;
+}
+
+double repowerd::BrightnessCurve::backlight_value_for(double brightness) const
+{
+    if (type_ == Type::linear)
+        return brightness;
+
+    return static_cast<double>(raw_level_for(brightness)) / max_raw_brightness;
+}
+
+double repowerd::BrightnessCurve::brightness_for(double backlight_value) const
+{
+    if (type_ == Type::linear)
+        return backlight_value;
+
+    auto const raw = static_cast<int>(std::round(
+        std::min(std::max(backlight_value, 0.0), 1.0) * max_raw_brightness));
+
+    return brightness_lut[raw];
+}
+
+int repowerd::BrightnessCurve::raw_levels_between(
+    double from_brightness, double to_brightness) const
+{
+    if (type_ == Type::linear)
+    {
+        return static_cast<int>(std::ceil(
+            std::fabs(to_brightness - from_brightness) * brightness_levels - 1e-9));
+    }
+
+    return std::abs(raw_level_for(to_brightness) - raw_level_for(from_brightness));
+}
+
+int repowerd::BrightnessCurve::raw_level_for(double brightness) const
+{
+    auto const clamped = std::min(std::max(brightness, 0.0), 1.0);
+    auto const index = static_cast<size_t>(
+        std::round(clamped * (raw_level_lut.size() - 1)));
+
+    return raw_level_lut[index];
+}
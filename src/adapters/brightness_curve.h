@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace repowerd
+{
+
+class DeviceConfig;
+struct BrightnessParams;
+
+// Maps user-facing brightness values, which are perceptually uniform for
+// non-linear curves, to backlight values, which are linear in light
+// output, through lookup tables precomputed for the raw levels of the
+// backlight. The brightness range below the minimum brightness setting
+// stays linear, so the darkest brightness values users can choose don't
+// change physically.
+class BrightnessCurve
+{
+public:
+    enum class Type {linear, gamma, cie_lightness};
+
+    // Uses the brightnessCurve ("linear", "gamma" or "cie_lightness")
+    // and brightnessCurveGamma device config values
+    static BrightnessCurve from_device_config(
+        DeviceConfig const& device_config, int max_raw_brightness);
+
+    BrightnessCurve(
+        Type type,
+        double gamma,
+        BrightnessParams const& brightness_params,
+        int max_raw_brightness);
+
+    Type type() const;
+
+    double backlight_value_for(double brightness) const;
+    double brightness_for(double backlight_value) const;
+    // The number of raw backlight levels a brightness change crosses. For
+    // linear curves this counts brightness setting levels instead, as
+    // transitions always have.
+    int raw_levels_between(double from_brightness, double to_brightness) const;
+
+private:
+    int raw_level_for(double brightness) const;
+
+    Type const type_;
+    int const max_raw_brightness;
+    int const brightness_levels;
+    // Raw level for evenly spaced brightness values, and brightness value
+    // for each raw level. Empty for linear curves.
+    std::vector<int> raw_level_lut;
+    std::vector<double> brightness_lut;
+};
+
+}
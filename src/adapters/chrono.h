@@ -18,17 +18,29 @@
 
 #pragma once
 
+#include "timeout.h"
+
 #include <chrono>
+#include <functional>
+#include <memory>
 
 namespace repowerd
 {
 
+class EventLoop;
+
 class Chrono
 {
 public:
     virtual ~Chrono() = default;
 
     virtual void sleep_for(std::chrono::nanoseconds t) = 0;
+    virtual std::chrono::steady_clock::time_point steady_now() = 0;
+    // Creates a disarmed timeout that runs the callback in the event loop
+    // thread whenever it expires
+    virtual std::unique_ptr<Timeout> create_timeout(
+        EventLoop& event_loop,
+        std::function<void()> const& callback) = 0;
 
 protected:
     Chrono() = default;
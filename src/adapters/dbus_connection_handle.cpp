@@ -19,13 +19,18 @@
 #include "dbus_connection_handle.h"
 #include "scoped_g_error.h"
 
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
 
-repowerd::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
+namespace
+{
+
+std::shared_ptr<GDBusConnection> connect_to_bus(std::string const& address)
 {
     repowerd::ScopedGError error;
 
-    connection = g_dbus_connection_new_for_address_sync(
+    auto const connection = g_dbus_connection_new_for_address_sync(
         address.c_str(),
         GDBusConnectionFlags(
             G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION |
@@ -40,11 +45,49 @@ repowerd::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
             "Failed to connect to DBus bus with address '" +
                 address + "': " + error.message_str());
     }
+
+    return {
+        connection,
+        [] (GDBusConnection* connection)
+        {
+            g_dbus_connection_close_sync(connection, nullptr, nullptr);
+            g_object_unref(connection);
+        }};
+}
+
+std::mutex shared_connections_mutex;
+std::unordered_map<std::string,std::weak_ptr<GDBusConnection>> shared_connections;
+
+}
+
+repowerd::DBusConnectionHandle::DBusConnectionHandle(std::string const& address)
+    : connection{connect_to_bus(address)}
+{
 }
 
-repowerd::DBusConnectionHandle::~DBusConnectionHandle()
+repowerd::DBusConnectionHandle::DBusConnectionHandle(
+    std::shared_ptr<GDBusConnection> const& connection)
+    : connection{connection}
 {
-    g_dbus_connection_close_sync(connection, nullptr, nullptr);
+}
+
+repowerd::DBusConnectionHandle repowerd::DBusConnectionHandle::shared(
+    std::string const& address)
+{
+    // Connect while holding the lock, so that concurrent users of a new
+    // address wait for a single connection instead of racing to make one
+    std::lock_guard<std::mutex> lock{shared_connections_mutex};
+
+    auto& shared_connection = shared_connections[address];
+    auto connection = shared_connection.lock();
+
+    if (!connection)
+    {
+        connection = connect_to_bus(address);
+        shared_connection = connection;
+    }
+
+    return DBusConnectionHandle{connection};
 }
 
 void repowerd::DBusConnectionHandle::request_name(char const* name) const
@@ -57,7 +100,7 @@ void repowerd::DBusConnectionHandle::request_name(char const* name) const
     auto const null_cancellable = nullptr;
 
     auto result = g_dbus_connection_call_sync(
-        connection,
+        connection.get(),
         "org.freedesktop.DBus",
         "/org/freedesktop/DBus",
         "org.freedesktop.DBus",
@@ -91,5 +134,5 @@ void repowerd::DBusConnectionHandle::request_name(char const* name) const
 
 repowerd::DBusConnectionHandle::operator GDBusConnection*() const
 {
-    return connection;
+    return connection.get();
 }
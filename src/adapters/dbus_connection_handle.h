@@ -20,6 +20,7 @@
 
 #include <gio/gio.h>
 
+#include <memory>
 #include <string>
 
 namespace repowerd
@@ -28,18 +29,28 @@ namespace repowerd
 class DBusConnectionHandle
 {
 public:
+    // Opens a private connection to the bus at the address
     DBusConnectionHandle(std::string const& address);
-    ~DBusConnectionHandle();
+    DBusConnectionHandle(DBusConnectionHandle&&) = default;
+
+    // Returns a handle to a connection to the bus at the address, which is
+    // shared by all handles returned by this function for the same
+    // address. The connection is opened along with the first handle, and
+    // is closed when the last handle goes away. Since the connection may
+    // outlive the handle, objects and signal subscriptions registered
+    // through it need to be unregistered explicitly.
+    static DBusConnectionHandle shared(std::string const& address);
 
     void request_name(char const* name) const;
 
     operator GDBusConnection*() const;
 
 private:
+    DBusConnectionHandle(std::shared_ptr<GDBusConnection> const& connection);
     DBusConnectionHandle(DBusConnectionHandle const&) = delete;
     DBusConnectionHandle& operator=(DBusConnectionHandle const&) = delete;
 
-    GDBusConnection* connection;
+    std::shared_ptr<GDBusConnection> connection;
 };
 
 }
@@ -20,6 +20,9 @@
 #include "event_loop_handler_registration.h"
 #include "scoped_g_error.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace
 {
 
@@ -49,6 +52,43 @@ void repowerd_g_dbus_connection_wait_for_requests(GDBusConnection* connection)
     g_variant_unref(result);
 }
 
+// Registration batches of the calling thread. The connections of all
+// adapters are usually shared, so the registrations made while starting
+// the daemon end up needing a single wait.
+struct RegistrationBatches
+{
+    int open_batches{0};
+    std::vector<GDBusConnection*> connections;
+};
+
+thread_local RegistrationBatches registration_batches;
+
+}
+
+repowerd::DBusEventLoop::RegistrationBatch::RegistrationBatch()
+    : finished{false}
+{
+    ++registration_batches.open_batches;
+}
+
+repowerd::DBusEventLoop::RegistrationBatch::~RegistrationBatch()
+{
+    finish();
+}
+
+void repowerd::DBusEventLoop::RegistrationBatch::finish()
+{
+    if (finished) return;
+    finished = true;
+
+    // Only the outermost batch waits, and covers nested ones
+    if (--registration_batches.open_batches > 0) return;
+
+    std::vector<GDBusConnection*> connections;
+    connections.swap(registration_batches.connections);
+
+    for (auto const connection : connections)
+        repowerd_g_dbus_connection_wait_for_requests(connection);
 }
 
 repowerd::HandlerRegistration repowerd::DBusEventLoop::register_object_handler(
@@ -115,7 +155,7 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_object_handler(
     // g_dbus_connection_register_object() is not synchronous, so wait for
     // the registration (really a DBus AddMatch request) to be processed
     // by the server
-    repowerd_g_dbus_connection_wait_for_requests(dbus_connection);
+    wait_for_registration(dbus_connection);
 
     return EventLoopHandlerRegistration(
         *this,
@@ -177,7 +217,7 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_signal_handler(
     // g_dbus_connection_signal_subscribe() is not synchronous, so wait for
     // the subscription (really a DBus AddMatch request) to be processed
     // by the server
-    repowerd_g_dbus_connection_wait_for_requests(dbus_connection);
+    wait_for_registration(dbus_connection);
 
     return EventLoopHandlerRegistration(
         *this,
@@ -188,3 +228,21 @@ repowerd::HandlerRegistration repowerd::DBusEventLoop::register_signal_handler(
                 registration_id);
         });
 }
+
+void repowerd::DBusEventLoop::wait_for_registration(GDBusConnection* dbus_connection)
+{
+    if (registration_batches.open_batches > 0)
+    {
+        // The bus daemon handles the requests of a connection in order,
+        // so a single wait at the end of the batch covers them all
+        auto& connections = registration_batches.connections;
+        if (std::find(connections.begin(), connections.end(),
+                      dbus_connection) == connections.end())
+        {
+            connections.push_back(dbus_connection);
+        }
+        return;
+    }
+
+    repowerd_g_dbus_connection_wait_for_requests(dbus_connection);
+}
@@ -50,6 +50,29 @@ using DBusEventLoopSignalHandler =
 class DBusEventLoop : public EventLoop
 {
 public:
+    using EventLoop::EventLoop;
+
+    // Object and signal registrations normally wait for the bus daemon to
+    // process them before returning, which takes a round trip each. While
+    // a batch is open, registrations made by the same thread, through any
+    // DBusEventLoop, return without waiting, and finishing the outermost
+    // batch waits once for all of them on every connection used. Batches
+    // must be finished by the thread that opened them.
+    class RegistrationBatch
+    {
+    public:
+        RegistrationBatch();
+        ~RegistrationBatch();
+
+        void finish();
+
+    private:
+        RegistrationBatch(RegistrationBatch const&) = delete;
+        RegistrationBatch& operator=(RegistrationBatch const&) = delete;
+
+        bool finished;
+    };
+
     repowerd::HandlerRegistration register_object_handler(
         GDBusConnection* dbus_connection,
         char const* dbus_path,
@@ -63,6 +86,9 @@ public:
         char const* dbus_member,
         char const* dbus_path,
         DBusEventLoopSignalHandler const& handler);
+
+private:
+    void wait_for_registration(GDBusConnection* dbus_connection);
 };
 
 }
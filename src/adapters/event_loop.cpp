@@ -17,10 +17,25 @@
  */
 
 #include "event_loop.h"
+#include "event_loop_reactor.h"
+
+#include <algorithm>
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace
 {
 
+int create_wakeup_fd()
+{
+    auto const fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to create eventfd"};
+    return fd;
+}
+
 struct GSourceContext
 {
     GSourceContext(std::function<void()> const& callback)
@@ -49,16 +64,70 @@ struct GSourceContext
 
 }
 
+struct repowerd::EventLoop::Callback
+{
+    std::function<void()> func;
+    // Only set for enqueued callbacks, posted callbacks have no future
+    std::unique_ptr<std::promise<void>> done;
+    Callback* next;
+};
+
+struct repowerd::EventLoop::CallbackSource
+{
+    GSource gsource;
+    EventLoop* event_loop;
+};
+
 repowerd::EventLoop::EventLoop()
-    : main_context{g_main_context_new()},
-      main_loop{g_main_loop_new(main_context, FALSE)}
+    : EventLoop{nullptr}
 {
-    loop_thread = std::thread{
-        [this]
-        {
-            g_main_context_push_thread_default(main_context);
-            g_main_loop_run(main_loop);
-        }};
+}
+
+repowerd::EventLoop::EventLoop(std::shared_ptr<EventLoopReactor> const& reactor)
+    : main_context{nullptr},
+      main_loop{nullptr},
+      pending_callbacks{nullptr},
+      wakeup_fd{create_wakeup_fd()},
+      reactor{reactor},
+      running{false},
+      running_callbacks{false},
+      shared_sources_prune_size{16}
+{
+    if (reactor)
+    {
+        auto const thread = reactor->next_thread();
+        main_context = g_main_context_ref(thread.main_context);
+        loop_thread_id = thread.thread_id;
+    }
+    else
+    {
+        main_context = g_main_context_new();
+        main_loop = g_main_loop_new(main_context, FALSE);
+    }
+
+    static GSourceFuncs callback_source_funcs{
+        nullptr, nullptr, &EventLoop::static_dispatch, nullptr, nullptr, nullptr};
+
+    callback_source = g_source_new(&callback_source_funcs, sizeof(CallbackSource));
+    reinterpret_cast<CallbackSource*>(callback_source)->event_loop = this;
+    // Use the same priority idle sources have, so that callbacks keep
+    // running after any pending higher priority events
+    g_source_set_priority(callback_source, G_PRIORITY_DEFAULT_IDLE);
+    g_source_add_unix_fd(callback_source, wakeup_fd, G_IO_IN);
+    g_source_attach(callback_source, main_context);
+
+    if (!reactor)
+    {
+        loop_thread = std::thread{
+            [this]
+            {
+                g_main_context_push_thread_default(main_context);
+                g_main_loop_run(main_loop);
+            }};
+        loop_thread_id = loop_thread.get_id();
+    }
+
+    running = true;
 
     enqueue([]{}).wait();
 }
@@ -66,14 +135,39 @@ repowerd::EventLoop::EventLoop()
 repowerd::EventLoop::~EventLoop()
 {
     stop();
+
+    // Drop callbacks that never got to run, breaking their promises
+    auto callback = pending_callbacks.exchange(nullptr);
+    while (callback)
+    {
+        auto const next = callback->next;
+        delete callback;
+        callback = next;
+    }
+
+    close(wakeup_fd);
 }
 
 void repowerd::EventLoop::stop()
 {
+    if (reactor)
+    {
+        stop_shared();
+        return;
+    }
+
+    running = false;
+
     if (main_loop)
         g_main_loop_quit(main_loop);
     if (loop_thread.joinable())
         loop_thread.join();
+    if (callback_source)
+    {
+        g_source_destroy(callback_source);
+        g_source_unref(callback_source);
+        callback_source = nullptr;
+    }
     if (main_loop)
     {
         g_main_loop_unref(main_loop);
@@ -88,22 +182,39 @@ void repowerd::EventLoop::stop()
 
 std::future<void> repowerd::EventLoop::enqueue(std::function<void()> const& callback)
 {
-    auto const gsource = g_idle_source_new();
-    auto const ctx = new GSourceContext{callback};
-    g_source_set_callback(
-            gsource,
-            reinterpret_cast<GSourceFunc>(&GSourceContext::static_call),
-            ctx,
-            reinterpret_cast<GDestroyNotify>(&GSourceContext::static_destroy));
+    if (reactor && running && !running_callbacks &&
+        std::this_thread::get_id() == loop_thread_id)
+    {
+        // Another loop sharing this thread is waiting for us, so run the
+        // callback now, after the ones that were enqueued before it
+        run_pending_callbacks();
 
-    auto future = ctx->done.get_future();
+        std::promise<void> done;
+        try
+        {
+            callback();
+            done.set_value();
+        }
+        catch (...)
+        {
+            done.set_exception(std::current_exception());
+        }
+        return done.get_future();
+    }
 
-    g_source_attach(gsource, main_context);
-    g_source_unref(gsource);
+    auto const cb = new Callback{callback, std::make_unique<std::promise<void>>(), nullptr};
+    auto future = cb->done->get_future();
+
+    push_callback(cb);
 
     return future;
 }
 
+void repowerd::EventLoop::post(std::function<void()> const& callback)
+{
+    push_callback(new Callback{callback, nullptr, nullptr});
+}
+
 std::future<void> repowerd::EventLoop::schedule_in(
     std::chrono::milliseconds timeout,
     std::function<void()> const& callback)
@@ -118,7 +229,7 @@ std::future<void> repowerd::EventLoop::schedule_in(
 
     auto future = ctx->done.get_future();
 
-    g_source_attach(gsource, main_context);
+    attach_source(gsource);
     g_source_unref(gsource);
 
     return future;
@@ -144,11 +255,185 @@ void repowerd::EventLoop::schedule_with_cancellation_in(
             g_source_unref(gsource);
         };
 
-    enqueue(
+    post(
         [cancellation, cancellation_ready]
         {
             cancellation_ready(cancellation);
         });
 
+    attach_source(gsource);
+}
+
+void repowerd::EventLoop::watch_fd(int fd, std::function<void()> const& handler)
+{
+    static GSourceFuncs fd_source_funcs{
+        nullptr,
+        nullptr,
+        [] (GSource*, GSourceFunc callback, gpointer user_data)
+        {
+            return callback(user_data);
+        },
+        nullptr, nullptr, nullptr};
+
+    auto const gsource = g_source_new(&fd_source_funcs, sizeof(GSource));
+    g_source_set_callback(
+        gsource,
+        [] (gpointer user_data) -> gboolean
+        {
+            try
+            {
+                (*static_cast<std::function<void()>*>(user_data))();
+            }
+            catch (...)
+            {
+            }
+            return G_SOURCE_CONTINUE;
+        },
+        new std::function<void()>{handler},
+        [] (gpointer user_data) { delete static_cast<std::function<void()>*>(user_data); });
+    g_source_add_unix_fd(gsource, fd, G_IO_IN);
+    attach_source(gsource);
+    g_source_unref(gsource);
+}
+
+void repowerd::EventLoop::attach_source(GSource* gsource)
+{
+    if (reactor)
+    {
+        std::lock_guard<std::mutex> lock{shared_sources_mutex};
+
+        if (!running)
+            return;
+
+        // Sources that have fired or have been cancelled are destroyed,
+        // drop them once in a while so that the list doesn't keep growing
+        if (shared_sources.size() >= shared_sources_prune_size)
+        {
+            auto const destroyed = std::partition(
+                shared_sources.begin(), shared_sources.end(),
+                [] (GSource* s) { return !g_source_is_destroyed(s); });
+            std::for_each(destroyed, shared_sources.end(), g_source_unref);
+            shared_sources.erase(destroyed, shared_sources.end());
+            shared_sources_prune_size = std::max<size_t>(16, 2 * shared_sources.size());
+        }
+
+        shared_sources.push_back(g_source_ref(gsource));
+    }
+
     g_source_attach(gsource, main_context);
 }
+
+void repowerd::EventLoop::stop_shared()
+{
+    std::vector<GSource*> sources;
+
+    {
+        std::lock_guard<std::mutex> lock{shared_sources_mutex};
+        if (!running)
+            return;
+        running = false;
+        sources.swap(shared_sources);
+    }
+
+    g_source_destroy(callback_source);
+    g_source_unref(callback_source);
+    callback_source = nullptr;
+
+    for (auto const gsource : sources)
+    {
+        g_source_destroy(gsource);
+        g_source_unref(gsource);
+    }
+
+    // Destroyed sources are not dispatched again, but one may be running
+    // in the reactor thread right now, so wait for the thread to get
+    // through a dispatch of its own before letting the loop go away
+    if (std::this_thread::get_id() != loop_thread_id)
+    {
+        auto const gsource = g_idle_source_new();
+        auto const ctx = new GSourceContext{[]{}};
+        g_source_set_priority(gsource, G_PRIORITY_HIGH);
+        g_source_set_callback(
+                gsource,
+                reinterpret_cast<GSourceFunc>(&GSourceContext::static_call),
+                ctx,
+                reinterpret_cast<GDestroyNotify>(&GSourceContext::static_destroy));
+        auto done = ctx->done.get_future();
+        g_source_attach(gsource, main_context);
+        g_source_unref(gsource);
+        done.wait();
+    }
+
+    g_main_context_unref(main_context);
+    main_context = nullptr;
+}
+
+void repowerd::EventLoop::push_callback(Callback* callback)
+{
+    auto head = pending_callbacks.load(std::memory_order_relaxed);
+    do
+    {
+        callback->next = head;
+    }
+    while (!pending_callbacks.compare_exchange_weak(
+            head, callback, std::memory_order_release, std::memory_order_relaxed));
+
+    // Only the first callback of a batch needs to wake up the loop, later
+    // ones are picked up by the same dispatch
+    if (!head)
+    {
+        uint64_t const one{1};
+        while (write(wakeup_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+            continue;
+    }
+}
+
+void repowerd::EventLoop::run_pending_callbacks()
+{
+    // Clear the wakeup before taking the pending callbacks, so that a
+    // callback pushed after the exchange below always causes a new wakeup
+    uint64_t value;
+    while (read(wakeup_fd, &value, sizeof(value)) < 0 && errno == EINTR)
+        continue;
+
+    auto callback = pending_callbacks.exchange(nullptr, std::memory_order_acquire);
+
+    // The stack holds the newest callback first, reverse it to run the
+    // callbacks in the order they were pushed
+    Callback* in_order{nullptr};
+    while (callback)
+    {
+        auto const next = callback->next;
+        callback->next = in_order;
+        in_order = callback;
+        callback = next;
+    }
+
+    running_callbacks = true;
+
+    while (in_order)
+    {
+        std::unique_ptr<Callback> const current{in_order};
+        in_order = in_order->next;
+
+        try
+        {
+            current->func();
+            if (current->done)
+                current->done->set_value();
+        }
+        catch (...)
+        {
+            if (current->done)
+                current->done->set_exception(std::current_exception());
+        }
+    }
+
+    running_callbacks = false;
+}
+
+gboolean repowerd::EventLoop::static_dispatch(GSource* gsource, GSourceFunc, gpointer)
+{
+    reinterpret_cast<CallbackSource*>(gsource)->event_loop->run_pending_callbacks();
+    return G_SOURCE_CONTINUE;
+}
@@ -18,26 +18,46 @@
 
 #pragma once
 
+#include <atomic>
 #include <thread>
 #include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <glib.h>
 
 namespace repowerd
 {
 
+class EventLoopReactor;
+
 using EventLoopCancellation = std::function<void()>;
 
 class EventLoop
 {
 public:
+    // Runs the loop in a dedicated thread
     EventLoop();
+    // Runs the loop in a thread of the reactor, or in a dedicated thread
+    // if the reactor is null
+    explicit EventLoop(std::shared_ptr<EventLoopReactor> const& reactor);
     ~EventLoop();
 
     void stop();
 
+    // Runs the callback in the loop thread. Callbacks enqueued or posted
+    // from the same thread run in order, and all callbacks pending when the
+    // loop wakes up are run in a single batch. Callbacks enqueued by another
+    // EventLoop sharing the reactor thread run immediately, after any that
+    // are already pending, since the caller would otherwise deadlock
+    // waiting for them.
     std::future<void> enqueue(std::function<void()> const& callback);
+    // Like enqueue(), but for callers that don't wait for the callback to
+    // run. No future is created, and exceptions thrown by the callback are
+    // discarded.
+    void post(std::function<void()> const& callback);
     std::future<void> schedule_in(
         std::chrono::milliseconds, std::function<void()> const& callback);
 
@@ -46,10 +66,43 @@ public:
         std::function<void()> const& callback,
         std::function<void(EventLoopCancellation const&)> const& cancellation_ready);
 
+    // Calls the handler in the loop thread whenever the fd is readable, for
+    // as long as the loop is running. The handler must consume the data
+    // that made the fd readable.
+    void watch_fd(int fd, std::function<void()> const& handler);
+
 protected:
     std::thread loop_thread;
     GMainContext* main_context;
     GMainLoop* main_loop;
+
+private:
+    friend class EventLoopTimeout;
+
+    struct Callback;
+    struct CallbackSource;
+
+    void attach_source(GSource* gsource);
+    void stop_shared();
+    void push_callback(Callback* callback);
+    void run_pending_callbacks();
+    static gboolean static_dispatch(GSource*, GSourceFunc, gpointer);
+
+    // Lock-free stack of pending callbacks, newest first
+    std::atomic<Callback*> pending_callbacks;
+    int const wakeup_fd;
+    GSource* callback_source;
+
+    std::shared_ptr<EventLoopReactor> const reactor;
+    std::thread::id loop_thread_id;
+    std::atomic<bool> running;
+    // Only accessed from the loop thread
+    bool running_callbacks;
+    // Sources attached to a reactor thread context, which need to be
+    // destroyed explicitly when the loop stops
+    std::mutex shared_sources_mutex;
+    std::vector<GSource*> shared_sources;
+    size_t shared_sources_prune_size;
 };
 
 }
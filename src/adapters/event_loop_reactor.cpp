@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "event_loop_reactor.h"
+
+#include <future>
+#include <stdexcept>
+
+repowerd::EventLoopReactor::EventLoopReactor(int num_threads)
+    : next{0},
+      creator_context{num_threads == 0 ? g_main_context_new() : nullptr},
+      creator_thread_id{std::this_thread::get_id()}
+{
+    if (num_threads < 0)
+        throw std::invalid_argument{"EventLoopReactor needs a non-negative number of threads"};
+
+    for (int i = 0; i < num_threads; ++i)
+    {
+        auto reactor_thread = std::make_unique<ReactorThread>();
+        auto const main_context = g_main_context_new();
+        auto const main_loop = g_main_loop_new(main_context, FALSE);
+
+        reactor_thread->main_context = main_context;
+        reactor_thread->main_loop = main_loop;
+        reactor_thread->thread = std::thread{
+            [main_context, main_loop]
+            {
+                g_main_context_push_thread_default(main_context);
+                g_main_loop_run(main_loop);
+            }};
+
+        // Wait for the loop to start running, so that quitting it can't
+        // happen before it runs
+        std::promise<void> running;
+        auto const gsource = g_idle_source_new();
+        g_source_set_callback(
+            gsource,
+            [] (gpointer user_data) -> gboolean
+            {
+                static_cast<std::promise<void>*>(user_data)->set_value();
+                return G_SOURCE_REMOVE;
+            },
+            &running,
+            nullptr);
+        g_source_attach(gsource, main_context);
+        g_source_unref(gsource);
+        running.get_future().wait();
+
+        threads.push_back(std::move(reactor_thread));
+    }
+}
+
+repowerd::EventLoopReactor::~EventLoopReactor()
+{
+    for (auto const& reactor_thread : threads)
+    {
+        g_main_loop_quit(reactor_thread->main_loop);
+        reactor_thread->thread.join();
+        g_main_loop_unref(reactor_thread->main_loop);
+        g_main_context_unref(reactor_thread->main_context);
+    }
+
+    if (creator_context)
+        g_main_context_unref(creator_context);
+}
+
+repowerd::EventLoopReactor::Thread repowerd::EventLoopReactor::next_thread()
+{
+    if (threads.empty())
+        return {creator_context, creator_thread_id};
+
+    auto const& reactor_thread = threads[next++ % threads.size()];
+    return {reactor_thread->main_context, reactor_thread->thread.get_id()};
+}
+
+int repowerd::EventLoopReactor::num_threads() const
+{
+    return threads.size();
+}
+
+void repowerd::EventLoopReactor::dispatch_pending()
+{
+    if (!creator_context || std::this_thread::get_id() != creator_thread_id)
+        throw std::logic_error{"EventLoopReactor can only be dispatched by its creator"};
+
+    while (g_main_context_iteration(creator_context, FALSE))
+        continue;
+}
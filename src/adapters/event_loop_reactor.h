@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <glib.h>
+
+namespace repowerd
+{
+
+// A fixed number of threads, each running a GMainContext, which EventLoops
+// can share instead of running a thread each. EventLoops are assigned to
+// the threads in a round robin fashion, and the callbacks of all
+// EventLoops assigned to a thread are serialized.
+//
+// A reactor with no threads assigns its EventLoops to the thread that
+// creates it instead, which runs their pending callbacks and sources with
+// dispatch_pending(). This lets single threaded tools drive EventLoop
+// users, e.g., in simulated time.
+class EventLoopReactor
+{
+public:
+    struct Thread
+    {
+        GMainContext* main_context;
+        std::thread::id thread_id;
+    };
+
+    EventLoopReactor(int num_threads);
+    ~EventLoopReactor();
+
+    Thread next_thread();
+    int num_threads() const;
+
+    // Only for reactors without threads, and only from the creating thread
+    void dispatch_pending();
+
+private:
+    EventLoopReactor(EventLoopReactor const&) = delete;
+    EventLoopReactor& operator=(EventLoopReactor const&) = delete;
+
+    struct ReactorThread
+    {
+        GMainContext* main_context;
+        GMainLoop* main_loop;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<ReactorThread>> threads;
+    std::atomic<unsigned int> next;
+    // Used instead of the threads by reactors without threads
+    GMainContext* const creator_context;
+    std::thread::id const creator_thread_id;
+};
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "event_loop_timeout.h"
+#include "event_loop.h"
+
+struct repowerd::EventLoopTimeout::TimeoutSource
+{
+    GSource gsource;
+    EventLoopTimeout* timeout;
+};
+
+repowerd::EventLoopTimeout::EventLoopTimeout(
+    EventLoop& event_loop, std::function<void()> const& callback)
+    : callback{callback},
+      main_context{g_main_context_ref(event_loop.main_context)},
+      gsource{[this]
+              {
+                  static GSourceFuncs timeout_source_funcs{
+                      nullptr, nullptr, &EventLoopTimeout::static_dispatch,
+                      nullptr, nullptr, nullptr};
+                  auto const s = g_source_new(&timeout_source_funcs, sizeof(TimeoutSource));
+                  reinterpret_cast<TimeoutSource*>(s)->timeout = this;
+                  return s;
+              }()}
+{
+    event_loop.attach_source(gsource);
+}
+
+repowerd::EventLoopTimeout::~EventLoopTimeout()
+{
+    g_source_destroy(gsource);
+    g_source_unref(gsource);
+    g_main_context_unref(main_context);
+}
+
+void repowerd::EventLoopTimeout::arm_in(std::chrono::nanoseconds t)
+{
+    // Round up to avoid expiring early
+    auto const t_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        t + std::chrono::microseconds{1} - std::chrono::nanoseconds{1});
+
+    g_source_set_ready_time(gsource, g_get_monotonic_time() + t_us.count());
+}
+
+void repowerd::EventLoopTimeout::cancel()
+{
+    g_source_set_ready_time(gsource, -1);
+}
+
+gboolean repowerd::EventLoopTimeout::static_dispatch(GSource* gsource, GSourceFunc, gpointer)
+{
+    // Disarm before running the callback, so that it can rearm the timeout
+    g_source_set_ready_time(gsource, -1);
+
+    try
+    {
+        reinterpret_cast<TimeoutSource*>(gsource)->timeout->callback();
+    }
+    catch (...)
+    {
+    }
+
+    return G_SOURCE_CONTINUE;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "timeout.h"
+
+#include <functional>
+
+#include <glib.h>
+
+namespace repowerd
+{
+
+class EventLoop;
+
+// A Timeout backed by a single GSource in the event loop, which is armed
+// and disarmed by setting its ready time. A disarmed timeout never wakes
+// up the loop. The callback runs in the loop thread. Arming and cancelling
+// are thread safe, but the timeout should be destroyed in the loop thread
+// or after the loop has stopped, to avoid racing with the callback.
+class EventLoopTimeout : public Timeout
+{
+public:
+    EventLoopTimeout(EventLoop& event_loop, std::function<void()> const& callback);
+    ~EventLoopTimeout();
+
+    void arm_in(std::chrono::nanoseconds t) override;
+    void cancel() override;
+
+private:
+    struct TimeoutSource;
+    static gboolean static_dispatch(GSource*, GSourceFunc, gpointer);
+
+    std::function<void()> const callback;
+    // Keep a reference to the context, so that the source stays valid
+    // even if the loop goes away first
+    GMainContext* const main_context;
+    GSource* const gsource;
+};
+
+}
@@ -19,23 +19,74 @@
 #include "event_loop_timer.h"
 #include "event_loop_handler_registration.h"
 
+#include "src/core/log.h"
+
+#include <algorithm>
+#include <system_error>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
 namespace
 {
+char const* const log_tag = "EventLoopTimer";
 auto const null_handler = [](auto){};
+repowerd::TimerWheel::Tick const report_interval_ticks{3600 * 1000};
+
+int create_timer_fd()
+{
+    // steady_clock is CLOCK_MONOTONIC, so ticks can be used directly as
+    // absolute timerfd expiration times
+    auto const fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to create timerfd"};
+    return fd;
+}
+
+uint64_t steady_clock_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Alarms are scheduled relative to the next tick and expire on whole ticks
+// that have passed, so that they never expire early
+repowerd::TimerWheel::Tick next_tick()
+{
+    return (steady_clock_ns() + 999999) / 1000000;
 }
 
-repowerd::EventLoopTimer::EventLoopTimer()
-    : alarm_handler{null_handler},
-      next_alarm_id{1}
+repowerd::TimerWheel::Tick last_tick()
 {
+    return steady_clock_ns() / 1000000;
+}
+
+}
+
+repowerd::EventLoopTimer::EventLoopTimer(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
+    std::shared_ptr<Log> const& log)
+    : log{log},
+      timer_fd{create_timer_fd()},
+      event_loop{event_loop_reactor},
+      alarm_handler{null_handler},
+      wheel{last_tick()},
+      deadline_wheel{last_tick()},
+      armed_tick{TimerWheel::no_tick},
+      next_alarm_id{1},
+      wakeups{0},
+      wakeups_saved{0},
+      report_start_tick{last_tick()},
+      report_start_wakeups{0},
+      report_start_wakeups_saved{0}
+{
+    event_loop.watch_fd(timer_fd, [this] { handle_timer_fd(); });
 }
 
 repowerd::EventLoopTimer::~EventLoopTimer()
 {
     event_loop.stop();
-
-    for (auto const& alarm : alarms)
-        alarm.second();
+    close(timer_fd);
 }
 
 repowerd::HandlerRegistration repowerd::EventLoopTimer::register_alarm_handler(
@@ -48,34 +99,29 @@ repowerd::HandlerRegistration repowerd::EventLoopTimer::register_alarm_handler(
 }
 
 repowerd::AlarmId repowerd::EventLoopTimer::schedule_alarm_in(
-    std::chrono::milliseconds t)
+    std::chrono::milliseconds t, std::chrono::milliseconds slack)
 {
-    repowerd::AlarmId alarm_id;
+    auto const expiry = next_tick() + t.count();
+    auto const deadline = expiry + slack.count();
 
-    {
-        std::lock_guard<std::mutex> lock{alarms_mutex};
-        alarm_id = next_alarm_id++;
-    }
+    std::lock_guard<std::mutex> lock{wheel_mutex};
 
-    event_loop.schedule_with_cancellation_in(
-        t,
-        [this, alarm_id]
-        {
-            alarm_handler(alarm_id);
-            cancel_alarm_unqueued(alarm_id);
-        },
-        [this, alarm_id] (EventLoopCancellation const& cancellation)
-        {
-            std::lock_guard<std::mutex> lock{alarms_mutex};
-            alarms[alarm_id] = cancellation;
-        });
+    auto const alarm_id = next_alarm_id++;
+    wheel.add(alarm_id, expiry);
+    deadline_wheel.add(alarm_id, deadline);
+    arm_timer_fd_for(deadline, lock);
 
     return alarm_id;
 }
 
 void repowerd::EventLoopTimer::cancel_alarm(AlarmId id)
 {
-    event_loop.enqueue([this,id] { cancel_alarm_unqueued(id); }).get();
+    std::lock_guard<std::mutex> lock{wheel_mutex};
+
+    // Don't disarm the timerfd if this was the earliest alarm, waking up
+    // for nothing once is cheaper than reprogramming the timer every time
+    wheel.remove(id);
+    deadline_wheel.remove(id);
 }
 
 std::chrono::steady_clock::time_point repowerd::EventLoopTimer::now()
@@ -83,14 +129,82 @@ std::chrono::steady_clock::time_point repowerd::EventLoopTimer::now()
     return std::chrono::steady_clock::now();
 }
 
-void repowerd::EventLoopTimer::cancel_alarm_unqueued(AlarmId id)
+void repowerd::EventLoopTimer::handle_timer_fd()
 {
-    std::lock_guard<std::mutex> lock{alarms_mutex};
+    uint64_t expirations;
+    while (read(timer_fd, &expirations, sizeof(expirations)) < 0 && errno == EINTR)
+        continue;
 
-    auto const iter = alarms.find(id);
-    if (iter != alarms.end())
     {
-        iter->second();
-        alarms.erase(iter);
+        std::lock_guard<std::mutex> lock{wheel_mutex};
+
+        auto const now = last_tick();
+
+        // The timerfd is armed for the earliest deadline. Along with the
+        // alarms that reached their deadline, fire all the alarms that are
+        // past their expiry, to save them waking up on their own later.
+        armed_tick = TimerWheel::no_tick;
+        deadline_wheel.advance_to(now, expired_deadlines);
+        wheel.advance_to(now, expired_alarms);
+        for (auto const& expiration : expired_alarms)
+            deadline_wheel.remove(expiration.id);
+        arm_timer_fd_for(deadline_wheel.next_expiry(), lock);
+
+        // Each expiry after the first would have needed its own wakeup
+        for (auto const& expiration : expired_alarms)
+            expired_ticks.push_back(expiration.expiry);
+        std::sort(expired_ticks.begin(), expired_ticks.end());
+        auto const distinct_expiries = std::unique(expired_ticks.begin(), expired_ticks.end()) -
+                                       expired_ticks.begin();
+        expired_ticks.clear();
+
+        ++wakeups;
+        if (distinct_expiries > 1)
+            wakeups_saved += distinct_expiries - 1;
+
+        if (now - report_start_tick >= report_interval_ticks)
+        {
+            log->log(log_tag, "Alarm wakeups in the last %llu minutes: %llu, wakeups saved: %llu",
+                     static_cast<unsigned long long>((now - report_start_tick) / 60000),
+                     static_cast<unsigned long long>(wakeups - report_start_wakeups),
+                     static_cast<unsigned long long>(wakeups_saved - report_start_wakeups_saved));
+            report_start_tick = now;
+            report_start_wakeups = wakeups;
+            report_start_wakeups_saved = wakeups_saved;
+        }
     }
+
+    for (auto const& expiration : expired_alarms)
+        alarm_handler(expiration.id);
+
+    expired_alarms.clear();
+    expired_deadlines.clear();
+}
+
+uint64_t repowerd::EventLoopTimer::num_wakeups()
+{
+    std::lock_guard<std::mutex> lock{wheel_mutex};
+    return wakeups;
+}
+
+uint64_t repowerd::EventLoopTimer::num_wakeups_saved()
+{
+    std::lock_guard<std::mutex> lock{wheel_mutex};
+    return wakeups_saved;
+}
+
+void repowerd::EventLoopTimer::arm_timer_fd_for(
+    TimerWheel::Tick tick, std::lock_guard<std::mutex> const&)
+{
+    if (tick >= armed_tick)
+        return;
+
+    itimerspec spec{};
+    spec.it_value.tv_sec = tick / 1000;
+    spec.it_value.tv_nsec = (tick % 1000) * 1000000;
+
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr) == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to arm timerfd"};
+
+    armed_tick = tick;
 }
@@ -19,34 +19,69 @@
 #pragma once
 
 #include "src/core/timer.h"
+#include "src/core/timer_wheel.h"
 #include "event_loop.h"
 
+#include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <vector>
 
 namespace repowerd
 {
+class Log;
 
+// Keeps all alarms in timer wheels with millisecond ticks, and uses a
+// single timerfd armed for the earliest alarm deadline (expiry plus slack)
+// to wake up the loop. Each wakeup fires all alarms past their expiry, so
+// alarms with overlapping windows share a wakeup. Scheduling and
+// cancelling alarms never wait for the loop thread. An alarm that has
+// already expired when it is cancelled may still be notified.
 class EventLoopTimer : public Timer
 {
 public:
-    EventLoopTimer();
+    EventLoopTimer(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
+        std::shared_ptr<Log> const& log);
     ~EventLoopTimer();
 
     HandlerRegistration register_alarm_handler(AlarmHandler const& handler) override;
-    AlarmId schedule_alarm_in(std::chrono::milliseconds t) override;
+    using Timer::schedule_alarm_in;
+    AlarmId schedule_alarm_in(
+        std::chrono::milliseconds t, std::chrono::milliseconds slack) override;
     void cancel_alarm(AlarmId id) override;
     std::chrono::steady_clock::time_point now() override;
 
+    // Timerfd wakeups so far, and wakeups saved by firing alarms with
+    // different expiries in the same wakeup. Without slack, each distinct
+    // expiry would need a wakeup of its own. The counts for the last hour
+    // are also logged.
+    uint64_t num_wakeups();
+    uint64_t num_wakeups_saved();
+
 private:
-    void cancel_alarm_unqueued(AlarmId id);
+    void handle_timer_fd();
+    void arm_timer_fd_for(TimerWheel::Tick tick, std::lock_guard<std::mutex> const&);
 
+    std::shared_ptr<Log> const log;
+    int const timer_fd;
     EventLoop event_loop;
     AlarmHandler alarm_handler;
 
-    std::mutex alarms_mutex;
-    std::unordered_map<AlarmId,EventLoopCancellation> alarms;
+    std::mutex wheel_mutex;
+    // Alarms by expiry, and by deadline
+    TimerWheel wheel;
+    TimerWheel deadline_wheel;
+    TimerWheel::Tick armed_tick;
     AlarmId next_alarm_id;
+    uint64_t wakeups;
+    uint64_t wakeups_saved;
+    TimerWheel::Tick report_start_tick;
+    uint64_t report_start_wakeups;
+    uint64_t report_start_wakeups_saved;
+
+    std::vector<TimerWheel::Expiration> expired_alarms;
+    std::vector<TimerWheel::Expiration> expired_deadlines;
+    std::vector<TimerWheel::Tick> expired_ticks;
 };
 
 }
@@ -18,6 +18,8 @@
 
 #include "fd.h"
 
+#include <utility>
+
 #include <unistd.h>
 
 repowerd::Fd::Fd(int fd)
@@ -32,6 +34,26 @@ repowerd::Fd::Fd(int fd, FdCloseFunc const& close_func)
 {
 }
 
+repowerd::Fd::Fd(Fd&& other)
+    : fd{other.fd},
+      close_func{std::move(other.close_func)}
+{
+    other.fd = -1;
+}
+
+repowerd::Fd& repowerd::Fd::operator=(Fd&& other)
+{
+    if (this != &other)
+    {
+        if (fd >= 0) close_func(fd);
+        fd = other.fd;
+        close_func = std::move(other.close_func);
+        other.fd = -1;
+    }
+
+    return *this;
+}
+
 repowerd::Fd::~Fd()
 {
     if (fd >= 0) close_func(fd);
@@ -31,8 +31,9 @@ class Fd
 public:
     Fd(int fd);
     Fd(int fd, FdCloseFunc const& close_func);
-    Fd(Fd&&) = default;
-    Fd& operator=(Fd&&) = default;
+    // The moved from Fd no longer owns the file descriptor
+    Fd(Fd&&);
+    Fd& operator=(Fd&&);
     ~Fd();
 
     operator int() const;
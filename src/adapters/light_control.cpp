@@ -61,13 +61,16 @@ char const* const lightcontrol_service_introspection = R"(<!DOCTYPE node PUBLIC
 </node>)";
 
 repowerd::UBPortsLightControl::UBPortsLightControl(
+   std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
    std::shared_ptr<Log> const& log,
    std::string const& dbus_bus_address)
   : m_lightDevice(0),
     m_state(State::Off),
     log{log},
-    dbus_connection{dbus_bus_address},
-    displayState(DisplayState::DisplayUnknown) {
+    dbus_connection{DBusConnectionHandle::shared(dbus_bus_address)},
+    dbus_event_loop{event_loop_reactor},
+    displayState(DisplayState::DisplayUnknown),
+    dbus_session_event_loop{event_loop_reactor} {
     log->log(log_tag, "contructor");
 
     memset(indicatorLightStates, 0, sizeof(indicatorLightStates));
@@ -121,6 +124,8 @@ void repowerd::UBPortsLightControl::start_processing()
 
     // call init() here?
 
+    DBusEventLoop::RegistrationBatch registration_batch;
+
     lightcontrol_handler_registration = dbus_event_loop.register_object_handler(
         dbus_connection,
         dbus_lightcontrol_path,
@@ -158,6 +163,8 @@ void repowerd::UBPortsLightControl::start_processing()
                 signal_name, parameters);
         });
 
+    registration_batch.finish();
+
     try {
         dbus_connection.request_name(dbus_lightcontrol_servicename);
     } catch (...) {
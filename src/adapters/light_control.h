@@ -32,6 +32,7 @@ public:
     enum LightEvent {LE_UnreadNotifications, LE_BluetoothEnabled, LE_BatteryLow, LE_BatteryCharging, LE_BatteryFull, LE_Playing, LE_NUM_ITEMS};
 
     UBPortsLightControl(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
         std::shared_ptr<Log> const& log,
         std::string const& dbus_bus_address);
 
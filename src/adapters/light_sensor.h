@@ -38,6 +38,12 @@ public:
     virtual void enable_light_events() = 0;
     virtual void disable_light_events() = 0;
 
+    // Lowers the rate of light events while light events are enabled, for
+    // when the ambient light is stable. Disabling light events also
+    // disables reduced sampling.
+    virtual void enable_reduced_light_sampling() = 0;
+    virtual void disable_reduced_light_sampling() = 0;
+
 protected:
     LightSensor() = default;
     LightSensor (LightSensor const&) = default;
@@ -18,6 +18,7 @@
 
 #include "monotone_spline.h"
 #include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 namespace
@@ -113,16 +114,78 @@ std::vector<repowerd::MonotoneSpline::Point> sorted(
     return sorted_points;
 }
 
+std::vector<double> x_values(
+    std::vector<repowerd::MonotoneSpline::Point> const& points)
+{
+    std::vector<double> xs;
+    for (auto const& p : points)
+        xs.push_back(p.x);
+    return xs;
+}
+
 }
 
 repowerd::MonotoneSpline::MonotoneSpline(
     std::vector<Point> const& points)
     : points{sorted(points)},
-      tangents{calculate_monotone_point_tangents(this->points)}
+      tangents{calculate_monotone_point_tangents(this->points)},
+      xs{x_values(this->points)},
+      lut_linear_step{0},
+      lut_linear_limit{0},
+      lut_linear_size{0},
+      lut_log_steps_per_unit{0}
+{
+    // Expand the Hermite basis once, so that interpolation only needs to
+    // evaluate a cubic polynomial
+    for (auto i = 0u; i < this->points.size() - 1; ++i)
+    {
+        auto const h = this->points[i+1].x - this->points[i].x;
+        auto const y0 = this->points[i].y;
+        auto const y1 = this->points[i+1].y;
+        auto const m0 = tangents[i];
+        auto const m1 = tangents[i+1];
+        auto const delta = (y1 - y0) / h;
+
+        segments.push_back(
+            {y0,
+             m0,
+             (3 * delta - 2 * m0 - m1) / h,
+             (m0 + m1 - 2 * delta) / (h * h)});
+    }
+}
+
+repowerd::MonotoneSpline::MonotoneSpline(
+    std::vector<Point> const& points,
+    LookupTableParams const& params)
+    : MonotoneSpline{points}
 {
+    build_lookup_table(params);
 }
 
 double repowerd::MonotoneSpline::interpolate(double x) const
+{
+    if (!lut.empty())
+        return lookup(x);
+    else
+        return evaluate(x);
+}
+
+void repowerd::MonotoneSpline::interpolate(
+    double const* in, double* out, size_t count) const
+{
+    if (!lut.empty())
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = lookup(in[i]);
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = evaluate(in[i]);
+    }
+}
+
+double repowerd::MonotoneSpline::evaluate(double x) const
 {
     auto const i = find_index(x);
 
@@ -131,29 +194,79 @@ double repowerd::MonotoneSpline::interpolate(double x) const
     if (i >= static_cast<int>(points.size() - 1))
         return points.back().y;
 
-    auto const h = points[i+1].x - points[i].x;
-    auto const t = (x - points[i].x) / h;
-    auto const h00 = t * t * (2 * t - 3) + 1;
-    auto const h10 = t * (1 + t * (t - 2));
-    auto const h01 = t * t * (3 - 2 * t);
-    auto const h11 = t * t * (t - 1);
-
-    return h00 * points[i].y +
-           h10 * h * tangents[i] +
-           h01 * points[i+1].y +
-           h11 * h * tangents[i+1];
+    auto const& s = segments[i];
+    auto const dx = x - xs[i];
+
+    return s.c0 + dx * (s.c1 + dx * (s.c2 + dx * s.c3));
 }
 
-int repowerd::MonotoneSpline::find_index(double x) const
+double repowerd::MonotoneSpline::lookup(double x) const
 {
-    if (x < points[0].x)
-        return -1;
+    if (x <= xs.front())
+        return points.front().y;
+    if (x >= xs.back())
+        return points.back().y;
 
-    for (auto i = 0u; i < points.size() - 1; ++i)
+    double pos;
+
+    if (x < lut_linear_limit)
+        pos = (x - xs.front()) / lut_linear_step;
+    else
+        pos = (lut_linear_size - 1) + std::log(x / lut_linear_limit) * lut_log_steps_per_unit;
+
+    auto const i = std::min(static_cast<size_t>(pos), lut.size() - 2);
+    auto const frac = pos - i;
+
+    return lut[i] + frac * (lut[i+1] - lut[i]);
+}
+
+void repowerd::MonotoneSpline::build_lookup_table(LookupTableParams const& params)
+{
+    if (params.linear_step <= 0 || params.log_steps_per_decade <= 0)
+        throw std::logic_error("Invalid spline lookup table parameters");
+
+    auto const first = xs.front();
+    auto const last = xs.back();
+
+    // The linear part ends at an entry, and the log-spaced part needs to
+    // start at a positive value
+    auto const linear_steps = static_cast<size_t>(std::ceil(
+        (std::min(std::max(params.linear_limit, first), last) - first) / params.linear_step));
+    lut_linear_step = params.linear_step;
+    lut_linear_limit = first + linear_steps * params.linear_step;
+    if (lut_linear_limit <= 0 && lut_linear_limit < last)
+        throw std::logic_error("Spline lookup table log-spaced part must start above 0");
+
+    for (size_t i = 0; i <= linear_steps; ++i)
+        lut.push_back(evaluate(first + i * params.linear_step));
+    lut_linear_size = lut.size();
+
+    lut_log_steps_per_unit = params.log_steps_per_decade / std::log(10.0);
+
+    if (lut_linear_limit < last)
     {
-        if (x >= points[i].x && x < points[i+1].x)
-            return i;
+        auto const log_steps = static_cast<size_t>(std::ceil(
+            std::log(last / lut_linear_limit) * lut_log_steps_per_unit));
+
+        for (size_t i = 1; i <= log_steps; ++i)
+        {
+            lut.push_back(
+                evaluate(lut_linear_limit * std::exp(i / lut_log_steps_per_unit)));
+        }
     }
 
-    return points.size() - 1;
+    // The table needs at least two entries to interpolate between
+    if (lut.size() < 2)
+        lut.push_back(evaluate(last));
+}
+
+int repowerd::MonotoneSpline::find_index(double x) const
+{
+    if (x < xs.front())
+        return -1;
+
+    // Index of the last point with x[i] <= x
+    auto const iter = std::upper_bound(xs.begin(), xs.end(), x);
+
+    return static_cast<int>(iter - xs.begin()) - 1;
 }
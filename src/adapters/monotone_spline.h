@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 namespace repowerd
@@ -30,15 +31,45 @@ class MonotoneSpline
 public:
     struct Point { double x; double y; };
 
+    // Dense table of spline values, evenly spaced by linear_step up to
+    // linear_limit, and log-spaced with log_steps_per_decade entries per
+    // decade from there up to the last point
+    struct LookupTableParams
+    {
+        double linear_step;
+        double linear_limit;
+        int log_steps_per_decade;
+    };
+
     MonotoneSpline(std::vector<Point> const& points);
+    // Interpolates linearly between lookup table entries instead of
+    // evaluating the spline, which is faster but approximate
+    MonotoneSpline(std::vector<Point> const& points, LookupTableParams const& params);
 
     double interpolate(double x) const;
+    // Interpolates count values from in to out
+    void interpolate(double const* in, double* out, size_t count) const;
 
 private:
+    // Spline segment i as a cubic polynomial in (x - x[i])
+    struct Segment { double c0; double c1; double c2; double c3; };
+
     int find_index(double x) const;
+    double evaluate(double x) const;
+    double lookup(double x) const;
+    void build_lookup_table(LookupTableParams const& params);
 
     std::vector<Point> points;
     std::vector<double> tangents;
+    std::vector<double> xs;
+    std::vector<Segment> segments;
+
+    // Lookup table, empty if not used
+    std::vector<double> lut;
+    double lut_linear_step;
+    double lut_linear_limit;
+    size_t lut_linear_size;
+    double lut_log_steps_per_unit;
 };
 
 }
@@ -114,10 +114,12 @@ bool is_call_state_active(repowerd::OfonoCallState call_state)
 }
 
 repowerd::OfonoVoiceCallService::OfonoVoiceCallService(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
     std::shared_ptr<Log> const& log,
     std::string const& dbus_bus_address)
     : log{log},
-      dbus_connection{dbus_bus_address},
+      dbus_connection{DBusConnectionHandle::shared(dbus_bus_address)},
+      dbus_event_loop{event_loop_reactor},
       active_call_handler{null_handler},
       no_active_call_handler{null_handler}
 {
@@ -125,6 +127,8 @@ repowerd::OfonoVoiceCallService::OfonoVoiceCallService(
 
 void repowerd::OfonoVoiceCallService::start_processing()
 {
+    DBusEventLoop::RegistrationBatch registration_batch;
+
     manager_handler_registration = dbus_event_loop.register_signal_handler(
         dbus_connection,
         ofono_service_name,
@@ -182,6 +186,8 @@ void repowerd::OfonoVoiceCallService::start_processing()
                 signal_name, parameters);
         });
 
+    registration_batch.finish();
+
     dbus_event_loop.enqueue([this] { add_existing_modems(); }).get();
 }
 
@@ -205,12 +211,12 @@ repowerd::HandlerRegistration repowerd::OfonoVoiceCallService::register_no_activ
 
 void repowerd::OfonoVoiceCallService::set_low_power_mode()
 {
-    dbus_event_loop.enqueue([this] { set_fast_dormancy(true); });
+    dbus_event_loop.post([this] { set_fast_dormancy(true); });
 }
 
 void repowerd::OfonoVoiceCallService::set_normal_power_mode()
 {
-    dbus_event_loop.enqueue([this] { set_fast_dormancy(false); });
+    dbus_event_loop.post([this] { set_fast_dormancy(false); });
 }
 
 std::unordered_set<std::string> repowerd::OfonoVoiceCallService::tracked_modems()
@@ -47,6 +47,7 @@ class OfonoVoiceCallService : public VoiceCallService, public ModemPowerControl
 {
 public:
     OfonoVoiceCallService(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
         std::shared_ptr<Log> const& log,
         std::string const& dbus_bus_address);
 
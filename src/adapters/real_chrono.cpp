@@ -17,6 +17,7 @@
  */
 
 #include "real_chrono.h"
+#include "event_loop_timeout.h"
 
 #include <thread>
 
@@ -24,3 +25,15 @@ void repowerd::RealChrono::sleep_for(std::chrono::nanoseconds t)
 {
     std::this_thread::sleep_for(t);
 }
+
+std::chrono::steady_clock::time_point repowerd::RealChrono::steady_now()
+{
+    return std::chrono::steady_clock::now();
+}
+
+std::unique_ptr<repowerd::Timeout> repowerd::RealChrono::create_timeout(
+    EventLoop& event_loop,
+    std::function<void()> const& callback)
+{
+    return std::make_unique<EventLoopTimeout>(event_loop, callback);
+}
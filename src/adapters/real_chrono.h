@@ -27,6 +27,10 @@ class RealChrono : public Chrono
 {
 public:
     void sleep_for(std::chrono::nanoseconds t) override;
+    std::chrono::steady_clock::time_point steady_now() override;
+    std::unique_ptr<Timeout> create_timeout(
+        EventLoop& event_loop,
+        std::function<void()> const& callback) override;
 };
 
 }
@@ -21,8 +21,10 @@
 #include "src/core/suspend_control.h"
 
 repowerd::RealTemporarySuspendInhibition::RealTemporarySuspendInhibition(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
     std::shared_ptr<SuspendControl> const& suspend_control)
     : suspend_control{suspend_control},
+      event_loop{event_loop_reactor},
       id{0}
 {
 }
@@ -31,7 +31,9 @@ class SuspendControl;
 class RealTemporarySuspendInhibition : public TemporarySuspendInhibition
 {
 public:
-    RealTemporarySuspendInhibition(std::shared_ptr<SuspendControl> const& suspend_control);
+    RealTemporarySuspendInhibition(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
+        std::shared_ptr<SuspendControl> const& suspend_control);
 
     void inhibit_suspend_for(std::chrono::milliseconds timeout, std::string const& name) override;
 
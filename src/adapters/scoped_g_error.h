@@ -45,6 +45,11 @@ struct ScopedGError
         return g_error != nullptr;
     }
 
+    bool matches(GQuark domain, gint code) const
+    {
+        return g_error_matches(g_error, domain, code);
+    }
+
     operator GError**()
     {
         return &g_error;
@@ -24,10 +24,14 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <stdexcept>
 #include <vector>
 
+#include <fcntl.h>
+
 namespace
 {
 char const* const log_tag = "SysfsBacklight";
@@ -107,7 +111,10 @@ repowerd::SysfsBacklight::SysfsBacklight(
       sysfs_backlight_dir{determine_sysfs_backlight_dir(*filesystem)},
       sysfs_brightness_file{sysfs_backlight_dir/"brightness"},
       max_brightness{determine_max_brightness(*filesystem, sysfs_backlight_dir)},
-      last_set_brightness{-1.0}
+      brightness_fd{filesystem->open(
+          std::string{sysfs_brightness_file}.c_str(), O_RDWR | O_CLOEXEC)},
+      last_set_brightness{-1.0},
+      last_abs_brightness{-1}
 {
     log->log(log_tag, "Using backlight %s",
              std::string{sysfs_backlight_dir}.c_str());
@@ -115,17 +122,21 @@ repowerd::SysfsBacklight::SysfsBacklight(
 
 void repowerd::SysfsBacklight::set_brightness(double value)
 {
-    auto ostream = filesystem->ostream(sysfs_brightness_file);
-    *ostream << absolute_brightness_for(value);
-    ostream->flush();
+    auto const abs_brightness = absolute_brightness_for(value);
+
+    // Small brightness steps often map to the same raw value, especially
+    // for backlights with few levels, so don't write it again
+    if (abs_brightness != last_abs_brightness)
+        write_absolute_brightness(abs_brightness);
+
     last_set_brightness = value;
 }
 
 double repowerd::SysfsBacklight::get_brightness()
 {
-    auto istream = filesystem->istream(sysfs_brightness_file);
-    int abs_brightness = 0;
-    *istream >> abs_brightness;
+    // Brightness may have been changed externally, so resynchronize
+    last_abs_brightness = read_absolute_brightness();
+    auto const abs_brightness = std::max(last_abs_brightness, 0);
 
     if (absolute_brightness_for(last_set_brightness) == abs_brightness)
         return last_set_brightness;
@@ -133,7 +144,52 @@ double repowerd::SysfsBacklight::get_brightness()
         return static_cast<double>(abs_brightness) / max_brightness;
 }
 
+int repowerd::SysfsBacklight::max_raw_brightness()
+{
+    return max_brightness;
+}
+
 int repowerd::SysfsBacklight::absolute_brightness_for(double rel_brightness)
 {
     return static_cast<int>(round(rel_brightness * max_brightness));
 }
+
+void repowerd::SysfsBacklight::write_absolute_brightness(int abs_brightness)
+{
+    if (brightness_fd >= 0)
+    {
+        char buf[16];
+        auto const len = snprintf(buf, sizeof(buf), "%d", abs_brightness);
+        if (filesystem->pwrite(brightness_fd, buf, len, 0) == len)
+            last_abs_brightness = abs_brightness;
+        else
+            last_abs_brightness = -1;
+    }
+    else
+    {
+        auto ostream = filesystem->ostream(sysfs_brightness_file);
+        *ostream << abs_brightness;
+        ostream->flush();
+        last_abs_brightness = *ostream ? abs_brightness : -1;
+    }
+}
+
+int repowerd::SysfsBacklight::read_absolute_brightness()
+{
+    if (brightness_fd >= 0)
+    {
+        char buf[16];
+        auto const len = filesystem->pread(brightness_fd, buf, sizeof(buf) - 1, 0);
+        if (len <= 0)
+            return -1;
+        buf[len] = '\0';
+        return atoi(buf);
+    }
+    else
+    {
+        auto istream = filesystem->istream(sysfs_brightness_file);
+        int abs_brightness = 0;
+        *istream >> abs_brightness;
+        return *istream ? abs_brightness : -1;
+    }
+}
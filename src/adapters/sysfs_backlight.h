@@ -20,6 +20,7 @@
 
 #include "backlight.h"
 
+#include "fd.h"
 #include "path.h"
 
 #include <memory>
@@ -39,15 +40,23 @@ public:
 
     void set_brightness(double) override;
     double get_brightness() override;
+    int max_raw_brightness() override;
 
 private:
     int absolute_brightness_for(double relative_brightness);
+    void write_absolute_brightness(int abs_brightness);
+    int read_absolute_brightness();
 
     std::shared_ptr<Filesystem> const filesystem;
     Path const sysfs_backlight_dir;
     Path const sysfs_brightness_file;
     int const max_brightness;
+    // Kept open to avoid reopening the file on every brightness change.
+    // If it can't be opened, the file is accessed through streams.
+    Fd const brightness_fd;
     double last_set_brightness;
+    // The raw value the file is known to hold, or -1 if unknown
+    int last_abs_brightness;
 };
 
 }
@@ -0,0 +1,436 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sysfs_power_source.h"
+#include "filesystem.h"
+
+#include "src/core/log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+char const* const log_tag = "SysfsPowerSource";
+char const* const power_supply_property_prefix = "POWER_SUPPLY_";
+
+int create_uevent_socket()
+{
+    auto const fd = socket(
+        AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (fd == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to create uevent socket"};
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    // Only kernel uevents, not the ones rebroadcast by udev
+    addr.nl_groups = 1;
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1)
+    {
+        auto const bind_errno = errno;
+        close(fd);
+        throw std::system_error{bind_errno, std::system_category(), "Failed to bind uevent socket"};
+    }
+
+    return fd;
+}
+
+std::string trimmed(std::string const& str)
+{
+    auto const end = str.find_last_not_of(" \t\n");
+    return end == std::string::npos ? std::string{} : str.substr(0, end + 1);
+}
+
+uint32_t status_to_state(std::string const& status)
+{
+    if (status == "Charging")
+        return static_cast<uint32_t>(repowerd::BatteryState::charging);
+    else if (status == "Discharging")
+        return static_cast<uint32_t>(repowerd::BatteryState::discharging);
+    else if (status == "Full")
+        return static_cast<uint32_t>(repowerd::BatteryState::fully_charged);
+    else if (status == "Not charging")
+        return static_cast<uint32_t>(repowerd::BatteryState::pending_charge);
+    else
+        return static_cast<uint32_t>(repowerd::BatteryState::unknown);
+}
+
+int to_int(std::string const& value)
+try
+{
+    return std::stoi(value);
+}
+catch (...)
+{
+    return 0;
+}
+
+}
+
+repowerd::SysfsPowerSource::SysfsPowerSource(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
+    std::shared_ptr<Log> const& log,
+    std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
+    std::shared_ptr<Filesystem> const& filesystem,
+    DeviceConfig const& device_config)
+    : SysfsPowerSource{
+        event_loop_reactor, log, temporary_suspend_inhibition, filesystem, device_config,
+        create_uevent_socket()}
+{
+}
+
+repowerd::SysfsPowerSource::SysfsPowerSource(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
+    std::shared_ptr<Log> const& log,
+    std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
+    std::shared_ptr<Filesystem> const& filesystem,
+    DeviceConfig const& device_config,
+    Fd uevent_fd)
+    : log{log},
+      filesystem{filesystem},
+      power_supply_root{"/sys/class/power_supply"},
+      uevent_fd{std::move(uevent_fd)},
+      event_loop{event_loop_reactor},
+      battery_tracker{
+          log, temporary_suspend_inhibition, device_config, event_loop,
+          log_tag, [this] { return is_using_battery_power(); }}
+{
+}
+
+repowerd::SysfsPowerSource::~SysfsPowerSource()
+{
+    // Stop handling uevents before the attribute fds are closed
+    event_loop.stop();
+}
+
+void repowerd::SysfsPowerSource::start_processing()
+{
+    event_loop.enqueue(
+        [this]
+        {
+            add_existing_power_supplies();
+            event_loop.watch_fd(uevent_fd, [this] { handle_uevent_fd(); });
+        }).get();
+}
+
+repowerd::HandlerRegistration repowerd::SysfsPowerSource::register_power_source_change_handler(
+    PowerSourceChangeHandler const& handler)
+{
+    return battery_tracker.register_power_source_change_handler(handler);
+}
+
+repowerd::HandlerRegistration repowerd::SysfsPowerSource::register_power_source_critical_handler(
+    PowerSourceCriticalHandler const& handler)
+{
+    return battery_tracker.register_power_source_critical_handler(handler);
+}
+
+repowerd::HandlerRegistration repowerd::SysfsPowerSource::register_power_source_level_change_handler(
+    PowerSourceLevelChangeHandler const& handler)
+{
+    return battery_tracker.register_power_source_level_change_handler(handler);
+}
+
+std::unordered_set<std::string> repowerd::SysfsPowerSource::tracked_batteries()
+{
+    std::unordered_set<std::string> ret_batteries;
+    event_loop.enqueue(
+        [this, &ret_batteries]
+        {
+            for (auto const& battery : battery_tracker.batteries())
+                ret_batteries.insert(battery.first);
+        }).get();
+    return ret_batteries;
+}
+
+void repowerd::SysfsPowerSource::handle_uevent_fd()
+{
+    char buf[8192];
+
+    while (true)
+    {
+        auto const len = recv(uevent_fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == ENOBUFS)
+            {
+                // The kernel dropped uevents that didn't fit in the socket
+                // buffer, so we don't know which supplies changed
+                log->log(log_tag, "uevent socket buffer overrun, rereading all power supplies");
+                resync_power_supplies();
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                log->log(log_tag, "Failed to receive uevent: %s", strerror(errno));
+            break;
+        }
+
+        if (len == 0)
+            break;
+
+        buf[len] = '\0';
+        handle_uevent(buf, len);
+    }
+}
+
+void repowerd::SysfsPowerSource::handle_uevent(char const* buf, size_t len)
+{
+    // A kernel uevent is a "ACTION@DEVPATH" header followed by KEY=VALUE
+    // properties, all null terminated
+    std::string action;
+    std::string subsystem;
+    std::string name;
+    std::unordered_map<std::string,std::string> reported_values;
+
+    for (auto str = buf + strlen(buf) + 1; str < buf + len; str += strlen(str) + 1)
+    {
+        std::string const property{str};
+        auto const sep = property.find('=');
+        if (sep == std::string::npos)
+            continue;
+
+        auto const key = property.substr(0, sep);
+        auto const value = property.substr(sep + 1);
+
+        if (key == "ACTION")
+        {
+            action = value;
+        }
+        else if (key == "SUBSYSTEM")
+        {
+            subsystem = value;
+        }
+        else if (key == "POWER_SUPPLY_NAME")
+        {
+            name = value;
+        }
+        else if (key.find(power_supply_property_prefix) == 0)
+        {
+            // POWER_SUPPLY_CAPACITY is the value of the "capacity" attribute
+            auto attribute = key.substr(strlen(power_supply_property_prefix));
+            std::transform(attribute.begin(), attribute.end(), attribute.begin(),
+                           [] (unsigned char c) { return std::tolower(c); });
+            reported_values[attribute] = value;
+        }
+    }
+
+    if (subsystem != "power_supply" || name.empty())
+        return;
+
+    if (action == "add")
+        add_power_supply(name);
+    else if (action == "remove")
+        remove_power_supply(name);
+    else if (action == "change")
+        change_power_supply(name, reported_values);
+}
+
+void repowerd::SysfsPowerSource::add_existing_power_supplies()
+{
+    for (auto const& dir : filesystem->subdirs(power_supply_root))
+        add_power_supply(dir.substr(dir.find_last_of('/') + 1));
+}
+
+void repowerd::SysfsPowerSource::resync_power_supplies()
+{
+    std::unordered_set<std::string> names;
+    for (auto const& dir : filesystem->subdirs(power_supply_root))
+        names.insert(dir.substr(dir.find_last_of('/') + 1));
+
+    std::vector<std::string> removed;
+    for (auto const& power_supply : power_supplies)
+    {
+        if (names.find(power_supply.first) == names.end())
+            removed.push_back(power_supply.first);
+    }
+
+    for (auto const& name : removed)
+        remove_power_supply(name);
+
+    // Without reported values all the attributes are read back from sysfs
+    for (auto const& name : names)
+    {
+        if (power_supplies.find(name) != power_supplies.end())
+            change_power_supply(name, {});
+        else
+            add_power_supply(name);
+    }
+}
+
+void repowerd::SysfsPowerSource::add_power_supply(std::string const& name)
+{
+    if (power_supplies.find(name) != power_supplies.end())
+        return;
+
+    auto const dir = power_supply_root/name;
+
+    std::string type;
+    *filesystem->istream(dir/"type") >> type;
+
+    auto& power_supply = power_supplies[name];
+    power_supply.is_battery = type == "Battery";
+    power_supply.online = false;
+
+    std::vector<char const*> const attributes = power_supply.is_battery ?
+        std::vector<char const*>{"status", "capacity", "temp", "present"} :
+        std::vector<char const*>{"online"};
+
+    for (auto const attribute : attributes)
+    {
+        auto const path = std::string{dir/attribute};
+        if (filesystem->is_regular_file(path))
+        {
+            power_supply.attributes.emplace(
+                attribute,
+                Attribute{filesystem->open(path.c_str(), O_RDONLY | O_CLOEXEC), ""});
+        }
+    }
+
+    BatteryInfo battery_info{true, 0, 0.0, 0.0};
+    apply_attributes(power_supply, {}, battery_info);
+
+    log->log(log_tag, "add_power_supply(%s), type=%s, online=%d, "
+             "is_present=%d, state=%d, percentage=%.2f, temperature=%.2f",
+             name.c_str(),
+             type.c_str(),
+             power_supply.online,
+             battery_info.is_present,
+             battery_info.state,
+             battery_info.percentage,
+             battery_info.temperature);
+
+    if (power_supply.is_battery)
+        battery_tracker.add_battery(name, battery_info);
+}
+
+void repowerd::SysfsPowerSource::remove_power_supply(std::string const& name)
+{
+    if (power_supplies.find(name) == power_supplies.end())
+        return;
+
+    log->log(log_tag, "remove_power_supply(%s)", name.c_str());
+
+    power_supplies.erase(name);
+    battery_tracker.remove_battery(name);
+}
+
+void repowerd::SysfsPowerSource::change_power_supply(
+    std::string const& name,
+    std::unordered_map<std::string,std::string> const& reported_values)
+{
+    auto const iter = power_supplies.find(name);
+    if (iter == power_supplies.end())
+        return;
+
+    // Only battery attributes are reported as changes, so the info of other
+    // supplies is never used
+    auto new_info = iter->second.is_battery ?
+        battery_tracker.batteries().at(name) : BatteryInfo{true, 0, 0.0, 0.0};
+
+    if (apply_attributes(iter->second, reported_values, new_info))
+        battery_tracker.update_battery(name, new_info);
+}
+
+bool repowerd::SysfsPowerSource::apply_attributes(
+    PowerSupply& power_supply,
+    std::unordered_map<std::string,std::string> const& reported_values,
+    BatteryInfo& battery_info)
+{
+    bool battery_changed{false};
+
+    for (auto& attribute_entry : power_supply.attributes)
+    {
+        auto const& attribute_name = attribute_entry.first;
+        auto& attribute = attribute_entry.second;
+
+        std::string value;
+        auto const reported = reported_values.find(attribute_name);
+
+        if (reported != reported_values.end())
+        {
+            value = reported->second;
+        }
+        else
+        {
+            char buf[64];
+            auto const len = filesystem->pread(attribute.fd, buf, sizeof(buf) - 1, 0);
+            if (len < 0)
+                continue;
+            value = trimmed(std::string(buf, len));
+        }
+
+        if (value == attribute.value)
+            continue;
+
+        attribute.value = value;
+
+        if (attribute_name == "online")
+        {
+            power_supply.online = to_int(value) != 0;
+            continue;
+        }
+
+        if (attribute_name == "status")
+            battery_info.state = status_to_state(value);
+        else if (attribute_name == "capacity")
+            battery_info.percentage = to_int(value);
+        else if (attribute_name == "temp")
+            battery_info.temperature = to_int(value) * 0.1;
+        else if (attribute_name == "present")
+            battery_info.is_present = to_int(value) != 0;
+
+        battery_changed = true;
+    }
+
+    return battery_changed;
+}
+
+bool repowerd::SysfsPowerSource::is_using_battery_power()
+{
+    bool discharging_battery{false};
+
+    for (auto const& power_supply : power_supplies)
+    {
+        if (!power_supply.second.is_battery && power_supply.second.online)
+            return false;
+    }
+
+    for (auto const& battery : battery_tracker.batteries())
+    {
+        if (battery.second.is_present &&
+            battery.second.state == static_cast<uint32_t>(BatteryState::discharging))
+        {
+            discharging_battery = true;
+        }
+    }
+
+    return discharging_battery;
+}
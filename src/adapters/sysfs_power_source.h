@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "src/core/power_source.h"
+
+#include "battery_tracker.h"
+#include "event_loop.h"
+#include "fd.h"
+#include "path.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace repowerd
+{
+class Log;
+class DeviceConfig;
+class Filesystem;
+class TemporarySuspendInhibition;
+
+// Tracks the power supplies in /sys/class/power_supply, without going
+// through UPower. The attribute files are kept open, and are updated from
+// the power_supply uevents reported by the kernel. Attributes included in
+// a uevent are taken from it, the rest are read back from sysfs, and only
+// the attributes whose values changed are parsed.
+class SysfsPowerSource : public PowerSource
+{
+public:
+    // Receives uevents from a new NETLINK_KOBJECT_UEVENT socket
+    SysfsPowerSource(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
+        std::shared_ptr<Log> const& log,
+        std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
+        std::shared_ptr<Filesystem> const& filesystem,
+        DeviceConfig const& device_config);
+    // Receives uevents from the specified fd, in the kernel netlink format
+    SysfsPowerSource(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
+        std::shared_ptr<Log> const& log,
+        std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
+        std::shared_ptr<Filesystem> const& filesystem,
+        DeviceConfig const& device_config,
+        Fd uevent_fd);
+    ~SysfsPowerSource();
+
+    void start_processing() override;
+
+    HandlerRegistration register_power_source_change_handler(
+        PowerSourceChangeHandler const& handler) override;
+
+    HandlerRegistration register_power_source_critical_handler(
+        PowerSourceCriticalHandler const& handler) override;
+
+    HandlerRegistration register_power_source_level_change_handler(
+        PowerSourceLevelChangeHandler const& handler) override;
+
+    std::unordered_set<std::string> tracked_batteries();
+
+private:
+    struct Attribute
+    {
+        Fd fd;
+        // The raw contents, as last read or reported
+        std::string value;
+    };
+
+    struct PowerSupply
+    {
+        bool is_battery;
+        bool online;
+        std::unordered_map<std::string,Attribute> attributes;
+    };
+
+    void handle_uevent_fd();
+    void handle_uevent(char const* buf, size_t len);
+    void add_existing_power_supplies();
+    // Brings the tracked supplies up to date after uevents were lost
+    void resync_power_supplies();
+    void add_power_supply(std::string const& name);
+    void remove_power_supply(std::string const& name);
+    void change_power_supply(
+        std::string const& name,
+        std::unordered_map<std::string,std::string> const& reported_values);
+    // Updates the attributes with the reported values, reading the missing
+    // ones from sysfs, and returns whether any battery attribute changed
+    bool apply_attributes(
+        PowerSupply& power_supply,
+        std::unordered_map<std::string,std::string> const& reported_values,
+        BatteryInfo& battery_info);
+    bool is_using_battery_power();
+
+    std::shared_ptr<Log> const log;
+    std::shared_ptr<Filesystem> const filesystem;
+    Path const power_supply_root;
+    Fd const uevent_fd;
+    EventLoop event_loop;
+    BatteryTracker battery_tracker;
+
+    std::unordered_map<std::string,PowerSupply> power_supplies;
+};
+
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+
+namespace repowerd
+{
+
+// A timeout that runs a callback when it expires, and that can be rearmed
+// and cancelled any number of times
+class Timeout
+{
+public:
+    virtual ~Timeout() = default;
+
+    // Arms the timeout to expire after (at least) the specified time,
+    // replacing any pending expiration
+    virtual void arm_in(std::chrono::nanoseconds t) = 0;
+    virtual void cancel() = 0;
+
+protected:
+    Timeout() = default;
+    Timeout(Timeout const&) = delete;
+    Timeout& operator=(Timeout const&) = delete;
+};
+
+}
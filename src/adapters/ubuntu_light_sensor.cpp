@@ -18,18 +18,27 @@
 
 #include "ubuntu_light_sensor.h"
 #include "event_loop_handler_registration.h"
+#include "event_loop_timeout.h"
 
 #include <stdexcept>
 
 namespace
 {
 auto const null_handler = [](double){};
+auto constexpr reduced_sampling_period = std::chrono::seconds{2};
 }
 
-repowerd::UbuntuLightSensor::UbuntuLightSensor()
+repowerd::UbuntuLightSensor::UbuntuLightSensor(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor)
     : sensor{ua_sensors_light_new()},
+      event_loop{event_loop_reactor},
       handler{null_handler},
-      enabled{false}
+      enabled{false},
+      reduced_sampling{false},
+      sensor_active{false},
+      duty_cycle_timeout{
+          std::make_unique<EventLoopTimeout>(
+              event_loop, [this] { if (enabled) activate_sensor(); })}
 {
     if (!sensor)
         throw std::runtime_error("Failed to allocate light sensor");
@@ -37,6 +46,13 @@ repowerd::UbuntuLightSensor::UbuntuLightSensor()
     ua_sensors_light_set_reading_cb(sensor, static_sensor_reading_callback, this);
 }
 
+repowerd::UbuntuLightSensor::~UbuntuLightSensor()
+{
+    // The timeout callback runs in the loop thread, so destroy the timeout
+    // there to ensure the callback is not running
+    event_loop.enqueue([this] { duty_cycle_timeout.reset(); }).get();
+}
+
 repowerd::HandlerRegistration repowerd::UbuntuLightSensor::register_light_handler(
     LightHandler const& handler)
 {
@@ -48,28 +64,54 @@ repowerd::HandlerRegistration repowerd::UbuntuLightSensor::register_light_handle
 
 void repowerd::UbuntuLightSensor::enable_light_events()
 {
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         {
             if (!enabled)
             {
-                ua_sensors_light_enable(sensor);
                 enabled = true;
+                activate_sensor();
             }
-        }).get();
+        });
 }
 
 void repowerd::UbuntuLightSensor::disable_light_events()
 {
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         {
             if (enabled)
             {
-                ua_sensors_light_disable(sensor);
                 enabled = false;
+                reduced_sampling = false;
+                duty_cycle_timeout->cancel();
+                deactivate_sensor();
+            }
+        });
+}
+
+void repowerd::UbuntuLightSensor::enable_reduced_light_sampling()
+{
+    event_loop.post(
+        [this]
+        {
+            if (enabled)
+                reduced_sampling = true;
+        });
+}
+
+void repowerd::UbuntuLightSensor::disable_reduced_light_sampling()
+{
+    event_loop.post(
+        [this]
+        {
+            if (reduced_sampling)
+            {
+                reduced_sampling = false;
+                duty_cycle_timeout->cancel();
+                activate_sensor();
             }
-        }).get();
+        });
 }
 
 void repowerd::UbuntuLightSensor::static_sensor_reading_callback(
@@ -78,10 +120,38 @@ void repowerd::UbuntuLightSensor::static_sensor_reading_callback(
     auto const uls = static_cast<UbuntuLightSensor*>(context);
     float light_value{0.0f};
     uas_light_event_get_light(event, &light_value);
-    uls->event_loop.enqueue([uls, light_value] { uls->handle_light_event(light_value); });
+    uls->event_loop.post([uls, light_value] { uls->handle_light_event(light_value); });
 }
 
 void repowerd::UbuntuLightSensor::handle_light_event(double light)
 {
+    // Ignore readings that were already queued when the sensor was turned off
+    if (!sensor_active)
+        return;
+
     handler(light);
+
+    if (reduced_sampling)
+    {
+        deactivate_sensor();
+        duty_cycle_timeout->arm_in(reduced_sampling_period);
+    }
+}
+
+void repowerd::UbuntuLightSensor::activate_sensor()
+{
+    if (!sensor_active)
+    {
+        ua_sensors_light_enable(sensor);
+        sensor_active = true;
+    }
+}
+
+void repowerd::UbuntuLightSensor::deactivate_sensor()
+{
+    if (sensor_active)
+    {
+        ua_sensors_light_disable(sensor);
+        sensor_active = false;
+    }
 }
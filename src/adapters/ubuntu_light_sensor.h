@@ -23,27 +23,41 @@
 
 #include <ubuntu/application/sensors/light.h>
 
+#include <memory>
+
 namespace repowerd
 {
 
+class Timeout;
+
 class UbuntuLightSensor : public LightSensor
 {
 public:
-    UbuntuLightSensor();
+    UbuntuLightSensor(std::shared_ptr<EventLoopReactor> const& event_loop_reactor);
+    ~UbuntuLightSensor();
 
     HandlerRegistration register_light_handler(LightHandler const& handler) override;
 
     void enable_light_events() override;
     void disable_light_events() override;
+    void enable_reduced_light_sampling() override;
+    void disable_reduced_light_sampling() override;
 
 private:
     static void static_sensor_reading_callback(UASLightEvent* event, void* context);
     void handle_light_event(double light_value);
+    void activate_sensor();
+    void deactivate_sensor();
 
     UASensorsLight* const sensor;
     EventLoop event_loop;
     LightHandler handler;
     bool enabled;
+    // With reduced sampling the sensor is turned off after each reading,
+    // and back on when the duty cycle timeout expires
+    bool reduced_sampling;
+    bool sensor_active;
+    std::unique_ptr<Timeout> duty_cycle_timeout;
 };
 
 }
@@ -17,6 +17,7 @@
  */
 
 #include "ubuntu_proximity_sensor.h"
+#include "device_config.h"
 #include "device_quirks.h"
 #include "event_loop_handler_registration.h"
 
@@ -30,19 +31,36 @@ namespace
 
 char const* const log_tag = "UbuntuProximitySensor";
 auto const null_handler = [](repowerd::ProximityState){};
+auto const state_cache_report_interval = std::chrono::hours{1};
 
 char const* proximity_state_to_cstr(repowerd::ProximityState state)
 {
     return state == repowerd::ProximityState::far ? "far" : "near";
 }
 
+std::chrono::milliseconds state_cache_window_from(repowerd::DeviceConfig const& device_config)
+{
+    try
+    {
+        return std::chrono::milliseconds{
+            std::stoi(device_config.get("proximityStateCacheMs", "0"))};
+    }
+    catch (...)
+    {
+        return std::chrono::milliseconds{0};
+    }
+}
+
 }
 
 repowerd::UbuntuProximitySensor::UbuntuProximitySensor(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
     std::shared_ptr<Log> const& log,
-    DeviceQuirks const& device_quirks)
+    DeviceQuirks const& device_quirks,
+    DeviceConfig const& device_config)
     : log{log},
       sensor{ua_sensors_proximity_new()},
+      event_loop{event_loop_reactor},
       handler{null_handler},
       synthetic_event_seqno{1},
       synthetic_event_delay{device_quirks.synthetic_initial_proximity_event_delay()},
@@ -50,8 +68,14 @@ repowerd::UbuntuProximitySensor::UbuntuProximitySensor(
           device_quirks.synthetic_initial_proximity_event_type() ==
               DeviceQuirks::ProximityEventType::far ?
                   ProximityState::far : ProximityState::near},
+      state_cache_window{state_cache_window_from(device_config)},
+      refresh_pending{false},
       is_state_valid{false},
-      state{ProximityState::far}
+      state{ProximityState::far},
+      has_reported_state{false},
+      cache_stats{0, 0, {}, {}},
+      report_start_time{std::chrono::steady_clock::now()},
+      report_start_stats{cache_stats}
 {
     if (!sensor)
         throw std::runtime_error("Failed to allocate proximity sensor");
@@ -59,6 +83,12 @@ repowerd::UbuntuProximitySensor::UbuntuProximitySensor(
     ua_sensors_proximity_set_reading_cb(sensor, static_sensor_reading_callback, this);
 }
 
+repowerd::UbuntuProximitySensor::~UbuntuProximitySensor()
+{
+    std::unique_lock<std::mutex> lock{state_mutex};
+    report_state_cache_stats(lock, std::chrono::steady_clock::now());
+}
+
 repowerd::HandlerRegistration repowerd::UbuntuProximitySensor::register_proximity_handler(
     ProximityHandler const& handler)
 {
@@ -70,8 +100,36 @@ repowerd::HandlerRegistration repowerd::UbuntuProximitySensor::register_proximit
 
 repowerd::ProximityState repowerd::UbuntuProximitySensor::proximity_state()
 {
+    auto const start = std::chrono::steady_clock::now();
+
     log->log(log_tag, "proximity_state()");
 
+    {
+        std::unique_lock<std::mutex> lock{state_mutex};
+
+        auto const state_age = start - state_time;
+
+        if (is_state_valid || (has_reported_state && state_age < state_cache_window))
+        {
+            auto const cached_state = state;
+            auto const needs_refresh =
+                !is_state_valid && state_age >= state_cache_window / 2;
+            lock.unlock();
+
+            // Refresh a cached state that is getting old in the background,
+            // so that the next query can still be answered from the cache
+            if (needs_refresh)
+                refresh_state_in_background();
+
+            record_state_query(true, start);
+
+            log->log(log_tag, "proximity_state() => %s (cached)",
+                     proximity_state_to_cstr(cached_state));
+
+            return cached_state;
+        }
+    }
+
     event_loop.enqueue(
         [this]
         {
@@ -80,12 +138,14 @@ repowerd::ProximityState repowerd::UbuntuProximitySensor::proximity_state()
 
     auto const valid_state = wait_for_valid_state();
 
-    event_loop.enqueue(
+    event_loop.post(
         [this]
         {
             disable_proximity_events_unqueued(EnablementMode::without_handler);
         });
 
+    record_state_query(false, start);
+
     log->log(log_tag, "proximity_state() => %s",
              proximity_state_to_cstr(valid_state));
 
@@ -120,6 +180,12 @@ void repowerd::UbuntuProximitySensor::emit_proximity_event(
     event_loop.enqueue([this, state] { handle_proximity_event(state); }).get();
 }
 
+repowerd::ProximityStateCacheStats repowerd::UbuntuProximitySensor::state_cache_stats()
+{
+    std::lock_guard<std::mutex> lock{state_mutex};
+    return cache_stats;
+}
+
 void repowerd::UbuntuProximitySensor::static_sensor_reading_callback(
     UASProximityEvent* event, void* context)
 {
@@ -129,7 +195,7 @@ void repowerd::UbuntuProximitySensor::static_sensor_reading_callback(
     auto const state = (distance == U_PROXIMITY_NEAR) ?
                        ProximityState::near : ProximityState::far;
 
-    ups->event_loop.enqueue([ups, state] { ups->handle_proximity_event(state); });
+    ups->event_loop.post([ups, state] { ups->handle_proximity_event(state); });
 }
 
 void repowerd::UbuntuProximitySensor::handle_proximity_event(ProximityState new_state)
@@ -150,11 +216,19 @@ void repowerd::UbuntuProximitySensor::handle_proximity_event(ProximityState new_
         std::lock_guard<std::mutex> lock{state_mutex};
         state = new_state;
         is_state_valid = true;
+        has_reported_state = true;
+        state_time = std::chrono::steady_clock::now();
         state_cv.notify_all();
     }
 
+    if (refresh_pending)
+    {
+        refresh_pending = false;
+        disable_proximity_events_unqueued(EnablementMode::refresh);
+    }
+
     if (should_invoke_handler())
-        handler(state);
+        handler(new_state);
 }
 
 void repowerd::UbuntuProximitySensor::enable_proximity_events_unqueued(
@@ -199,6 +273,70 @@ repowerd::ProximityState repowerd::UbuntuProximitySensor::wait_for_valid_state()
     return state;
 }
 
+void repowerd::UbuntuProximitySensor::refresh_state_in_background()
+{
+    event_loop.post(
+        [this]
+        {
+            if (refresh_pending)
+                return;
+
+            log->log(log_tag, "refresh_state_in_background()");
+
+            // The sensor is disabled again by the first event it reports
+            refresh_pending = true;
+            enable_proximity_events_unqueued(EnablementMode::refresh);
+        });
+}
+
+void repowerd::UbuntuProximitySensor::record_state_query(
+    bool hit, std::chrono::steady_clock::time_point start)
+{
+    auto const now = std::chrono::steady_clock::now();
+    auto const latency = std::chrono::duration_cast<std::chrono::microseconds>(now - start);
+
+    std::unique_lock<std::mutex> lock{state_mutex};
+
+    if (hit)
+    {
+        ++cache_stats.hits;
+        cache_stats.hit_latency += latency;
+    }
+    else
+    {
+        ++cache_stats.misses;
+        cache_stats.miss_latency += latency;
+    }
+
+    if (now - report_start_time >= state_cache_report_interval)
+        report_state_cache_stats(lock, now);
+}
+
+void repowerd::UbuntuProximitySensor::report_state_cache_stats(
+    std::unique_lock<std::mutex>& state_lock,
+    std::chrono::steady_clock::time_point now)
+{
+    auto const minutes = std::chrono::duration_cast<std::chrono::minutes>(
+        now - report_start_time);
+    auto const hits = cache_stats.hits - report_start_stats.hits;
+    auto const misses = cache_stats.misses - report_start_stats.misses;
+    auto const hit_latency = cache_stats.hit_latency - report_start_stats.hit_latency;
+    auto const miss_latency = cache_stats.miss_latency - report_start_stats.miss_latency;
+
+    report_start_time = now;
+    report_start_stats = cache_stats;
+
+    state_lock.unlock();
+
+    log->log(log_tag, "State queries in the last %lld minutes: "
+             "cache hits: %llu (avg %lldus), cache misses: %llu (avg %lldus)",
+             static_cast<long long>(minutes.count()),
+             static_cast<unsigned long long>(hits),
+             static_cast<long long>(hits ? hit_latency.count() / hits : 0),
+             static_cast<unsigned long long>(misses),
+             static_cast<long long>(misses ? miss_latency.count() / misses : 0));
+}
+
 void repowerd::UbuntuProximitySensor::schedule_synthetic_initial_event()
 {
     if (synthetic_event_delay.count() < 0 ||
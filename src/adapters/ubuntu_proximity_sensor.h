@@ -21,6 +21,8 @@
 #include "src/core/proximity_sensor.h"
 #include "event_loop.h"
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
@@ -31,15 +33,32 @@
 namespace repowerd
 {
 
+class DeviceConfig;
 class DeviceQuirks;
 class Log;
 
+struct ProximityStateCacheStats
+{
+    uint64_t hits;
+    uint64_t misses;
+    // Total time spent in proximity_state() calls
+    std::chrono::microseconds hit_latency;
+    std::chrono::microseconds miss_latency;
+};
+
 class UbuntuProximitySensor : public ProximitySensor
 {
 public:
+    // The proximity state is always current while the sensor is enabled.
+    // Otherwise it is cached for proximityStateCacheMs from the device
+    // config, which defaults to 0 (no caching), since a stale "far" state
+    // could let the display turn on while the device is near the face.
     UbuntuProximitySensor(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
         std::shared_ptr<Log> const& log,
-        DeviceQuirks const& device_quirks);
+        DeviceQuirks const& device_quirks,
+        DeviceConfig const& device_config);
+    ~UbuntuProximitySensor();
 
     HandlerRegistration register_proximity_handler(
         ProximityHandler const& handler) override;
@@ -50,14 +69,23 @@ public:
 
     void emit_proximity_event(ProximityState state);
 
+    // The stats are also logged every hour, along with queries, and when
+    // the sensor is destroyed
+    ProximityStateCacheStats state_cache_stats();
+
 private:
-    enum class EnablementMode{with_handler, without_handler};
+    enum class EnablementMode{with_handler, without_handler, refresh};
 
     static void static_sensor_reading_callback(UASProximityEvent* event, void* context);
     void handle_proximity_event(ProximityState state);
     void enable_proximity_events_unqueued(EnablementMode mode);
     void disable_proximity_events_unqueued(EnablementMode mode);
     ProximityState wait_for_valid_state();
+    void refresh_state_in_background();
+    void record_state_query(bool hit, std::chrono::steady_clock::time_point start);
+    void report_state_cache_stats(
+        std::unique_lock<std::mutex>& state_lock,
+        std::chrono::steady_clock::time_point now);
     void schedule_synthetic_initial_event();
     void invalidate_synthetic_initial_event();
 
@@ -75,10 +103,21 @@ private:
     std::chrono::milliseconds const synthetic_event_delay;
     ProximityState const synthetic_event_state;
 
+    std::chrono::milliseconds const state_cache_window;
+    bool refresh_pending;
+
     std::mutex state_mutex;
     std::condition_variable state_cv;
+    // Valid while the sensor is enabled and has reported a state
     bool is_state_valid;
     ProximityState state;
+    // When the state was last reported, for caching it after the sensor
+    // is disabled
+    bool has_reported_state;
+    std::chrono::steady_clock::time_point state_time;
+    ProximityStateCacheStats cache_stats;
+    std::chrono::steady_clock::time_point report_start_time;
+    ProximityStateCacheStats report_start_stats;
 };
 
 }
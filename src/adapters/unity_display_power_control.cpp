@@ -32,7 +32,7 @@ repowerd::UnityDisplayPowerControl::UnityDisplayPowerControl(
     std::shared_ptr<Log> const& log,
     std::string const& dbus_bus_address)
     : log{log},
-      dbus_connection{dbus_bus_address}
+      dbus_connection{DBusConnectionHandle::shared(dbus_bus_address)}
 {
 }
 
@@ -40,7 +40,10 @@ void repowerd::UnityDisplayPowerControl::turn_on()
 {
     log->log(log_tag, "turn_on()");
 
-    auto const reply = g_dbus_connection_call_sync(
+    // Don't wait for the reply, so that a slow compositor doesn't hold up
+    // the caller. Calls on the same connection are delivered in order, so
+    // TurnOn and TurnOff requests are still handled in the order made.
+    g_dbus_connection_call(
         dbus_connection,
         unity_display_bus_name,
         unity_display_object_path,
@@ -51,10 +54,8 @@ void repowerd::UnityDisplayPowerControl::turn_on()
         G_DBUS_CALL_FLAGS_NONE,
         /* timeout_msec */ 1000,
         nullptr,
+        nullptr,
         nullptr);
-
-    if (reply)
-        g_variant_unref(reply);
 }
 
 void repowerd::UnityDisplayPowerControl::turn_off()
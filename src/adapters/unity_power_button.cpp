@@ -28,8 +28,10 @@ char const* const dbus_power_button_interface = "com.canonical.Unity.PowerButton
 }
 
 repowerd::UnityPowerButton::UnityPowerButton(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
     std::string const& dbus_bus_address)
-    : dbus_connection{dbus_bus_address},
+    : dbus_connection{DBusConnectionHandle::shared(dbus_bus_address)},
+      dbus_event_loop{event_loop_reactor},
       power_button_handler{null_handler}
 {
 }
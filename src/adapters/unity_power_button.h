@@ -30,7 +30,9 @@ namespace repowerd
 class UnityPowerButton : public PowerButton, public PowerButtonEventSink
 {
 public:
-    UnityPowerButton(std::string const& dbus_bus_address);
+    UnityPowerButton(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
+        std::string const& dbus_bus_address);
 
     void start_processing() override;
 
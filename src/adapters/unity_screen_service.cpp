@@ -23,6 +23,7 @@
 #include "temporary_suspend_inhibition.h"
 #include "wakeup_service.h"
 
+#include "src/core/event_stats.h"
 #include "src/core/infinite_timeout.h"
 #include "src/core/log.h"
 #include "src/core/suspend_control.h"
@@ -138,6 +139,12 @@ char const* const unity_powerd_service_introspection = R"(
            autobrightness is supported, in that order -->
       <arg type='(iiiib)' name='params' direction="out" />
     </method>
+    <method name='getEventStats'>
+      <!-- Returns, for each daemon event type, its name and log2 histograms
+           (bucket i counts durations in [2^(i-1), 2^i) us) of the time
+           spent queued and the time spent handling the event -->
+      <arg type='a(satat)' name='stats' direction="out" />
+    </method>
     <signal name='Wakeup'>
     </signal>
   </interface>
@@ -146,8 +153,10 @@ char const* const unity_powerd_service_introspection = R"(
 }
 
 repowerd::UnityScreenService::UnityScreenService(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
     std::shared_ptr<WakeupService> const& wakeup_service,
     std::shared_ptr<BrightnessNotification> const& brightness_notification,
+    std::shared_ptr<EventStats> const& event_stats,
     std::shared_ptr<Log> const& log,
     std::shared_ptr<SuspendControl> const& suspend_control,
     std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
@@ -155,10 +164,12 @@ repowerd::UnityScreenService::UnityScreenService(
     std::string const& dbus_bus_address)
     : wakeup_service{wakeup_service},
       brightness_notification{brightness_notification},
+      event_stats{event_stats},
       suspend_control{suspend_control},
       temporary_suspend_inhibition{temporary_suspend_inhibition},
       log{log},
-      dbus_connection{dbus_bus_address},
+      dbus_connection{DBusConnectionHandle::shared(dbus_bus_address)},
+      dbus_event_loop{event_loop_reactor},
       disable_inactivity_timeout_handler{null_handler},
       enable_inactivity_timeout_handler{null_handler},
       set_inactivity_timeout_handler{null_arg_handler},
@@ -178,6 +189,8 @@ void repowerd::UnityScreenService::start_processing()
 {
     if (started) return;
 
+    DBusEventLoop::RegistrationBatch registration_batch;
+
     unity_screen_handler_registration = dbus_event_loop.register_object_handler(
         dbus_connection,
         dbus_screen_path,
@@ -233,19 +246,21 @@ void repowerd::UnityScreenService::start_processing()
                 method_name, parameters, invocation);
         });
 
+    registration_batch.finish();
+
     wakeup_handler_registration = wakeup_service->register_wakeup_handler(
         [this] (std::string const& cookie)
         {
             temporary_suspend_inhibition->inhibit_suspend_for(
                 std::chrono::seconds{3}, "Wakeup_" + cookie);
 
-            dbus_event_loop.enqueue([this] { dbus_emit_Wakeup(); });
+            dbus_event_loop.post([this] { dbus_emit_Wakeup(); });
         });
 
     brightness_handler_registration = brightness_notification->register_brightness_handler(
         [this] (double brightness)
         {
-            dbus_event_loop.enqueue([this,brightness] { dbus_emit_brightness(brightness); });
+            dbus_event_loop.post([this,brightness] { dbus_emit_brightness(brightness); });
         });
 
     dbus_connection.request_name(dbus_screen_service_name);
@@ -479,6 +494,10 @@ void repowerd::UnityScreenService::dbus_method_call(
                 params.default_value,
                 params.autobrightness_supported));
     }
+    else if (method_name == "getEventStats")
+    {
+        g_dbus_method_invocation_return_value(invocation, dbus_getEventStats());
+    }
     else
     {
         dbus_unknown_method(sender, method_name);
@@ -760,6 +779,39 @@ repowerd::BrightnessParams repowerd::UnityScreenService::dbus_getBrightnessParam
     return brightness_params;
 }
 
+GVariant* repowerd::UnityScreenService::dbus_getEventStats()
+{
+    log->log(log_tag, "dbus_getEventStats()");
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(satat)"));
+
+    for (size_t i = 0; i < DaemonEvent::num_types; ++i)
+    {
+        auto const type = static_cast<DaemonEvent::Type>(i);
+        auto const queue_latency = event_stats->queue_latency_histogram(type);
+        auto const handling_time = event_stats->handling_time_histogram(type);
+
+        GVariantBuilder queue_latency_builder;
+        g_variant_builder_init(&queue_latency_builder, G_VARIANT_TYPE("at"));
+        for (auto const count : queue_latency)
+            g_variant_builder_add(&queue_latency_builder, "t", static_cast<guint64>(count));
+
+        GVariantBuilder handling_time_builder;
+        g_variant_builder_init(&handling_time_builder, G_VARIANT_TYPE("at"));
+        for (auto const count : handling_time)
+            g_variant_builder_add(&handling_time_builder, "t", static_cast<guint64>(count));
+
+        g_variant_builder_add(
+            &builder, "(satat)",
+            DaemonEvent::type_name(type),
+            &queue_latency_builder,
+            &handling_time_builder);
+    }
+
+    return g_variant_new("(a(satat))", &builder);
+}
+
 void repowerd::UnityScreenService::dbus_emit_Wakeup()
 {
     log->log(log_tag, "dbus_emit_Wakeup()");
@@ -37,6 +37,7 @@ namespace repowerd
 {
 class BrightnessNotification;
 class DeviceConfig;
+class EventStats;
 class Log;
 class SuspendControl;
 class TemporarySuspendInhibition;
@@ -48,8 +49,10 @@ class UnityScreenService : public ClientRequests,
 {
 public:
     UnityScreenService(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
         std::shared_ptr<WakeupService> const& wakeup_service,
         std::shared_ptr<BrightnessNotification> const& brightness_notification,
+        std::shared_ptr<EventStats> const& event_stats,
         std::shared_ptr<Log> const& log,
         std::shared_ptr<SuspendControl> const& suspend_control,
         std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
@@ -125,6 +128,7 @@ private:
         uint64_t time);
     void dbus_clearWakeup(std::string const& sender, std::string const& cookie);
     BrightnessParams dbus_getBrightnessParams();
+    GVariant* dbus_getEventStats();
     void dbus_emit_Wakeup();
     void dbus_emit_brightness(double brightness);
 
@@ -132,6 +136,7 @@ private:
 
     std::shared_ptr<WakeupService> const wakeup_service;
     std::shared_ptr<BrightnessNotification> const brightness_notification;
+    std::shared_ptr<EventStats> const event_stats;
     std::shared_ptr<SuspendControl> const suspend_control;
     std::shared_ptr<TemporarySuspendInhibition> const temporary_suspend_inhibition;
     std::shared_ptr<Log> const log;
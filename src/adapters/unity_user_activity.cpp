@@ -37,8 +37,10 @@ repowerd::UserActivityType user_activity_type_from_dbus_value(int32_t value)
 }
 
 repowerd::UnityUserActivity::UnityUserActivity(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
     std::string const& dbus_bus_address)
-    : dbus_connection{dbus_bus_address},
+    : dbus_connection{DBusConnectionHandle::shared(dbus_bus_address)},
+      dbus_event_loop{event_loop_reactor},
       user_activity_handler{null_handler}
 {
 }
@@ -17,33 +17,18 @@
  */
 
 #include "upower_power_source.h"
-#include "device_config.h"
-#include "event_loop_handler_registration.h"
+#include "battery_tracker.h"
 #include "scoped_g_error.h"
-#include "temporary_suspend_inhibition.h"
 
 #include "src/core/log.h"
 
 namespace
 {
 char const* const log_tag = "UPowerPowerSource";
-auto const null_batteryinfo_handler = [](repowerd::BatteryInfo*){};
-auto const null_handler = []{};
 char const* const dbus_upower_name = "org.freedesktop.UPower";
 char const* const dbus_upower_path = "/org/freedesktop/UPower";
 char const* const dbus_upower_interface = "org.freedesktop.UPower";
 
-enum class DeviceState
-{ 
-    unknown = 0,
-    charging,
-    discharging,
-    empty,
-    fully_charged,
-    pending_charge,
-    pending_discharge
-};
-
 enum class DeviceType
 { 
     unknown = 0,
@@ -51,34 +36,82 @@ enum class DeviceType
     battery
 };
 
-double get_critical_temperature(repowerd::DeviceConfig const& device_config)
-try
+bool is_battery_property(std::string const& property)
 {
-    auto const ct_str = device_config.get("shutdownBatteryTemperature", "680");
-    return ((double)std::stoi(ct_str)) * 0.1;
+    return property == "IsPresent" || property == "State" ||
+           property == "Percentage" || property == "Temperature";
 }
-catch (...)
+
+// Applies the battery properties in properties_iter to battery_info,
+// ignoring properties not in the filter, unless the filter is empty
+void apply_battery_properties(
+    GVariantIter* properties_iter,
+    std::unordered_set<std::string> const& filter,
+    repowerd::BatteryInfo& battery_info)
 {
-    return 68.0;
+    char const* key_cstr{""};
+    GVariant* value{nullptr};
+
+    while (g_variant_iter_next(properties_iter, "{&sv}", &key_cstr, &value))
+    {
+        auto const key_str = std::string{key_cstr};
+
+        if (filter.empty() || filter.count(key_str))
+        {
+            if (key_str == "State")
+                battery_info.state = g_variant_get_uint32(value);
+            else if (key_str == "Percentage")
+                battery_info.percentage = g_variant_get_double(value);
+            else if (key_str == "Temperature")
+                battery_info.temperature = g_variant_get_double(value);
+            else if (key_str == "IsPresent")
+                battery_info.is_present = g_variant_get_boolean(value);
+        }
+
+        g_variant_unref(value);
+    }
 }
 
 }
 
+struct repowerd::UPowerPowerSource::DevicePropertiesRequest
+{
+    UPowerPowerSource* const upower_power_source;
+    std::string const device;
+    // The properties to update, or empty to add a new device
+    std::unordered_set<std::string> const properties;
+};
+
 repowerd::UPowerPowerSource::UPowerPowerSource(
+    std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
     std::shared_ptr<Log> const& log,
     std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
     DeviceConfig const& device_config,
     std::string const& dbus_bus_address)
     : log{log},
-      temporary_suspend_inhibition{temporary_suspend_inhibition},
-      critical_temperature{get_critical_temperature(device_config)},
-      dbus_connection{dbus_bus_address},
-      power_source_change_handler{null_handler},
-      power_source_critical_handler{null_handler},
-      power_source_level_change_handler{null_batteryinfo_handler}
+      dbus_connection{DBusConnectionHandle::shared(dbus_bus_address)},
+      dbus_event_loop{event_loop_reactor},
+      dbus_cancellable{g_cancellable_new()},
+      battery_tracker{
+          std::make_unique<BatteryTracker>(
+              log, temporary_suspend_inhibition, device_config, dbus_event_loop,
+              log_tag, [this] { return is_using_battery_power(); })}
 {
 }
 
+repowerd::UPowerPowerSource::~UPowerPowerSource()
+{
+    // Replies to our pending calls are handled in the loop thread, so
+    // cancelling from there ensures no reply handler runs after this point
+    dbus_event_loop.enqueue(
+        [this]
+        {
+            g_cancellable_cancel(dbus_cancellable);
+            battery_tracker.reset();
+        }).get();
+    g_object_unref(dbus_cancellable);
+}
+
 void repowerd::UPowerPowerSource::start_processing()
 {
     dbus_signal_handler_registration = dbus_event_loop.register_signal_handler(
@@ -107,29 +140,20 @@ repowerd::HandlerRegistration repowerd::UPowerPowerSource::register_power_source
     PowerSourceChangeHandler const& handler)
 {
     log->log(log_tag, "register_power_source_change_handler: %p", (void*)&handler);
-    return EventLoopHandlerRegistration{
-        dbus_event_loop,
-            [this, &handler] { this->power_source_change_handler = handler; },
-            [this] { this->power_source_change_handler = null_handler; }};
+    return battery_tracker->register_power_source_change_handler(handler);
 }
 
 repowerd::HandlerRegistration repowerd::UPowerPowerSource::register_power_source_critical_handler(
     PowerSourceCriticalHandler const& handler)
 {
-    return EventLoopHandlerRegistration{
-        dbus_event_loop,
-            [this, &handler] { this->power_source_critical_handler = handler; },
-            [this] { this->power_source_critical_handler = null_handler; }};
+    return battery_tracker->register_power_source_critical_handler(handler);
 }
 
 repowerd::HandlerRegistration repowerd::UPowerPowerSource::register_power_source_level_change_handler(
     PowerSourceLevelChangeHandler const& handler)
 {
     log->log(log_tag, "register_power_source_change_handler: %p", (void*)&handler);
-    return EventLoopHandlerRegistration{
-        dbus_event_loop,
-            [this, &handler] { this->power_source_level_change_handler = handler; },
-            [this] { this->power_source_level_change_handler = null_batteryinfo_handler; }};
+    return battery_tracker->register_power_source_level_change_handler(handler);
 }
 
 std::unordered_set<std::string> repowerd::UPowerPowerSource::tracked_batteries()
@@ -138,7 +162,7 @@ std::unordered_set<std::string> repowerd::UPowerPowerSource::tracked_batteries()
     dbus_event_loop.enqueue(
         [this, &ret_batteries]
         {
-            for (auto const& battery : batteries)
+            for (auto const& battery : battery_tracker->batteries())
                 ret_batteries.insert(battery.first);
         }).get();
     return ret_batteries;
@@ -159,14 +183,23 @@ void repowerd::UPowerPowerSource::handle_dbus_signal(
     {
         char const* properties_interface_cstr{""};
         GVariantIter* properties_iter;
+        GVariantIter* invalidated_iter;
         g_variant_get(parameters, "(&sa{sv}as)",
-                      &properties_interface_cstr, &properties_iter, nullptr);
+                      &properties_interface_cstr, &properties_iter, &invalidated_iter);
 
         std::string const properties_interface{properties_interface_cstr};
 
         if (properties_interface == "org.freedesktop.UPower.Device")
-            change_device(object_path, properties_iter);
+        {
+            std::unordered_set<std::string> invalidated_properties;
+            char const* property{""};
+            while (g_variant_iter_next(invalidated_iter, "&s", &property))
+                invalidated_properties.insert(property);
 
+            change_device(object_path, properties_iter, invalidated_properties);
+        }
+
+        g_variant_iter_free(invalidated_iter);
         g_variant_iter_free(properties_iter);
     }
     else if (signal_name == "DeviceAdded")
@@ -174,7 +207,8 @@ void repowerd::UPowerPowerSource::handle_dbus_signal(
         char const* device{""};
         g_variant_get(parameters, "(&o)", &device);
 
-        add_device_if_battery(device);
+        pending_devices.insert(device);
+        request_device_properties(device, {});
     }
     else if (signal_name == "DeviceRemoved")
     {
@@ -217,19 +251,22 @@ void repowerd::UPowerPowerSource::add_existing_batteries()
 
     char const* device{""};
     while (g_variant_iter_next(result_devices, "&o", &device))
-        add_device_if_battery(device);
+    {
+        auto const properties = get_device_properties(device);
+        if (properties)
+        {
+            add_device_if_battery(device, properties);
+            g_variant_unref(properties);
+        }
+    }
 
     g_variant_iter_free(result_devices);
     g_variant_unref(result);
 }
 
-void repowerd::UPowerPowerSource::add_device_if_battery(std::string const& device)
+void repowerd::UPowerPowerSource::add_device_if_battery(
+    std::string const& device, GVariant* properties)
 {
-    auto properties = get_device_properties(device);
-
-    if (!properties)
-        return;
-
     char const* key_cstr{""};
     GVariant* value{nullptr};
     BatteryInfo battery_info;
@@ -256,7 +293,6 @@ void repowerd::UPowerPowerSource::add_device_if_battery(std::string const& devic
     }
 
     g_variant_iter_free(properties_iter);
-    g_variant_unref(properties);
 
     if (device_type == static_cast<uint32_t>(DeviceType::battery))
     {
@@ -268,113 +304,49 @@ void repowerd::UPowerPowerSource::add_device_if_battery(std::string const& devic
                  battery_info.percentage,
                  battery_info.temperature);
 
-        batteries[device] = battery_info;
-        power_source_change_handler();
-        power_source_level_change_handler(&batteries[device]);
+        battery_tracker->add_battery(device, battery_info);
     }
 }
 
 void repowerd::UPowerPowerSource::remove_device(std::string const& device)
 {
+    pending_devices.erase(device);
+
+    auto const& batteries = battery_tracker->batteries();
     if (batteries.find(device) == batteries.end())
         return;
 
     log->log(log_tag, "remove_device(%s)", device.c_str());
 
-    batteries.erase(device);
+    battery_tracker->remove_battery(device);
 }
 
 void repowerd::UPowerPowerSource::change_device(
-    std::string const& device, GVariantIter* properties_iter)
+    std::string const& device,
+    GVariantIter* properties_iter,
+    std::unordered_set<std::string> const& invalidated_properties)
 {
-    if (batteries.find(device) == batteries.end())
+    auto const& batteries = battery_tracker->batteries();
+    auto const iter = batteries.find(device);
+    if (iter == batteries.end())
         return;
 
-    auto const old_info = batteries[device];
+    auto new_info = iter->second;
+    apply_battery_properties(properties_iter, {}, new_info);
 
-    char const* key_cstr{""};
-    GVariant* value{nullptr};
-    auto new_info = old_info;
+    battery_tracker->update_battery(device, new_info);
 
-    while (g_variant_iter_next(properties_iter, "{&sv}", &key_cstr, &value))
+    // Invalidated properties don't carry their new values, so fetch just
+    // those in the background instead of blocking on a round trip
+    std::unordered_set<std::string> stale_properties;
+    for (auto const& property : invalidated_properties)
     {
-        auto const key_str = std::string{key_cstr};
-
-        if (key_str == "State")
-            new_info.state = g_variant_get_uint32(value);
-        else if (key_str == "Percentage")
-            new_info.percentage = g_variant_get_double(value);
-        else if (key_str == "Temperature")
-            new_info.temperature = g_variant_get_double(value);
-        else if (key_str == "IsPresent")
-            new_info.is_present = g_variant_get_boolean(value);
-
-        g_variant_unref(value);
-    }
-
-    log->log(log_tag, "change_device(%s), "
-             "is_present=%d, state=%d, percentage=%.2f, temperature=%.2f",
-             device.c_str(),
-             new_info.is_present,
-             new_info.state,
-             new_info.percentage,
-             new_info.temperature);
-
-    batteries[device] = new_info;
-
-    bool critical{false};
-    bool change{false};
-
-    if (old_info.is_present != new_info.is_present)
-    {
-        change = true;
+        if (is_battery_property(property))
+            stale_properties.insert(property);
     }
 
-    if (new_info.is_present && old_info.state != new_info.state)
-    {
-        if (new_info.state == static_cast<uint32_t>(DeviceState::discharging) ||
-            (old_info.state == static_cast<uint32_t>(DeviceState::discharging) &&
-             (new_info.state == static_cast<uint32_t>(DeviceState::charging) ||
-              new_info.state == static_cast<uint32_t>(DeviceState::fully_charged) ||
-              new_info.state == static_cast<uint32_t>(DeviceState::pending_charge))))
-        {
-            change = true;
-        }
-    }
-
-    if (new_info.is_present && old_info.percentage != new_info.percentage)
-    {
-        if (new_info.percentage <= 1.0 && is_using_battery_power())
-        {
-            log->log(log_tag, "Battery energy percentage is at critical level %.1f%%\n",
-                     new_info.percentage);
-            critical = true;
-        }
-    }
-
-    if (new_info.is_present && old_info.temperature != new_info.temperature)
-    {
-        if (new_info.temperature >= critical_temperature)
-        {
-            log->log(log_tag, "Battery temperature is at critical level %.1f (limit is %.1f)\n",
-                     new_info.temperature, critical_temperature);
-            critical = true;
-        }
-    }
-
-    if (critical || change)
-    {
-        temporary_suspend_inhibition->inhibit_suspend_for(
-            std::chrono::seconds{2}, "UPowerPowerSource");
-    }
-
-    if (critical)
-        power_source_critical_handler();
-
-    if (change)
-        power_source_change_handler();
-
-    power_source_level_change_handler(&batteries[device]);
+    if (!stale_properties.empty())
+        request_device_properties(device, stale_properties);
 }
 
 GVariant* repowerd::UPowerPowerSource::get_device_properties(std::string const& device)
@@ -405,6 +377,81 @@ GVariant* repowerd::UPowerPowerSource::get_device_properties(std::string const&
     return result;
 }
 
+void repowerd::UPowerPowerSource::request_device_properties(
+    std::string const& device,
+    std::unordered_set<std::string> const& properties)
+{
+    int constexpr timeout_default = -1;
+
+    g_dbus_connection_call(
+        dbus_connection,
+        dbus_upower_name,
+        device.c_str(),
+        "org.freedesktop.DBus.Properties",
+        "GetAll",
+        g_variant_new("(s)", "org.freedesktop.UPower.Device"),
+        G_VARIANT_TYPE("(a{sv})"),
+        G_DBUS_CALL_FLAGS_NONE,
+        timeout_default,
+        dbus_cancellable,
+        &UPowerPowerSource::static_handle_device_properties,
+        new DevicePropertiesRequest{this, device, properties});
+}
+
+void repowerd::UPowerPowerSource::static_handle_device_properties(
+    GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    std::unique_ptr<DevicePropertiesRequest> const request{
+        static_cast<DevicePropertiesRequest*>(user_data)};
+    ScopedGError error;
+
+    auto const properties = g_dbus_connection_call_finish(
+        G_DBUS_CONNECTION(source), result, error);
+
+    if (!properties)
+    {
+        // The source may be gone if the call was cancelled
+        if (!error.matches(G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            request->upower_power_source->log->log(
+                log_tag, "handle_device_properties(%s) failed: %s",
+                request->device.c_str(), error.message_str().c_str());
+        }
+        return;
+    }
+
+    request->upower_power_source->handle_device_properties(*request, properties);
+
+    g_variant_unref(properties);
+}
+
+void repowerd::UPowerPowerSource::handle_device_properties(
+    DevicePropertiesRequest const& request, GVariant* properties)
+{
+    if (request.properties.empty())
+    {
+        // Skip devices removed while we were waiting for the reply
+        if (pending_devices.erase(request.device))
+            add_device_if_battery(request.device, properties);
+    }
+    else
+    {
+        auto const& batteries = battery_tracker->batteries();
+        auto const iter = batteries.find(request.device);
+        if (iter == batteries.end())
+            return;
+
+        auto new_info = iter->second;
+
+        GVariantIter* properties_iter;
+        g_variant_get(properties, "(a{sv})", &properties_iter);
+        apply_battery_properties(properties_iter, request.properties, new_info);
+        g_variant_iter_free(properties_iter);
+
+        battery_tracker->update_battery(request.device, new_info);
+    }
+}
+
 bool repowerd::UPowerPowerSource::is_using_battery_power()
 {
     int constexpr timeout = 1000;
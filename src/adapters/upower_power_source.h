@@ -23,11 +23,13 @@
 #include "dbus_connection_handle.h"
 #include "dbus_event_loop.h"
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
 namespace repowerd
 {
+class BatteryTracker;
 class Log;
 class DeviceConfig;
 class TemporarySuspendInhibition;
@@ -36,10 +38,12 @@ class UPowerPowerSource : public PowerSource
 {
 public:
     UPowerPowerSource(
+        std::shared_ptr<EventLoopReactor> const& event_loop_reactor,
         std::shared_ptr<Log> const& log,
         std::shared_ptr<TemporarySuspendInhibition> const& temporary_suspend_inhibition,
         DeviceConfig const& device_config,
         std::string const& dbus_bus_address);
+    ~UPowerPowerSource();
 
     void start_processing() override;
 
@@ -55,6 +59,8 @@ public:
     std::unordered_set<std::string> tracked_batteries();
 
 private:
+    struct DevicePropertiesRequest;
+
     void handle_dbus_signal(
         GDBusConnection* connection,
         gchar const* sender,
@@ -64,10 +70,20 @@ private:
         GVariant* parameters);
 
     void add_existing_batteries();
-    void add_device_if_battery(std::string const& device);
+    void add_device_if_battery(std::string const& device, GVariant* properties);
     void remove_device(std::string const& device);
-    void change_device(std::string const& device, GVariantIter* properties_iter);
+    void change_device(
+        std::string const& device,
+        GVariantIter* properties_iter,
+        std::unordered_set<std::string> const& invalidated_properties);
     GVariant* get_device_properties(std::string const& device);
+    void request_device_properties(
+        std::string const& device,
+        std::unordered_set<std::string> const& properties);
+    static void static_handle_device_properties(
+        GObject* source, GAsyncResult* result, gpointer user_data);
+    void handle_device_properties(
+        DevicePropertiesRequest const& request, GVariant* properties);
     bool is_using_battery_power();
     void disallow_suspend_temporarily();
 
@@ -80,18 +96,14 @@ private:
     };*/
 
     std::shared_ptr<Log> const log;
-    std::shared_ptr<TemporarySuspendInhibition> const temporary_suspend_inhibition;
-    double const critical_temperature;
 
     DBusConnectionHandle dbus_connection;
     DBusEventLoop dbus_event_loop;
     HandlerRegistration dbus_signal_handler_registration;
+    GCancellable* const dbus_cancellable;
+    std::unique_ptr<BatteryTracker> battery_tracker;
 
-    PowerSourceChangeHandler power_source_change_handler;
-    PowerSourceCriticalHandler power_source_critical_handler;
-    PowerSourceLevelChangeHandler power_source_level_change_handler;
-
-    std::unordered_map<std::string,BatteryInfo> batteries;
+    std::unordered_set<std::string> pending_devices;
 };
 
 }
@@ -20,9 +20,14 @@
 
 #include "handler_registration.h"
 
+#include <functional>
+
 namespace repowerd
 {
 
+// Brightness changes are requested asynchronously: the methods return
+// without waiting for the change (e.g. a brightness transition) to
+// complete, but requests are applied in the order they were made.
 class BrightnessControl
 {
 public:
@@ -33,7 +38,9 @@ public:
     virtual void set_dim_brightness() = 0;
     virtual void set_normal_brightness() = 0;
     virtual void set_normal_brightness_value(double) = 0;
-    virtual void set_off_brightness() = 0;
+    // Calls brightness_off, possibly from another thread, once the
+    // brightness has reached off or a later request has taken over from it
+    virtual void set_off_brightness(std::function<void()> const& brightness_off) = 0;
 
 protected:
     BrightnessControl() = default;
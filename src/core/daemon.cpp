@@ -18,56 +18,83 @@
 
 #include "daemon.h"
 
-#include "brightness_control.h"
 #include "client_requests.h"
 #include "display_power_control.h"
+#include "event_journal.h"
+#include "event_stats.h"
 #include "light_control.h"
 #include "notification_service.h"
 #include "power_button.h"
 #include "power_source.h"
 #include "proximity_sensor.h"
-#include "state_machine.h"
 #include "timer.h"
 #include "user_activity.h"
 #include "voice_call_service.h"
 
 #include <future>
 
+namespace
+{
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
 repowerd::Daemon::Daemon(DaemonConfig& config)
-    : brightness_control{config.the_brightness_control()},
+    : config(config),
       client_requests{config.the_client_requests()},
+      event_journal{config.the_event_journal()},
+      event_stats{config.the_event_stats()},
       light_control{config.the_light_control()},
       notification_service{config.the_notification_service()},
       power_button{config.the_power_button()},
       power_source{config.the_power_source()},
       proximity_sensor{config.the_proximity_sensor()},
-      state_machine{config.the_state_machine()},
       timer{config.the_timer()},
       user_activity{config.the_user_activity()},
       voice_call_service{config.the_voice_call_service()},
+      event_dispatcher{config.the_state_machine(), config.the_brightness_control()},
       running{false}
 {
+    // Each of these events supersedes any adjacent pending event of
+    // the same type, so only the last one of a run needs handling
+    event_queue.coalesce_adjacent(EventType::user_activity_extending_power_state);
+    event_queue.coalesce_adjacent(EventType::set_normal_brightness_value);
+
     if (config.turn_on_display_at_startup())
-        enqueue_action([this] { state_machine->handle_turn_on_display(); });
+        enqueue_event(DaemonEvent::of_type(EventType::turn_on_display));
 }
 
 void repowerd::Daemon::run()
 {
     auto const registrations = register_event_handlers();
-    start_event_processing();
+    config.run_event_processing_startup([this] { start_event_processing(); });
 
     running = true;
 
     while (running)
     {
-        auto const ev = dequeue_action();
-        ev();
+        auto const event = dequeue_event();
+        auto const dispatch_start_ns = now_ns();
+
+        dispatch_event(event);
+
+        auto const dispatch_end_ns = now_ns();
+
+        event_stats->record(
+            event.type,
+            std::chrono::nanoseconds{dispatch_start_ns - event.enqueue_time_ns},
+            std::chrono::nanoseconds{dispatch_end_ns - dispatch_start_ns});
     }
 }
 
 void repowerd::Daemon::stop()
 {
-    enqueue_priority_action([this] { running = false; });
+    enqueue_priority_event(DaemonEvent::of_type(EventType::stop));
 }
 
 void repowerd::Daemon::flush()
@@ -75,11 +102,16 @@ void repowerd::Daemon::flush()
     std::promise<void> flushed_promise;
     auto flushed_future = flushed_promise.get_future();
 
-    enqueue_action([&flushed_promise] { flushed_promise.set_value(); });
+    enqueue_event(DaemonEvent::flush(&flushed_promise));
 
     flushed_future.wait();
 }
 
+uint64_t repowerd::Daemon::num_coalesced_events(DaemonEvent::Type type) const
+{
+    return event_queue.num_coalesced(type);
+}
+
 std::vector<repowerd::HandlerRegistration>
 repowerd::Daemon::register_event_handlers()
 {
@@ -90,16 +122,16 @@ repowerd::Daemon::register_event_handlers()
             [this] (PowerButtonState state)
             {
                 if (state == PowerButtonState::pressed)
-                    enqueue_action([this] { state_machine->handle_power_button_press(); });
+                    enqueue_event(DaemonEvent::of_type(EventType::power_button_press));
                 else if (state == PowerButtonState::released)
-                    enqueue_action([this] { state_machine->handle_power_button_release(); } );
+                    enqueue_event(DaemonEvent::of_type(EventType::power_button_release));
             }));
 
     registrations.push_back(
         timer->register_alarm_handler(
             [this] (AlarmId id)
             {
-                enqueue_action([this, id] { state_machine->handle_alarm(id); });
+                enqueue_event(DaemonEvent::alarm(id));
             }));
 
     registrations.push_back(
@@ -108,13 +140,13 @@ repowerd::Daemon::register_event_handlers()
             {
                 if (type == UserActivityType::change_power_state)
                 {
-                    enqueue_action(
-                        [this] { state_machine->handle_user_activity_changing_power_state(); });
+                    enqueue_event(
+                        DaemonEvent::of_type(EventType::user_activity_changing_power_state));
                 }
                 else if (type == UserActivityType::extend_power_state)
                 {
-                    enqueue_action(
-                        [this] { state_machine->handle_user_activity_extending_power_state(); });
+                    enqueue_event(
+                        DaemonEvent::of_type(EventType::user_activity_extending_power_state));
                 }
             }));
 
@@ -123,121 +155,103 @@ repowerd::Daemon::register_event_handlers()
             [this] (ProximityState state)
             {
                 if (state == ProximityState::far)
-                {
-                    enqueue_action(
-                        [this] { state_machine->handle_proximity_far(); });
-                }
+                    enqueue_event(DaemonEvent::of_type(EventType::proximity_far));
                 else if (state == ProximityState::near)
-                {
-                    enqueue_action(
-                        [this] { state_machine->handle_proximity_near(); });
-                }
+                    enqueue_event(DaemonEvent::of_type(EventType::proximity_near));
             }));
 
     registrations.push_back(
         client_requests->register_enable_inactivity_timeout_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { state_machine->handle_enable_inactivity_timeout(); });
+                enqueue_event(DaemonEvent::of_type(EventType::enable_inactivity_timeout));
             }));
 
     registrations.push_back(
         client_requests->register_disable_inactivity_timeout_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { state_machine->handle_disable_inactivity_timeout(); });
+                enqueue_event(DaemonEvent::of_type(EventType::disable_inactivity_timeout));
             }));
 
     registrations.push_back(
         client_requests->register_set_inactivity_timeout_handler(
             [this] (std::chrono::milliseconds timeout)
             {
-                enqueue_action(
-                    [this,timeout] { state_machine->handle_set_inactivity_timeout(timeout); });
+                enqueue_event(DaemonEvent::set_inactivity_timeout(timeout));
             }));
 
     registrations.push_back(
         notification_service->register_notification_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { state_machine->handle_notification(); });
+                enqueue_event(DaemonEvent::of_type(EventType::notification));
             }));
 
     registrations.push_back(
         notification_service->register_no_notification_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { state_machine->handle_no_notification(); });
+                enqueue_event(DaemonEvent::of_type(EventType::no_notification));
             }));
 
     registrations.push_back(
         voice_call_service->register_active_call_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { state_machine->handle_active_call(); });
+                enqueue_event(DaemonEvent::of_type(EventType::active_call));
             }));
 
     registrations.push_back(
         voice_call_service->register_no_active_call_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { state_machine->handle_no_active_call(); });
+                enqueue_event(DaemonEvent::of_type(EventType::no_active_call));
             }));
 
     registrations.push_back(
         client_requests->register_set_normal_brightness_value_handler(
             [this] (double value)
             {
-                enqueue_action(
-                    [this,value] { brightness_control->set_normal_brightness_value(value); });
+                enqueue_event(DaemonEvent::set_normal_brightness_value(value));
             }));
 
     registrations.push_back(
         client_requests->register_disable_autobrightness_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { brightness_control->disable_autobrightness(); });
+                enqueue_event(DaemonEvent::of_type(EventType::disable_autobrightness));
             }));
 
     registrations.push_back(
         client_requests->register_enable_autobrightness_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { brightness_control->enable_autobrightness(); });
+                enqueue_event(DaemonEvent::of_type(EventType::enable_autobrightness));
             }));
 
     registrations.push_back(
         power_source->register_power_source_change_handler(
             [this]
             {
-                enqueue_action(
-                    [this] {
-                    state_machine->handle_power_source_change(); });
+                enqueue_event(DaemonEvent::of_type(EventType::power_source_change));
             }));
 
     registrations.push_back(
         power_source->register_power_source_level_change_handler(
             [this] (repowerd::BatteryInfo * value)
             {
-                enqueue_action(
-                    [this,value] {
-                    state_machine->handle_power_source_level_change(value); });
+                // Snapshot the battery info, since the power source may
+                // update it before the event is handled
+                if (value)
+                    enqueue_event(DaemonEvent::power_source_level_change(*value));
             }));
 
     registrations.push_back(
         power_source->register_power_source_critical_handler(
             [this]
             {
-                enqueue_action(
-                    [this] { state_machine->handle_power_source_critical(); });
+                enqueue_event(DaemonEvent::of_type(EventType::power_source_critical));
             }));
 
     return registrations;
@@ -254,28 +268,39 @@ void repowerd::Daemon::start_event_processing()
     light_control->start_processing(); // currently empty
 }
 
-void repowerd::Daemon::enqueue_action(Action const& action)
+void repowerd::Daemon::enqueue_event(DaemonEvent const& event)
 {
-    std::lock_guard<std::mutex> lock{action_queue_mutex};
-
-    action_queue.push_back(action);
-    action_queue_cv.notify_one();
+    auto stamped_event = event;
+    stamped_event.enqueue_time_ns = now_ns();
+    event_journal->record(stamped_event);
+    event_queue.enqueue(stamped_event);
 }
 
-void repowerd::Daemon::enqueue_priority_action(Action const& action)
+void repowerd::Daemon::enqueue_priority_event(DaemonEvent const& event)
 {
-    std::lock_guard<std::mutex> lock{action_queue_mutex};
-
-    action_queue.push_front(action);
-    action_queue_cv.notify_one();
+    auto stamped_event = event;
+    stamped_event.enqueue_time_ns = now_ns();
+    event_journal->record(stamped_event);
+    event_queue.enqueue_priority(stamped_event);
 }
 
-repowerd::Daemon::Action repowerd::Daemon::dequeue_action()
+repowerd::DaemonEvent repowerd::Daemon::dequeue_event()
 {
-    std::unique_lock<std::mutex> lock{action_queue_mutex};
+    return event_queue.dequeue();
+}
 
-    action_queue_cv.wait(lock, [this] { return !action_queue.empty(); });
-    auto ev = action_queue.front();
-    action_queue.pop_front();
-    return ev;
+void repowerd::Daemon::dispatch_event(DaemonEvent const& event)
+{
+    switch (event.type)
+    {
+    case EventType::flush:
+        event.payload.flushed_promise->set_value();
+        break;
+    case EventType::stop:
+        running = false;
+        break;
+    default:
+        event_dispatcher.dispatch(event);
+        break;
+    }
 }
@@ -19,14 +19,12 @@
 #pragma once
 
 #include "daemon_config.h"
+#include "daemon_event_dispatcher.h"
+#include "event_queue.h"
 #include "handler_registration.h"
 
 #include <memory>
 #include <vector>
-#include <deque>
-#include <mutex>
-#include <condition_variable>
-#include <functional>
 
 namespace repowerd
 {
@@ -40,32 +38,37 @@ public:
     void stop();
     void flush();
 
+    // Number of events dropped because they were coalesced with a
+    // later event of the same type
+    uint64_t num_coalesced_events(DaemonEvent::Type type) const;
+
 private:
-    using Action = std::function<void()>;
+    using EventType = DaemonEvent::Type;
 
     std::vector<HandlerRegistration> register_event_handlers();
     void start_event_processing();
-    void enqueue_action(Action const& event);
-    void enqueue_priority_action(Action const& event);
-    Action dequeue_action();
+    void enqueue_event(DaemonEvent const& event);
+    void enqueue_priority_event(DaemonEvent const& event);
+    DaemonEvent dequeue_event();
+    void dispatch_event(DaemonEvent const& event);
 
-    std::shared_ptr<BrightnessControl> const brightness_control;
+    DaemonConfig& config;
     std::shared_ptr<ClientRequests> const client_requests;
+    std::shared_ptr<EventJournal> const event_journal;
+    std::shared_ptr<EventStats> const event_stats;
     std::shared_ptr<LightControl> const light_control;
     std::shared_ptr<NotificationService> const notification_service;
     std::shared_ptr<PowerButton> const power_button;
     std::shared_ptr<PowerSource> const power_source;
     std::shared_ptr<ProximitySensor> const proximity_sensor;
-    std::shared_ptr<StateMachine> const state_machine;
     std::shared_ptr<Timer> const timer;
     std::shared_ptr<UserActivity> const user_activity;
     std::shared_ptr<VoiceCallService> const voice_call_service;
 
+    DaemonEventDispatcher event_dispatcher;
     bool running;
 
-    std::mutex action_queue_mutex;
-    std::condition_variable action_queue_cv;
-    std::deque<Action> action_queue;
+    EventQueue event_queue;
 };
 
 }
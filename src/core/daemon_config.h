@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <chrono>
+#include <functional>
 
 namespace repowerd
 {
@@ -28,6 +29,8 @@ class BrightnessControl;
 class ClientRequests;
 class DisplayPowerControl;
 class DisplayPowerEventSink;
+class EventJournal;
+class EventStats;
 class Log;
 class ModemPowerControl;
 class NotificationService;
@@ -53,6 +56,8 @@ public:
     virtual std::shared_ptr<ClientRequests> the_client_requests() = 0;
     virtual std::shared_ptr<DisplayPowerControl> the_display_power_control() = 0;
     virtual std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() = 0;
+    virtual std::shared_ptr<EventJournal> the_event_journal() = 0;
+    virtual std::shared_ptr<EventStats> the_event_stats() = 0;
     virtual std::shared_ptr<Log> the_log() = 0;
     virtual std::shared_ptr<ModemPowerControl> the_modem_power_control() = 0;
     virtual std::shared_ptr<NotificationService> the_notification_service() = 0;
@@ -78,6 +83,11 @@ public:
 
     virtual bool turn_on_display_at_startup() = 0;
 
+    // Calls start_event_processing, which starts all event sources, letting
+    // the config batch any startup work that the sources share
+    virtual void run_event_processing_startup(
+        std::function<void()> const& start_event_processing) = 0;
+
 protected:
     DaemonConfig() = default;
     DaemonConfig(DaemonConfig const&) = delete;
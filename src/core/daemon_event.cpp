@@ -0,0 +1,51 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "daemon_event.h"
+
+char const* repowerd::DaemonEvent::type_name(Type type)
+{
+    switch (type)
+    {
+    case Type::alarm: return "alarm";
+    case Type::active_call: return "active_call";
+    case Type::no_active_call: return "no_active_call";
+    case Type::enable_inactivity_timeout: return "enable_inactivity_timeout";
+    case Type::disable_inactivity_timeout: return "disable_inactivity_timeout";
+    case Type::set_inactivity_timeout: return "set_inactivity_timeout";
+    case Type::no_notification: return "no_notification";
+    case Type::notification: return "notification";
+    case Type::power_button_press: return "power_button_press";
+    case Type::power_button_release: return "power_button_release";
+    case Type::power_source_change: return "power_source_change";
+    case Type::power_source_critical: return "power_source_critical";
+    case Type::power_source_level_change: return "power_source_level_change";
+    case Type::proximity_far: return "proximity_far";
+    case Type::proximity_near: return "proximity_near";
+    case Type::turn_on_display: return "turn_on_display";
+    case Type::user_activity_changing_power_state: return "user_activity_changing_power_state";
+    case Type::user_activity_extending_power_state: return "user_activity_extending_power_state";
+    case Type::disable_autobrightness: return "disable_autobrightness";
+    case Type::enable_autobrightness: return "enable_autobrightness";
+    case Type::set_normal_brightness_value: return "set_normal_brightness_value";
+    case Type::flush: return "flush";
+    case Type::stop: return "stop";
+    }
+
+    return "unknown";
+}
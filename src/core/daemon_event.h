@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "alarm_id.h"
+#include "power_source.h"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <type_traits>
+
+namespace repowerd
+{
+
+// A compact record of an event entering the Daemon. Events are plain
+// data, so they can be stored inline in preallocated queue nodes without
+// any heap allocations on the event delivery path.
+struct DaemonEvent
+{
+    enum class Type : uint8_t
+    {
+        alarm,
+        active_call,
+        no_active_call,
+        enable_inactivity_timeout,
+        disable_inactivity_timeout,
+        set_inactivity_timeout,
+        no_notification,
+        notification,
+        power_button_press,
+        power_button_release,
+        power_source_change,
+        power_source_critical,
+        power_source_level_change,
+        proximity_far,
+        proximity_near,
+        turn_on_display,
+        user_activity_changing_power_state,
+        user_activity_extending_power_state,
+        disable_autobrightness,
+        enable_autobrightness,
+        set_normal_brightness_value,
+        flush,
+        stop // must remain the last type
+    };
+
+    static size_t constexpr num_types{static_cast<size_t>(Type::stop) + 1};
+
+    union Payload
+    {
+        int alarm_id;
+        std::chrono::milliseconds::rep timeout_ms;
+        double brightness_value;
+        BatteryInfo battery_info;
+        std::promise<void>* flushed_promise;
+    };
+
+    static char const* type_name(Type type);
+
+    Type type;
+    Payload payload;
+    // Monotonic time at which the event was enqueued
+    int64_t enqueue_time_ns;
+
+    static DaemonEvent of_type(Type type)
+    {
+        DaemonEvent event;
+        event.type = type;
+        event.enqueue_time_ns = 0;
+        return event;
+    }
+
+    static DaemonEvent alarm(AlarmId id)
+    {
+        auto event = of_type(Type::alarm);
+        event.payload.alarm_id = id;
+        return event;
+    }
+
+    static DaemonEvent set_inactivity_timeout(std::chrono::milliseconds timeout)
+    {
+        auto event = of_type(Type::set_inactivity_timeout);
+        event.payload.timeout_ms = timeout.count();
+        return event;
+    }
+
+    static DaemonEvent power_source_level_change(BatteryInfo const& battery_info)
+    {
+        auto event = of_type(Type::power_source_level_change);
+        event.payload.battery_info = battery_info;
+        return event;
+    }
+
+    static DaemonEvent set_normal_brightness_value(double value)
+    {
+        auto event = of_type(Type::set_normal_brightness_value);
+        event.payload.brightness_value = value;
+        return event;
+    }
+
+    static DaemonEvent flush(std::promise<void>* flushed_promise)
+    {
+        auto event = of_type(Type::flush);
+        event.payload.flushed_promise = flushed_promise;
+        return event;
+    }
+};
+
+static_assert(std::is_trivially_copyable<DaemonEvent>::value,
+              "DaemonEvent must be trivially copyable");
+
+}
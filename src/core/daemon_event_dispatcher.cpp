@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "daemon_event_dispatcher.h"
+#include "daemon_event.h"
+
+#include "brightness_control.h"
+#include "state_machine.h"
+
+namespace
+{
+using EventType = repowerd::DaemonEvent::Type;
+}
+
+repowerd::DaemonEventDispatcher::DaemonEventDispatcher(
+    std::shared_ptr<StateMachine> const& state_machine,
+    std::shared_ptr<BrightnessControl> const& brightness_control)
+    : state_machine{state_machine},
+      brightness_control{brightness_control}
+{
+}
+
+void repowerd::DaemonEventDispatcher::dispatch(DaemonEvent const& event)
+{
+    switch (event.type)
+    {
+    case EventType::alarm:
+        state_machine->handle_alarm(event.payload.alarm_id);
+        break;
+    case EventType::active_call:
+        state_machine->handle_active_call();
+        break;
+    case EventType::no_active_call:
+        state_machine->handle_no_active_call();
+        break;
+    case EventType::enable_inactivity_timeout:
+        state_machine->handle_enable_inactivity_timeout();
+        break;
+    case EventType::disable_inactivity_timeout:
+        state_machine->handle_disable_inactivity_timeout();
+        break;
+    case EventType::set_inactivity_timeout:
+        state_machine->handle_set_inactivity_timeout(
+            std::chrono::milliseconds{event.payload.timeout_ms});
+        break;
+    case EventType::no_notification:
+        state_machine->handle_no_notification();
+        break;
+    case EventType::notification:
+        state_machine->handle_notification();
+        break;
+    case EventType::power_button_press:
+        state_machine->handle_power_button_press();
+        break;
+    case EventType::power_button_release:
+        state_machine->handle_power_button_release();
+        break;
+    case EventType::power_source_change:
+        state_machine->handle_power_source_change();
+        break;
+    case EventType::power_source_critical:
+        state_machine->handle_power_source_critical();
+        break;
+    case EventType::power_source_level_change:
+    {
+        auto battery_info = event.payload.battery_info;
+        state_machine->handle_power_source_level_change(&battery_info);
+        break;
+    }
+    case EventType::proximity_far:
+        state_machine->handle_proximity_far();
+        break;
+    case EventType::proximity_near:
+        state_machine->handle_proximity_near();
+        break;
+    case EventType::turn_on_display:
+        state_machine->handle_turn_on_display();
+        break;
+    case EventType::user_activity_changing_power_state:
+        state_machine->handle_user_activity_changing_power_state();
+        break;
+    case EventType::user_activity_extending_power_state:
+        state_machine->handle_user_activity_extending_power_state();
+        break;
+    case EventType::disable_autobrightness:
+        brightness_control->disable_autobrightness();
+        break;
+    case EventType::enable_autobrightness:
+        brightness_control->enable_autobrightness();
+        break;
+    case EventType::set_normal_brightness_value:
+        brightness_control->set_normal_brightness_value(event.payload.brightness_value);
+        break;
+    case EventType::flush:
+    case EventType::stop:
+        break;
+    }
+}
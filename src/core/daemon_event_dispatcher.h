@@ -0,0 +1,46 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <memory>
+
+namespace repowerd
+{
+
+class BrightnessControl;
+class StateMachine;
+struct DaemonEvent;
+
+// Delivers daemon events to the state machine and brightness control.
+// Events that concern the daemon itself (flush, stop) are ignored.
+class DaemonEventDispatcher
+{
+public:
+    DaemonEventDispatcher(
+        std::shared_ptr<StateMachine> const& state_machine,
+        std::shared_ptr<BrightnessControl> const& brightness_control);
+
+    void dispatch(DaemonEvent const& event);
+
+private:
+    std::shared_ptr<StateMachine> const state_machine;
+    std::shared_ptr<BrightnessControl> const brightness_control;
+};
+
+}
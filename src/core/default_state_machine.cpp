@@ -32,11 +32,28 @@
 #include "suspend_control.h"
 #include "timer.h"
 
+#include <mutex>
+
 namespace
 {
 char const* const log_tag = "DefaultStateMachine";
 char const* const suspend_id = "DefaultStateMachine";
+
+// Alarms that don't need to be exact may fire a little late, so that the
+// timer can fire them together with other alarms and save wakeups
+std::chrono::milliseconds slack_for(std::chrono::milliseconds timeout)
+{
+    return std::min(timeout / 20, std::chrono::milliseconds{1000});
 }
+}
+
+struct repowerd::DefaultStateMachine::DisplayOffSequence
+{
+    std::mutex mutex;
+    // Bumped whenever the display is turned on, so that a pending power
+    // off from an earlier turn_off_display() doesn't take effect after it
+    uint64_t seqno{0};
+};
 
 repowerd::DefaultStateMachine::DefaultStateMachine(DaemonConfig& config)
     : brightness_control{config.the_brightness_control()},
@@ -51,6 +68,7 @@ repowerd::DefaultStateMachine::DefaultStateMachine(DaemonConfig& config)
       shutdown_control{config.the_shutdown_control()},
       suspend_control{config.the_suspend_control()},
       timer{config.the_timer()},
+      display_off_sequence{std::make_shared<DisplayOffSequence>()},
       display_power_mode{DisplayPowerMode::off},
       display_power_mode_at_power_button_press{DisplayPowerMode::unknown},
       power_button_long_press_alarm_id{AlarmId::invalid},
@@ -85,6 +103,12 @@ void repowerd::DefaultStateMachine::handle_alarm(AlarmId id)
     }
     else if (id == user_inactivity_display_dim_alarm_id)
     {
+        if (rearm_if_early(user_inactivity_display_dim_alarm_id,
+                           user_inactivity_display_dim_time_point))
+        {
+            return;
+        }
+
         log->log(log_tag, "handle_alarm(display_dim)");
         user_inactivity_display_dim_alarm_id = AlarmId::invalid;
         if (is_inactivity_timeout_application_allowed())
@@ -92,6 +116,12 @@ void repowerd::DefaultStateMachine::handle_alarm(AlarmId id)
     }
     else if (id == user_inactivity_display_off_alarm_id)
     {
+        if (rearm_if_early(user_inactivity_display_off_alarm_id,
+                           user_inactivity_display_off_time_point))
+        {
+            return;
+        }
+
         log->log(log_tag, "handle_alarm(display_off)");
         user_inactivity_display_off_alarm_id = AlarmId::invalid;
         if (is_inactivity_timeout_application_allowed())
@@ -377,6 +407,7 @@ void repowerd::DefaultStateMachine::cancel_user_inactivity_alarm()
         user_inactivity_display_off_alarm_id = AlarmId::invalid;
     }
 
+    user_inactivity_display_dim_time_point = {};
     user_inactivity_display_off_time_point = {};
     scheduled_timeout_type = ScheduledTimeoutType::none;
 }
@@ -392,7 +423,12 @@ void repowerd::DefaultStateMachine::cancel_notification_expiration_alarm()
 
 void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_alarm()
 {
-    cancel_user_inactivity_alarm();
+    if (scheduled_timeout_type != ScheduledTimeoutType::normal ||
+        user_inactivity_normal_display_off_timeout == repowerd::infinite_timeout)
+    {
+        cancel_user_inactivity_alarm();
+    }
+
     scheduled_timeout_type = ScheduledTimeoutType::normal;
 
     if (user_inactivity_normal_display_off_timeout == repowerd::infinite_timeout)
@@ -401,18 +437,29 @@ void repowerd::DefaultStateMachine::schedule_normal_user_inactivity_alarm()
         return;
     }
 
-    user_inactivity_display_off_time_point =
-        timer->now() + user_inactivity_normal_display_off_timeout;
+    // User activity usually just moves the inactivity deadlines forward,
+    // in which case the already scheduled alarms are kept, and re-arm
+    // themselves for the remaining time when they fire
+    auto const off_time_point = timer->now() + user_inactivity_normal_display_off_timeout;
+
     if (user_inactivity_normal_display_off_timeout > user_inactivity_normal_display_dim_duration)
     {
-        user_inactivity_display_dim_alarm_id =
-            timer->schedule_alarm_in(
-                user_inactivity_normal_display_off_timeout -
-                user_inactivity_normal_display_dim_duration);
+        move_user_inactivity_alarm(
+            user_inactivity_display_dim_alarm_id,
+            user_inactivity_display_dim_time_point,
+            off_time_point - user_inactivity_normal_display_dim_duration);
+    }
+    else if (user_inactivity_display_dim_alarm_id != AlarmId::invalid)
+    {
+        timer->cancel_alarm(user_inactivity_display_dim_alarm_id);
+        user_inactivity_display_dim_alarm_id = AlarmId::invalid;
+        user_inactivity_display_dim_time_point = {};
     }
 
-    user_inactivity_display_off_alarm_id =
-        timer->schedule_alarm_in(user_inactivity_normal_display_off_timeout);
+    move_user_inactivity_alarm(
+        user_inactivity_display_off_alarm_id,
+        user_inactivity_display_off_time_point,
+        off_time_point);
 }
 
 void repowerd::DefaultStateMachine::schedule_post_notification_user_inactivity_alarm()
@@ -422,7 +469,9 @@ void repowerd::DefaultStateMachine::schedule_post_notification_user_inactivity_a
     {
         cancel_user_inactivity_alarm();
         user_inactivity_display_off_alarm_id =
-            timer->schedule_alarm_in(user_inactivity_post_notification_display_off_timeout);
+            timer->schedule_alarm_in(
+                user_inactivity_post_notification_display_off_timeout,
+                slack_for(user_inactivity_post_notification_display_off_timeout));
         user_inactivity_display_off_time_point = tp;
         scheduled_timeout_type = ScheduledTimeoutType::post_notification;
     }
@@ -435,7 +484,9 @@ void repowerd::DefaultStateMachine::schedule_reduced_user_inactivity_alarm()
     {
         cancel_user_inactivity_alarm();
         user_inactivity_display_off_alarm_id =
-            timer->schedule_alarm_in(user_inactivity_reduced_display_off_timeout);
+            timer->schedule_alarm_in(
+                user_inactivity_reduced_display_off_timeout,
+                slack_for(user_inactivity_reduced_display_off_timeout));
         user_inactivity_display_off_time_point = tp;
         scheduled_timeout_type = ScheduledTimeoutType::reduced;
     }
@@ -447,7 +498,9 @@ void repowerd::DefaultStateMachine::schedule_proximity_disable_alarm()
         timer->cancel_alarm(proximity_disable_alarm_id);
 
     proximity_disable_alarm_id =
-        timer->schedule_alarm_in(user_inactivity_reduced_display_off_timeout);
+        timer->schedule_alarm_in(
+            user_inactivity_reduced_display_off_timeout,
+            slack_for(user_inactivity_reduced_display_off_timeout));
 }
 
 void repowerd::DefaultStateMachine::schedule_notification_expiration_alarm()
@@ -460,7 +513,7 @@ void repowerd::DefaultStateMachine::schedule_notification_expiration_alarm()
             notification_expiration_timeout);
 
     notification_expiration_alarm_id =
-        timer->schedule_alarm_in(timeout);
+        timer->schedule_alarm_in(timeout, slack_for(timeout));
 }
 
 void repowerd::DefaultStateMachine::schedule_immediate_user_inactivity_alarm()
@@ -476,11 +529,66 @@ void repowerd::DefaultStateMachine::schedule_immediate_user_inactivity_alarm()
     }
 }
 
+void repowerd::DefaultStateMachine::move_user_inactivity_alarm(
+    AlarmId& alarm_id,
+    std::chrono::steady_clock::time_point& alarm_time_point,
+    std::chrono::steady_clock::time_point new_time_point)
+{
+    if (alarm_id != AlarmId::invalid && new_time_point < alarm_time_point)
+    {
+        timer->cancel_alarm(alarm_id);
+        alarm_id = AlarmId::invalid;
+    }
+
+    if (alarm_id == AlarmId::invalid)
+    {
+        auto const timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+            new_time_point - timer->now());
+        alarm_id = timer->schedule_alarm_in(timeout, slack_for(timeout));
+    }
+
+    alarm_time_point = new_time_point;
+}
+
+bool repowerd::DefaultStateMachine::rearm_if_early(
+    AlarmId& alarm_id,
+    std::chrono::steady_clock::time_point alarm_time_point)
+{
+    auto const now = timer->now();
+    if (now >= alarm_time_point)
+        return false;
+
+    // Round up, so that the re-armed alarm doesn't fire early again
+    auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(alarm_time_point - now);
+    if (now + remaining < alarm_time_point)
+        ++remaining;
+
+    alarm_id = timer->schedule_alarm_in(remaining, slack_for(remaining));
+
+    return true;
+}
+
 void repowerd::DefaultStateMachine::turn_off_display(
     DisplayPowerChangeReason reason)
 {
-    brightness_control->set_off_brightness();
-    display_power_control->turn_off();
+    // Power off the display, and allow suspend, only once the fade to off
+    // has finished, and only if the display wasn't turned on meanwhile
+    brightness_control->set_off_brightness(
+        [sequence = display_off_sequence,
+         seqno = display_off_sequence->seqno,
+         display_power_control = display_power_control,
+         suspend_control = suspend_control,
+         allow_suspend = reason != DisplayPowerChangeReason::proximity]
+        {
+            std::lock_guard<std::mutex> lock{sequence->mutex};
+            if (sequence->seqno != seqno)
+                return;
+
+            display_power_control->turn_off();
+            if (allow_suspend)
+                suspend_control->allow_suspend(suspend_id);
+        });
     if (reason != DisplayPowerChangeReason::proximity)
         modem_power_control->set_low_power_mode();
     display_power_mode = DisplayPowerMode::off;
@@ -488,17 +596,19 @@ void repowerd::DefaultStateMachine::turn_off_display(
     cancel_user_inactivity_alarm();
     display_power_event_sink->notify_display_power_off(reason);
     performance_booster->disable_interactive_mode();
-    if (reason != DisplayPowerChangeReason::proximity)
-        suspend_control->allow_suspend(suspend_id);
     light_control->notify_display_state(LightControl::DisplayOff);
 }
 
 void repowerd::DefaultStateMachine::turn_on_display_without_timeout(
     DisplayPowerChangeReason reason)
 {
-    suspend_control->disallow_suspend(suspend_id);
-    performance_booster->enable_interactive_mode();
-    display_power_control->turn_on();
+    {
+        std::lock_guard<std::mutex> lock{display_off_sequence->mutex};
+        ++display_off_sequence->seqno;
+        suspend_control->disallow_suspend(suspend_id);
+        performance_booster->enable_interactive_mode();
+        display_power_control->turn_on();
+    }
     display_power_mode = DisplayPowerMode::on;
     display_power_mode_reason = reason;
     brighten_display();
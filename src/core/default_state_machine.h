@@ -24,6 +24,7 @@
 #include "display_power_change_reason.h"
 
 #include <array>
+#include <memory>
 
 namespace repowerd
 {
@@ -75,6 +76,7 @@ private:
     };
     using ProximityEnablement = ProximityEnablementEnum::Enablement;
     enum class ScheduledTimeoutType {none, normal, post_notification, reduced};
+    struct DisplayOffSequence;
 
     void cancel_user_inactivity_alarm();
     void cancel_notification_expiration_alarm();
@@ -84,6 +86,13 @@ private:
     void schedule_proximity_disable_alarm();
     void schedule_notification_expiration_alarm();
     void schedule_immediate_user_inactivity_alarm();
+    void move_user_inactivity_alarm(
+        AlarmId& alarm_id,
+        std::chrono::steady_clock::time_point& alarm_time_point,
+        std::chrono::steady_clock::time_point new_time_point);
+    bool rearm_if_early(
+        AlarmId& alarm_id,
+        std::chrono::steady_clock::time_point alarm_time_point);
     void turn_off_display(DisplayPowerChangeReason reason);
     void turn_on_display_without_timeout(DisplayPowerChangeReason reason);
     void turn_on_display_with_normal_timeout(DisplayPowerChangeReason reason);
@@ -111,6 +120,9 @@ private:
     std::shared_ptr<ShutdownControl> const shutdown_control;
     std::shared_ptr<SuspendControl> const suspend_control;
     std::shared_ptr<Timer> const timer;
+    // The display is powered off from the brightness control once the
+    // brightness reaches off, so this is shared with that thread
+    std::shared_ptr<DisplayOffSequence> const display_off_sequence;
 
     std::array<bool,InactivityTimeoutAllowance::count> inactivity_timeout_allowances;
     std::array<bool,ProximityEnablement::count> proximity_enablements;
@@ -124,6 +136,7 @@ private:
     AlarmId user_inactivity_display_off_alarm_id;
     AlarmId proximity_disable_alarm_id;
     AlarmId notification_expiration_alarm_id;
+    std::chrono::steady_clock::time_point user_inactivity_display_dim_time_point;
     std::chrono::steady_clock::time_point user_inactivity_display_off_time_point;
     std::chrono::milliseconds const user_inactivity_normal_display_dim_duration;
     std::chrono::milliseconds user_inactivity_normal_display_off_timeout;
@@ -21,6 +21,8 @@
 namespace repowerd
 {
 
+// Display power changes are requested asynchronously, and are applied
+// in the order they were made.
 class DisplayPowerControl
 {
 public:
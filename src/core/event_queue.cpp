@@ -0,0 +1,286 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "event_queue.h"
+
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace
+{
+
+int create_wakeup_fd()
+{
+    auto const fd = eventfd(0, EFD_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error{errno, std::system_category(), "Failed to create eventfd"};
+    return fd;
+}
+
+uint64_t make_free_list_head(uint64_t prev_head, uint32_t index)
+{
+    return (((prev_head >> 32) + 1) << 32) | index;
+}
+
+}
+
+repowerd::EventQueue::Lane::Lane()
+    : head{&stub},
+      tail{&stub}
+{
+    stub.next.store(nullptr, std::memory_order_relaxed);
+}
+
+repowerd::EventQueue::Lane::~Lane()
+{
+    while (auto const node = pop())
+    {
+        if (!node->from_pool)
+            delete node;
+    }
+}
+
+void repowerd::EventQueue::Lane::push(Node* node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    auto const prev = head.exchange(node);
+    prev->next.store(node);
+}
+
+repowerd::EventQueue::Node* repowerd::EventQueue::Lane::pop()
+{
+    auto current = tail;
+    auto next = current->next.load();
+
+    if (current == &stub)
+    {
+        if (!next) return nullptr;
+        tail = next;
+        current = next;
+        next = next->next.load();
+    }
+
+    if (next)
+    {
+        tail = next;
+        return current;
+    }
+
+    // A producer has swapped the head but not linked its node yet,
+    // so report the lane as empty for now
+    if (current != head.load())
+        return nullptr;
+
+    push(&stub);
+
+    next = current->next.load();
+    if (next)
+    {
+        tail = next;
+        return current;
+    }
+
+    return nullptr;
+}
+
+repowerd::EventQueue::EventQueue(size_t pool_size)
+    : pool_size{pool_size},
+      pool{new Node[pool_size]},
+      free_pool_nodes{0},
+      consumer_waiting{false},
+      wakeup_fd{create_wakeup_fd()},
+      has_lookahead_event{false}
+{
+    coalesced_types.fill(false);
+    for (auto& count : coalesced_counts)
+        count = 0;
+
+    for (size_t i = 0; i < pool_size; ++i)
+    {
+        pool[i].from_pool = true;
+        release_node(&pool[i]);
+    }
+}
+
+repowerd::EventQueue::~EventQueue()
+{
+    close(wakeup_fd);
+}
+
+void repowerd::EventQueue::coalesce_adjacent(DaemonEvent::Type type)
+{
+    coalesced_types[static_cast<size_t>(type)] = true;
+}
+
+uint64_t repowerd::EventQueue::num_coalesced(DaemonEvent::Type type) const
+{
+    return coalesced_counts[static_cast<size_t>(type)];
+}
+
+void repowerd::EventQueue::enqueue(DaemonEvent const& event)
+{
+    push(normal_lane, event);
+}
+
+void repowerd::EventQueue::enqueue_priority(DaemonEvent const& event)
+{
+    push(priority_lane, event);
+}
+
+repowerd::DaemonEvent repowerd::EventQueue::dequeue()
+{
+    auto event = wait_and_pop();
+
+    while (is_coalesced(event.type))
+    {
+        DaemonEvent next_event;
+
+        if (!try_pop(next_event))
+            break;
+
+        if (next_event.type != event.type)
+        {
+            lookahead_event = next_event;
+            has_lookahead_event = true;
+            break;
+        }
+
+        ++coalesced_counts[static_cast<size_t>(event.type)];
+        event = next_event;
+    }
+
+    return event;
+}
+
+repowerd::EventQueue::Node* repowerd::EventQueue::allocate_node()
+{
+    auto head = free_pool_nodes.load();
+
+    while (true)
+    {
+        auto const index = static_cast<uint32_t>(head);
+
+        // Pool exhausted, fall back to the heap
+        if (index == 0)
+        {
+            auto const node = new Node;
+            node->from_pool = false;
+            return node;
+        }
+
+        auto const node = &pool[index - 1];
+        auto const next = node->free_next.load(std::memory_order_relaxed);
+
+        if (free_pool_nodes.compare_exchange_weak(head, make_free_list_head(head, next)))
+            return node;
+    }
+}
+
+void repowerd::EventQueue::release_node(Node* node)
+{
+    if (!node->from_pool)
+    {
+        delete node;
+        return;
+    }
+
+    auto const index = static_cast<uint32_t>(node - pool.get()) + 1;
+    auto head = free_pool_nodes.load();
+
+    do
+    {
+        node->free_next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    }
+    while (!free_pool_nodes.compare_exchange_weak(head, make_free_list_head(head, index)));
+}
+
+void repowerd::EventQueue::push(Lane& lane, DaemonEvent const& event)
+{
+    auto const node = allocate_node();
+    node->event = event;
+    lane.push(node);
+
+    if (consumer_waiting.exchange(false))
+        wake_up_consumer();
+}
+
+bool repowerd::EventQueue::try_pop(DaemonEvent& event)
+{
+    auto node = priority_lane.pop();
+
+    if (!node && has_lookahead_event)
+    {
+        event = lookahead_event;
+        has_lookahead_event = false;
+        return true;
+    }
+
+    if (!node) node = normal_lane.pop();
+    if (!node) return false;
+
+    event = node->event;
+    release_node(node);
+
+    return true;
+}
+
+repowerd::DaemonEvent repowerd::EventQueue::wait_and_pop()
+{
+    DaemonEvent event;
+
+    while (true)
+    {
+        if (try_pop(event))
+            return event;
+
+        // The sequentially consistent operations on consumer_waiting and
+        // on the lane links ensure that either we see the new event
+        // when checking again, or the producer sees that we are waiting
+        consumer_waiting = true;
+
+        if (try_pop(event))
+        {
+            consumer_waiting = false;
+            return event;
+        }
+
+        wait_for_producer();
+    }
+}
+
+bool repowerd::EventQueue::is_coalesced(DaemonEvent::Type type) const
+{
+    return coalesced_types[static_cast<size_t>(type)];
+}
+
+void repowerd::EventQueue::wake_up_consumer()
+{
+    uint64_t const one{1};
+    while (write(wakeup_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+        continue;
+}
+
+void repowerd::EventQueue::wait_for_producer()
+{
+    uint64_t value;
+    while (read(wakeup_fd, &value, sizeof(value)) < 0 && errno == EINTR)
+        continue;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "daemon_event.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace repowerd
+{
+
+// Multi-producer, single-consumer queue of daemon events. Producers never
+// block on each other; the single consumer sleeps on an eventfd when the
+// queue is empty, and is only woken up by producers if it is actually
+// waiting. Events are stored in nodes taken from a preallocated pool, so
+// enqueuing and dequeuing don't allocate unless the pool is exhausted.
+class EventQueue
+{
+public:
+    static size_t constexpr default_pool_size{256};
+
+    EventQueue(size_t pool_size = default_pool_size);
+    ~EventQueue();
+
+    // When a run of adjacent events of a coalesced type is pending, only
+    // the last event of the run is dequeued and the rest are dropped
+    void coalesce_adjacent(DaemonEvent::Type type);
+    uint64_t num_coalesced(DaemonEvent::Type type) const;
+
+    void enqueue(DaemonEvent const& event);
+    // Priority events are dequeued before any pending normal events
+    void enqueue_priority(DaemonEvent const& event);
+    // Must only be called by the single consumer thread
+    DaemonEvent dequeue();
+
+private:
+    EventQueue(EventQueue const&) = delete;
+    EventQueue& operator=(EventQueue const&) = delete;
+
+    struct Node
+    {
+        std::atomic<Node*> next;
+        std::atomic<uint32_t> free_next;
+        bool from_pool;
+        DaemonEvent event;
+    };
+
+    // Intrusive MPSC node queue (see Dmitry Vyukov's design)
+    class Lane
+    {
+    public:
+        Lane();
+        ~Lane();
+
+        void push(Node* node);
+        Node* pop();
+
+    private:
+        std::atomic<Node*> head;
+        Node* tail;
+        Node stub;
+    };
+
+    Node* allocate_node();
+    void release_node(Node* node);
+    void push(Lane& lane, DaemonEvent const& event);
+    bool try_pop(DaemonEvent& event);
+    DaemonEvent wait_and_pop();
+    bool is_coalesced(DaemonEvent::Type type) const;
+    void wake_up_consumer();
+    void wait_for_producer();
+
+    size_t const pool_size;
+    std::unique_ptr<Node[]> const pool;
+    // Lock-free stack of free pool nodes: the low 32 bits hold the index
+    // of the top node plus one (zero for an empty stack), the high 32 bits
+    // a generation count that protects against ABA
+    std::atomic<uint64_t> free_pool_nodes;
+    Lane priority_lane;
+    Lane normal_lane;
+    std::atomic<bool> consumer_waiting;
+    int const wakeup_fd;
+
+    // Event popped while looking for a coalescing run, to be dequeued next
+    bool has_lookahead_event;
+    DaemonEvent lookahead_event;
+    std::array<bool,DaemonEvent::num_types> coalesced_types;
+    std::array<std::atomic<uint64_t>,DaemonEvent::num_types> coalesced_counts;
+};
+
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "event_stats.h"
+
+repowerd::EventStats::EventStats()
+{
+    for (auto& histogram : queue_latency)
+        for (auto& bucket : histogram) bucket = 0;
+
+    for (auto& histogram : handling_time)
+        for (auto& bucket : histogram) bucket = 0;
+}
+
+void repowerd::EventStats::record(
+    DaemonEvent::Type type,
+    std::chrono::nanoseconds queue_latency_duration,
+    std::chrono::nanoseconds handling_time_duration)
+{
+    auto const index = static_cast<size_t>(type);
+
+    queue_latency[index][bucket_for(queue_latency_duration)].fetch_add(
+        1, std::memory_order_relaxed);
+    handling_time[index][bucket_for(handling_time_duration)].fetch_add(
+        1, std::memory_order_relaxed);
+}
+
+repowerd::EventStats::Histogram repowerd::EventStats::queue_latency_histogram(
+    DaemonEvent::Type type) const
+{
+    return snapshot(queue_latency[static_cast<size_t>(type)]);
+}
+
+repowerd::EventStats::Histogram repowerd::EventStats::handling_time_histogram(
+    DaemonEvent::Type type) const
+{
+    return snapshot(handling_time[static_cast<size_t>(type)]);
+}
+
+size_t repowerd::EventStats::bucket_for(std::chrono::nanoseconds duration)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    size_t bucket = 0;
+
+    while (us > 0 && bucket < num_buckets - 1)
+    {
+        us >>= 1;
+        ++bucket;
+    }
+
+    return bucket;
+}
+
+repowerd::EventStats::Histogram repowerd::EventStats::snapshot(
+    AtomicHistogram const& histogram)
+{
+    Histogram result;
+
+    for (size_t i = 0; i < num_buckets; ++i)
+        result[i] = histogram[i].load(std::memory_order_relaxed);
+
+    return result;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "daemon_event.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace repowerd
+{
+
+// Per event type log2 histograms of the time events spend in the daemon
+// queue (enqueue to dispatch start) and of the time their handling takes
+// (dispatch start to dispatch end). Recording and reading are lock-free
+// and may happen concurrently from different threads.
+class EventStats
+{
+public:
+    // Bucket 0 counts durations below 1us, bucket i durations in
+    // [2^(i-1), 2^i) us, and the last bucket everything longer
+    static size_t constexpr num_buckets{24};
+    using Histogram = std::array<uint64_t,num_buckets>;
+
+    EventStats();
+
+    void record(
+        DaemonEvent::Type type,
+        std::chrono::nanoseconds queue_latency,
+        std::chrono::nanoseconds handling_time);
+
+    Histogram queue_latency_histogram(DaemonEvent::Type type) const;
+    Histogram handling_time_histogram(DaemonEvent::Type type) const;
+
+    static size_t bucket_for(std::chrono::nanoseconds duration);
+
+private:
+    EventStats(EventStats const&) = delete;
+    EventStats& operator=(EventStats const&) = delete;
+
+    using AtomicHistogram = std::array<std::atomic<uint64_t>,num_buckets>;
+
+    static Histogram snapshot(AtomicHistogram const& histogram);
+
+    std::array<AtomicHistogram,DaemonEvent::num_types> queue_latency;
+    std::array<AtomicHistogram,DaemonEvent::num_types> handling_time;
+};
+
+}
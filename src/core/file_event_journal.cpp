@@ -0,0 +1,280 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "file_event_journal.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+char const journal_magic[4] = {'R', 'P', 'E', 'J'};
+uint32_t const journal_version = 1;
+size_t const header_size = sizeof(journal_magic) + sizeof(journal_version);
+size_t const record_prefix_size = sizeof(uint8_t) + sizeof(int64_t);
+size_t const max_record_size = record_prefix_size + 21;
+
+using EventType = repowerd::DaemonEvent::Type;
+
+size_t payload_size(EventType type)
+{
+    switch (type)
+    {
+    case EventType::alarm:
+        return sizeof(int32_t);
+    case EventType::set_inactivity_timeout:
+        return sizeof(int64_t);
+    case EventType::set_normal_brightness_value:
+        return sizeof(double);
+    case EventType::power_source_level_change:
+        return sizeof(uint8_t) + sizeof(uint32_t) + 2 * sizeof(double);
+    default:
+        return 0;
+    }
+}
+
+bool is_recorded(EventType type)
+{
+    return type != EventType::flush && type != EventType::stop;
+}
+
+template <typename T>
+char* put(char* dst, T const& value)
+{
+    memcpy(dst, &value, sizeof(value));
+    return dst + sizeof(value);
+}
+
+template <typename T>
+char const* get(char const* src, T& value)
+{
+    memcpy(&value, src, sizeof(value));
+    return src + sizeof(value);
+}
+
+size_t encode(repowerd::DaemonEvent const& event, char* buffer)
+{
+    auto p = buffer;
+
+    p = put(p, static_cast<uint8_t>(event.type));
+    p = put(p, static_cast<int64_t>(event.enqueue_time_ns));
+
+    switch (event.type)
+    {
+    case EventType::alarm:
+        p = put(p, static_cast<int32_t>(event.payload.alarm_id));
+        break;
+    case EventType::set_inactivity_timeout:
+        p = put(p, static_cast<int64_t>(event.payload.timeout_ms));
+        break;
+    case EventType::set_normal_brightness_value:
+        p = put(p, event.payload.brightness_value);
+        break;
+    case EventType::power_source_level_change:
+        p = put(p, static_cast<uint8_t>(event.payload.battery_info.is_present));
+        p = put(p, event.payload.battery_info.state);
+        p = put(p, event.payload.battery_info.percentage);
+        p = put(p, event.payload.battery_info.temperature);
+        break;
+    default:
+        break;
+    }
+
+    return p - buffer;
+}
+
+repowerd::DaemonEvent decode(EventType type, char const* p)
+{
+    auto event = repowerd::DaemonEvent::of_type(type);
+    int64_t enqueue_time_ns{0};
+
+    p = get(p, enqueue_time_ns);
+    event.enqueue_time_ns = enqueue_time_ns;
+
+    switch (type)
+    {
+    case EventType::alarm:
+    {
+        int32_t alarm_id{0};
+        get(p, alarm_id);
+        event.payload.alarm_id = alarm_id;
+        break;
+    }
+    case EventType::set_inactivity_timeout:
+    {
+        int64_t timeout_ms{0};
+        get(p, timeout_ms);
+        event.payload.timeout_ms = timeout_ms;
+        break;
+    }
+    case EventType::set_normal_brightness_value:
+        get(p, event.payload.brightness_value);
+        break;
+    case EventType::power_source_level_change:
+    {
+        uint8_t is_present{0};
+        p = get(p, is_present);
+        p = get(p, event.payload.battery_info.state);
+        p = get(p, event.payload.battery_info.percentage);
+        get(p, event.payload.battery_info.temperature);
+        event.payload.battery_info.is_present = is_present != 0;
+        break;
+    }
+    default:
+        break;
+    }
+
+    return event;
+}
+
+void write_all(int fd, char const* data, size_t size)
+{
+    while (size > 0)
+    {
+        auto const written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+        {
+            throw std::system_error{
+                written < 0 ? errno : EIO, std::system_category(),
+                "Failed to write event journal"};
+        }
+
+        data += written;
+        size -= written;
+    }
+}
+
+}
+
+repowerd::FileEventJournal::FileEventJournal(std::string const& path)
+    : fd{open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600)},
+      failed{false}
+{
+    if (fd == -1)
+    {
+        throw std::system_error{
+            errno, std::system_category(), "Failed to open event journal " + path};
+    }
+
+    try
+    {
+        struct stat st;
+        if (fstat(fd, &st) == -1)
+        {
+            throw std::system_error{
+                errno, std::system_category(), "Failed to stat event journal " + path};
+        }
+
+        if (st.st_size == 0)
+        {
+            char header[header_size];
+            put(put(header, journal_magic), journal_version);
+            write_all(fd, header, sizeof(header));
+        }
+    }
+    catch (...)
+    {
+        close(fd);
+        throw;
+    }
+}
+
+repowerd::FileEventJournal::~FileEventJournal()
+{
+    close(fd);
+}
+
+void repowerd::FileEventJournal::record(DaemonEvent const& event)
+{
+    if (!is_recorded(event.type) || failed)
+        return;
+
+    char buffer[max_record_size];
+    auto const size = encode(event, buffer);
+
+    std::lock_guard<std::mutex> lock{write_mutex};
+
+    // Failing to record must never affect event handling. Since a record
+    // may have been partially written, stop recording rather than append
+    // more records after a corrupted one.
+    try
+    {
+        write_all(fd, buffer, size);
+    }
+    catch (...)
+    {
+        failed = true;
+    }
+}
+
+std::vector<repowerd::DaemonEvent> repowerd::FileEventJournal::read_events(
+    std::string const& path)
+{
+    std::ifstream fs{path, std::ios::binary};
+    if (!fs)
+        throw std::runtime_error{"Failed to open event journal " + path};
+
+    std::string const data{std::istreambuf_iterator<char>{fs}, std::istreambuf_iterator<char>{}};
+
+    char magic[sizeof(journal_magic)];
+    uint32_t version{0};
+
+    if (data.size() < header_size)
+        throw std::runtime_error{"Invalid event journal " + path + ": missing header"};
+
+    get(get(data.data(), magic), version);
+
+    if (memcmp(magic, journal_magic, sizeof(magic)) != 0 || version != journal_version)
+        throw std::runtime_error{"Invalid event journal " + path + ": bad header"};
+
+    std::vector<DaemonEvent> events;
+    size_t offset = header_size;
+
+    while (offset + record_prefix_size <= data.size())
+    {
+        auto const type_value = static_cast<uint8_t>(data[offset]);
+        if (type_value >= DaemonEvent::num_types)
+        {
+            throw std::runtime_error{
+                "Invalid event journal " + path + ": unknown event type " +
+                std::to_string(type_value) + " at offset " + std::to_string(offset)};
+        }
+
+        auto const type = static_cast<EventType>(type_value);
+        auto const record_size = record_prefix_size + payload_size(type);
+
+        if (offset + record_size > data.size())
+            break;
+
+        events.push_back(decode(type, data.data() + offset + sizeof(uint8_t)));
+        offset += record_size;
+    }
+
+    return events;
+}
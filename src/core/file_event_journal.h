@@ -0,0 +1,61 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "event_journal.h"
+#include "daemon_event.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace repowerd
+{
+
+// Append-only binary journal of daemon events. The file starts with a
+// magic/version header, followed by one record per event: the event type
+// (1 byte), the monotonic enqueue time in ns (8 bytes) and a type specific
+// payload (0-21 bytes). Records are appended under a lock, so that a record
+// written in pieces after a short write is never interleaved with others.
+// If a write fails, recording stops, leaving the journal readable up to the
+// last complete record. Flush and stop events are daemon internal and are
+// not recorded.
+class FileEventJournal : public EventJournal
+{
+public:
+    FileEventJournal(std::string const& path);
+    ~FileEventJournal();
+
+    void record(DaemonEvent const& event) override;
+
+    // Reads all complete records of a journal file. A truncated trailing
+    // record (e.g. from a crash during writing) is ignored.
+    static std::vector<DaemonEvent> read_events(std::string const& path);
+
+private:
+    FileEventJournal(FileEventJournal const&) = delete;
+    FileEventJournal& operator=(FileEventJournal const&) = delete;
+
+    int const fd;
+    std::mutex write_mutex;
+    std::atomic<bool> failed;
+};
+
+}
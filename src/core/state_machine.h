@@ -19,6 +19,7 @@
 #pragma once
 
 #include "alarm_id.h"
+#include "power_source.h"
 
 #include <chrono>
 
@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "task_graph.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+
+struct RunningTask
+{
+    std::string const& name;
+    std::unordered_set<std::string> const& dependencies;
+    std::exception_ptr dependency_error;
+};
+
+thread_local RunningTask* running_task = nullptr;
+
+}
+
+void repowerd::TaskGraph::add_task(
+    std::string const& name,
+    std::vector<std::string> const& dependencies,
+    std::function<void()> const& task)
+{
+    tasks.push_back({name, dependencies, task});
+}
+
+std::vector<repowerd::TaskGraph::TaskTiming> repowerd::TaskGraph::run(
+    size_t max_concurrency)
+{
+    std::unordered_map<std::string,size_t> task_index;
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        if (!task_index.emplace(tasks[i].name, i).second)
+            throw std::runtime_error{"Duplicate task " + tasks[i].name};
+    }
+
+    std::vector<size_t> num_pending_dependencies(tasks.size(), 0);
+    std::vector<std::vector<size_t>> dependents(tasks.size());
+
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        for (auto const& dependency : tasks[i].dependencies)
+        {
+            auto const iter = task_index.find(dependency);
+            if (iter == task_index.end())
+            {
+                throw std::runtime_error{
+                    "Task " + tasks[i].name + " depends on unknown task " + dependency};
+            }
+            dependents[iter->second].push_back(i);
+            ++num_pending_dependencies[i];
+        }
+    }
+
+    std::deque<size_t> ready;
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        if (num_pending_dependencies[i] == 0)
+            ready.push_back(i);
+    }
+
+    // Check for cycles before running anything, and gather the direct and
+    // indirect dependencies of each task along the way
+    std::vector<std::unordered_set<std::string>> all_dependencies(tasks.size());
+    {
+        auto pending = num_pending_dependencies;
+        std::deque<size_t> check_ready{ready};
+        size_t num_reachable = 0;
+
+        while (!check_ready.empty())
+        {
+            auto const i = check_ready.front();
+            check_ready.pop_front();
+            ++num_reachable;
+
+            for (auto const& dependency : tasks[i].dependencies)
+            {
+                auto const& indirect = all_dependencies[task_index[dependency]];
+                all_dependencies[i].insert(dependency);
+                all_dependencies[i].insert(indirect.begin(), indirect.end());
+            }
+
+            for (auto const dependent : dependents[i])
+            {
+                if (--pending[dependent] == 0)
+                    check_ready.push_back(dependent);
+            }
+        }
+
+        if (num_reachable != tasks.size())
+            throw std::runtime_error{"Task graph has a dependency cycle"};
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t num_running = 0;
+    size_t num_completed = 0;
+    std::exception_ptr error;
+    std::vector<TaskTiming> timings;
+
+    auto const worker =
+        [&]
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+
+            while (true)
+            {
+                cv.wait(lock,
+                    [&]
+                    {
+                        return !ready.empty() ||
+                               num_completed == tasks.size() ||
+                               (error && num_running == 0);
+                    });
+
+                if (error || ready.empty())
+                    break;
+
+                auto const i = ready.front();
+                ready.pop_front();
+                ++num_running;
+
+                lock.unlock();
+
+                std::exception_ptr task_error;
+                RunningTask task{tasks[i].name, all_dependencies[i], nullptr};
+                auto const parent_task = running_task;
+                running_task = &task;
+                auto const start = std::chrono::steady_clock::now();
+                try
+                {
+                    tasks[i].func();
+                }
+                catch (...)
+                {
+                    task_error = std::current_exception();
+                }
+                auto const duration = std::chrono::steady_clock::now() - start;
+                running_task = parent_task;
+
+                if (task.dependency_error)
+                    task_error = task.dependency_error;
+
+                lock.lock();
+
+                --num_running;
+                ++num_completed;
+
+                if (task_error)
+                {
+                    if (!error) error = task_error;
+                }
+                else
+                {
+                    timings.push_back({tasks[i].name, duration});
+                    for (auto const dependent : dependents[i])
+                    {
+                        if (--num_pending_dependencies[dependent] == 0)
+                            ready.push_back(dependent);
+                    }
+                }
+
+                cv.notify_all();
+            }
+        };
+
+    std::vector<std::thread> threads;
+    auto const num_threads = std::max<size_t>(1, std::min(max_concurrency, tasks.size()));
+
+    for (size_t i = 1; i < num_threads; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    return timings;
+}
+
+void repowerd::TaskGraph::check_dependency(std::string const& name)
+{
+    if (!running_task ||
+        name == running_task->name ||
+        running_task->dependencies.count(name))
+    {
+        return;
+    }
+
+    std::logic_error const error{
+        "Task " + running_task->name + " uses " + name + " without depending on it"};
+
+    if (!running_task->dependency_error)
+        running_task->dependency_error = std::make_exception_ptr(error);
+
+    throw error;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace repowerd
+{
+
+// A set of named tasks with dependencies between them. Running the graph
+// runs each task once all the tasks it depends on have completed, running
+// independent tasks concurrently.
+class TaskGraph
+{
+public:
+    struct TaskTiming
+    {
+        std::string name;
+        std::chrono::steady_clock::duration duration;
+    };
+
+    void add_task(
+        std::string const& name,
+        std::vector<std::string> const& dependencies,
+        std::function<void()> const& task);
+
+    // Runs all tasks with at most max_concurrency of them running at the
+    // same time, and returns their timings in completion order. Throws if
+    // a dependency is unknown or there is a dependency cycle. If a task
+    // throws, no further tasks are started, and the exception is rethrown
+    // once the already running tasks have completed.
+    std::vector<TaskTiming> run(size_t max_concurrency);
+
+    // Throws if called from a running task that is not the named task and
+    // doesn't depend on it, directly or indirectly. The run then fails,
+    // even if the task catches the exception. Does nothing when not called
+    // from a running task.
+    static void check_dependency(std::string const& name);
+
+private:
+    struct Task
+    {
+        std::string name;
+        std::vector<std::string> dependencies;
+        std::function<void()> func;
+    };
+
+    std::vector<Task> tasks;
+};
+
+}
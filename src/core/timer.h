@@ -35,7 +35,15 @@ public:
     virtual ~Timer() = default;
 
     virtual HandlerRegistration register_alarm_handler(AlarmHandler const& handler) = 0;
-    virtual AlarmId schedule_alarm_in(std::chrono::milliseconds t) = 0;
+    // The alarm fires after t, and at most 'slack' later than that. Alarms
+    // with slack may be delayed so that they fire together with other
+    // alarms, saving wakeups.
+    virtual AlarmId schedule_alarm_in(
+        std::chrono::milliseconds t, std::chrono::milliseconds slack) = 0;
+    AlarmId schedule_alarm_in(std::chrono::milliseconds t)
+    {
+        return schedule_alarm_in(t, std::chrono::milliseconds{0});
+    }
     virtual void cancel_alarm(AlarmId id) = 0;
     virtual std::chrono::steady_clock::time_point now() = 0;
 
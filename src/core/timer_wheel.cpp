@@ -0,0 +1,250 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timer_wheel.h"
+
+#include <algorithm>
+
+namespace
+{
+
+using Tick = repowerd::TimerWheel::Tick;
+
+Tick level_span(int level, int slot_bits)
+{
+    return Tick{1} << (slot_bits * level);
+}
+
+}
+
+repowerd::TimerWheel::TimerWheel(Tick start_tick)
+    : current{start_tick}
+{
+    for (auto& level : levels)
+    {
+        level.slots.fill(nullptr);
+        level.occupied = 0;
+    }
+}
+
+void repowerd::TimerWheel::add(AlarmId id, Tick expiry)
+{
+    remove(id);
+
+    auto& entry = entries[id];
+    entry.id = id;
+    entry.expiry = std::max(expiry, current + 1);
+
+    insert(entry);
+}
+
+bool repowerd::TimerWheel::remove(AlarmId id)
+{
+    auto const iter = entries.find(id);
+    if (iter == entries.end())
+        return false;
+
+    unlink(iter->second);
+    entries.erase(iter);
+
+    return true;
+}
+
+void repowerd::TimerWheel::advance_to(Tick tick, std::vector<Expiration>& expired)
+{
+    // Jump directly between the ticks at which something happens, i.e.,
+    // a non-empty slot either expires or cascades to finer levels
+    while (current < tick)
+    {
+        auto const next = next_event_tick();
+        if (next > tick)
+        {
+            current = tick;
+            break;
+        }
+
+        current = next;
+        process_tick(current, expired);
+    }
+}
+
+repowerd::TimerWheel::Tick repowerd::TimerWheel::next_expiry() const
+{
+    auto result = no_tick;
+
+    // Slots in a level are ordered by expiry, so the earliest alarm of a
+    // level is in its first occupied slot. The coarsest level also holds
+    // alarms beyond the range of the wheel, so check all its slots.
+    for (int l = 0; l < num_levels; ++l)
+    {
+        auto const& level = levels[l];
+        if (!level.occupied)
+            continue;
+
+        auto const current_slot = (current >> (slot_bits * l)) & (num_slots - 1);
+
+        for (int d = next_occupied_distance(l); d <= num_slots; ++d)
+        {
+            auto const head = level.slots[(current_slot + d) & (num_slots - 1)];
+            if (!head)
+                continue;
+
+            auto entry = head;
+            do
+            {
+                result = std::min(result, entry->expiry);
+                entry = entry->next;
+            }
+            while (entry != head);
+
+            if (l < num_levels - 1)
+                break;
+        }
+    }
+
+    return result;
+}
+
+repowerd::TimerWheel::Tick repowerd::TimerWheel::current_tick() const
+{
+    return current;
+}
+
+size_t repowerd::TimerWheel::size() const
+{
+    return entries.size();
+}
+
+void repowerd::TimerWheel::insert(Entry& entry)
+{
+    auto const delta = entry.expiry - current;
+
+    int level = 0;
+    while (level < num_levels - 1 && delta >= level_span(level + 1, slot_bits))
+        ++level;
+
+    // Alarms beyond the range of the wheel are parked in the furthest
+    // slot of the coarsest level, and are reinserted when it cascades
+    auto const max_delta = level_span(num_levels, slot_bits) - 1;
+    auto const slot_tick = delta > max_delta ? current + max_delta : entry.expiry;
+    auto const slot = (slot_tick >> (slot_bits * level)) & (num_slots - 1);
+
+    auto& head = levels[level].slots[slot];
+    if (!head)
+    {
+        head = &entry;
+        entry.prev = &entry;
+        entry.next = &entry;
+        levels[level].occupied |= uint64_t{1} << slot;
+    }
+    else
+    {
+        auto const tail = head->prev;
+        tail->next = &entry;
+        entry.prev = tail;
+        entry.next = head;
+        head->prev = &entry;
+    }
+
+    entry.level = level;
+    entry.slot = slot;
+}
+
+void repowerd::TimerWheel::unlink(Entry& entry)
+{
+    auto& level = levels[entry.level];
+    auto& head = level.slots[entry.slot];
+
+    if (entry.next == &entry)
+    {
+        head = nullptr;
+        level.occupied &= ~(uint64_t{1} << entry.slot);
+    }
+    else
+    {
+        entry.prev->next = entry.next;
+        entry.next->prev = entry.prev;
+        if (head == &entry)
+            head = entry.next;
+    }
+}
+
+void repowerd::TimerWheel::process_tick(Tick tick, std::vector<Expiration>& expired)
+{
+    // Cascade coarse slots starting at this tick to finer levels, from the
+    // coarsest down, so that cascaded alarms expiring at this tick end up
+    // in the finest level slot processed last
+    for (int l = num_levels - 1; l >= 0; --l)
+    {
+        if (tick & (level_span(l, slot_bits) - 1))
+            continue;
+
+        auto& level = levels[l];
+        auto const slot = (tick >> (slot_bits * l)) & (num_slots - 1);
+        auto const head = level.slots[slot];
+        if (!head)
+            continue;
+
+        level.slots[slot] = nullptr;
+        level.occupied &= ~(uint64_t{1} << slot);
+
+        auto entry = head;
+        do
+        {
+            auto const next = entry->next;
+            if (l == 0)
+            {
+                expired.push_back({entry->id, entry->expiry});
+                entries.erase(entry->id);
+            }
+            else
+            {
+                insert(*entry);
+            }
+            entry = next;
+        }
+        while (entry != head);
+    }
+}
+
+repowerd::TimerWheel::Tick repowerd::TimerWheel::next_event_tick() const
+{
+    auto result = no_tick;
+
+    for (int l = 0; l < num_levels; ++l)
+    {
+        if (!levels[l].occupied)
+            continue;
+
+        auto const shift = slot_bits * l;
+        auto const tick = ((current >> shift) + next_occupied_distance(l)) << shift;
+        result = std::min(result, tick);
+    }
+
+    return result;
+}
+
+int repowerd::TimerWheel::next_occupied_distance(int level) const
+{
+    // Distance, from 1 to num_slots, from the slot the current tick falls
+    // in to the next occupied slot of the level, wrapping around
+    auto const occupied = levels[level].occupied;
+    auto const current_slot = (current >> (slot_bits * level)) & (num_slots - 1);
+    auto const shift = (current_slot + 1) & (num_slots - 1);
+    auto const rotated = shift ? (occupied >> shift) | (occupied << (num_slots - shift)) : occupied;
+
+    return __builtin_ctzll(rotated) + 1;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "alarm_id.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace repowerd
+{
+
+// Hierarchical timer wheel. Alarms are kept in slots of increasing
+// granularity according to how far in the future they expire, and move to
+// finer slots as time advances, so adding and removing alarms takes
+// constant time regardless of the number of active alarms. Time is
+// measured in abstract ticks. Not thread safe.
+class TimerWheel
+{
+public:
+    using Tick = uint64_t;
+    static Tick constexpr no_tick{std::numeric_limits<Tick>::max()};
+
+    struct Expiration
+    {
+        AlarmId id;
+        Tick expiry;
+    };
+
+    TimerWheel(Tick start_tick);
+
+    // Alarms expiring at or before the current tick expire at the next tick
+    void add(AlarmId id, Tick expiry);
+    // Returns false if the alarm is not active
+    bool remove(AlarmId id);
+
+    // Advances the wheel to the given tick, and appends the alarms that
+    // expire on the way to 'expired', in expiry order
+    void advance_to(Tick tick, std::vector<Expiration>& expired);
+
+    // The tick at which the earliest active alarm expires, or no_tick
+    Tick next_expiry() const;
+    Tick current_tick() const;
+    size_t size() const;
+
+private:
+    TimerWheel(TimerWheel const&) = delete;
+    TimerWheel& operator=(TimerWheel const&) = delete;
+
+    static int constexpr slot_bits{6};
+    static int constexpr num_slots{1 << slot_bits};
+    static int constexpr num_levels{5};
+
+    struct Entry
+    {
+        AlarmId id;
+        Tick expiry;
+        Entry* prev;
+        Entry* next;
+        int level;
+        int slot;
+    };
+
+    struct Level
+    {
+        std::array<Entry*,num_slots> slots;
+        // Bit i is set iff slot i is not empty
+        uint64_t occupied;
+    };
+
+    void insert(Entry& entry);
+    void unlink(Entry& entry);
+    void process_tick(Tick tick, std::vector<Expiration>& expired);
+    Tick next_event_tick() const;
+    int next_occupied_distance(int level) const;
+
+    Tick current;
+    std::array<Level,num_levels> levels;
+    std::unordered_map<AlarmId,Entry> entries;
+};
+
+}
@@ -18,6 +18,9 @@
 
 #include "default_daemon_config.h"
 #include "core/default_state_machine.h"
+#include "core/event_stats.h"
+#include "core/file_event_journal.h"
+#include "core/task_graph.h"
 
 #include "adapters/android_autobrightness_algorithm.h"
 #include "adapters/android_backlight.h"
@@ -25,7 +28,10 @@
 #include "adapters/android_device_quirks.h"
 #include "adapters/backlight_brightness_control.h"
 #include "adapters/console_log.h"
+#include "adapters/dbus_event_loop.h"
 #include "adapters/dev_alarm_wakeup_service.h"
+#include "adapters/event_loop.h"
+#include "adapters/event_loop_reactor.h"
 #include "adapters/event_loop_timer.h"
 #include "adapters/libsuspend_suspend_control.h"
 #include "adapters/null_log.h"
@@ -34,6 +40,7 @@
 #include "adapters/real_filesystem.h"
 #include "adapters/real_temporary_suspend_inhibition.h"
 #include "adapters/sysfs_backlight.h"
+#include "adapters/sysfs_power_source.h"
 #include "adapters/syslog_log.h"
 #include "adapters/system_shutdown_control.h"
 #include "adapters/light_control.h"
@@ -46,6 +53,9 @@
 #include "adapters/unity_user_activity.h"
 #include "adapters/upower_power_source.h"
 
+#include <algorithm>
+#include <thread>
+
 using namespace std::chrono_literals;
 
 namespace
@@ -64,7 +74,10 @@ struct NullBrightnessControl : repowerd::BrightnessControl
     void set_dim_brightness() override {}
     void set_normal_brightness() override {}
     void set_normal_brightness_value(double)  override {}
-    void set_off_brightness() override {}
+    void set_off_brightness(std::function<void()> const& brightness_off) override
+    {
+        brightness_off();
+    }
 };
 
 struct NullBrightnessNotification : repowerd::BrightnessNotification
@@ -76,6 +89,11 @@ struct NullBrightnessNotification : repowerd::BrightnessNotification
     }
 };
 
+struct NullEventJournal : repowerd::EventJournal
+{
+    void record(repowerd::DaemonEvent const&) override {}
+};
+
 struct NullLightSensor : repowerd::LightSensor
 {
     repowerd::HandlerRegistration register_light_handler(
@@ -86,6 +104,8 @@ struct NullLightSensor : repowerd::LightSensor
 
     void enable_light_events() override {}
     void disable_light_events() override {}
+    void enable_reduced_light_sampling() override {}
+    void disable_reduced_light_sampling() override {}
 };
 
 struct NullModemPowerControl : repowerd::ModemPowerControl
@@ -115,6 +135,50 @@ struct NullProximitySensor : repowerd::ProximitySensor
     void disable_proximity_events() override {}
 };
 
+// REPOWERD_PARALLEL_STARTUP is the number of threads to build objects
+// with, so empty, 0, 1 or false build them serially, and true uses a
+// thread per core. Counts are clamped to max_parallel_startup_threads.
+// Returns 0 for values that are none of these.
+size_t const max_parallel_startup_threads{32};
+
+size_t parallel_startup_concurrency(std::string const& value)
+{
+    if (value.empty() || value == "false" || value == "no" || value == "off")
+        return 1;
+
+    if (value == "true" || value == "yes" || value == "on")
+    {
+        return std::min<size_t>(
+            max_parallel_startup_threads,
+            std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    if (value.find_first_not_of("0123456789") != std::string::npos)
+        return 0;
+
+    // Huge counts would overflow, and are clamped anyway
+    auto const significant = value.find_first_not_of('0');
+    if (significant == std::string::npos)
+        return 1;
+    if (value.size() - significant > 9)
+        return max_parallel_startup_threads;
+
+    auto const threads = std::stoul(value.substr(significant));
+    return std::min<size_t>(max_parallel_startup_threads, std::max<size_t>(1, threads));
+}
+
+// Checks that the build_all() task running in this thread, if any, depends
+// on the named object. Only debug builds check, so that the accessors stay
+// cheap in release builds, where build_all() tasks are known to be correct.
+void check_task_dependency(char const* name)
+{
+#ifndef NDEBUG
+    repowerd::TaskGraph::check_dependency(name);
+#else
+    (void)name;
+#endif
+}
+
 struct NullWakeupService : repowerd::WakeupService
 {
     std::string schedule_wakeup_at(std::chrono::system_clock::time_point) override
@@ -136,6 +200,8 @@ struct NullWakeupService : repowerd::WakeupService
 std::shared_ptr<repowerd::BrightnessControl>
 repowerd::DefaultDaemonConfig::the_brightness_control()
 {
+    check_task_dependency("brightness_control");
+
     if (!brightness_control)
     try
     {
@@ -160,6 +226,8 @@ repowerd::DefaultDaemonConfig::the_client_requests()
 std::shared_ptr<repowerd::DisplayPowerControl>
 repowerd::DefaultDaemonConfig::the_display_power_control()
 {
+    check_task_dependency("display_power_control");
+
     if (!display_power_control)
     {
         display_power_control = std::make_shared<UnityDisplayPowerControl>(
@@ -175,6 +243,39 @@ repowerd::DefaultDaemonConfig::the_display_power_event_sink()
     return the_unity_screen_service();
 }
 
+std::shared_ptr<repowerd::EventJournal>
+repowerd::DefaultDaemonConfig::the_event_journal()
+{
+    check_task_dependency("event_journal");
+
+    if (!event_journal)
+    {
+        auto const journal_env_cstr = getenv("REPOWERD_EVENT_JOURNAL");
+        std::string const journal_env{journal_env_cstr ? journal_env_cstr : ""};
+
+        if (journal_env.empty())
+        {
+            event_journal = std::make_shared<NullEventJournal>();
+        }
+        else
+        {
+            event_journal = std::make_shared<FileEventJournal>(journal_env);
+            the_log()->log(log_tag, "Recording events to journal %s", journal_env.c_str());
+        }
+    }
+    return event_journal;
+}
+
+std::shared_ptr<repowerd::EventStats>
+repowerd::DefaultDaemonConfig::the_event_stats()
+{
+    check_task_dependency("event_stats");
+
+    if (!event_stats)
+        event_stats = std::make_shared<EventStats>();
+    return event_stats;
+}
+
 std::shared_ptr<repowerd::ModemPowerControl>
 repowerd::DefaultDaemonConfig::the_modem_power_control()
 {
@@ -190,6 +291,8 @@ repowerd::DefaultDaemonConfig::the_notification_service()
 std::shared_ptr<repowerd::PerformanceBooster>
 repowerd::DefaultDaemonConfig::the_performance_booster()
 {
+    check_task_dependency("performance_booster");
+
     if (!performance_booster)
     try
     {
@@ -222,10 +325,26 @@ repowerd::DefaultDaemonConfig::the_power_button_event_sink()
 std::shared_ptr<repowerd::PowerSource>
 repowerd::DefaultDaemonConfig::the_power_source()
 {
+    check_task_dependency("power_source");
+
     if (!power_source)
     {
-        power_source = std::make_shared<UPowerPowerSource>(
-            the_log(), the_temporary_suspend_inhibition(), *the_device_config(), the_dbus_bus_address());
+        auto const power_source_env_cstr = getenv("REPOWERD_POWER_SOURCE");
+        std::string const power_source_env{power_source_env_cstr ? power_source_env_cstr : ""};
+
+        if (power_source_env == "sysfs")
+        {
+            power_source = std::make_shared<SysfsPowerSource>(
+                the_event_loop_reactor(), the_log(), the_temporary_suspend_inhibition(),
+                the_filesystem(), *the_device_config());
+            the_log()->log(log_tag, "Using sysfs power supplies as the power source");
+        }
+        else
+        {
+            power_source = std::make_shared<UPowerPowerSource>(
+                the_event_loop_reactor(), the_log(), the_temporary_suspend_inhibition(),
+                *the_device_config(), the_dbus_bus_address());
+        }
     }
 
     return power_source;
@@ -234,12 +353,16 @@ repowerd::DefaultDaemonConfig::the_power_source()
 std::shared_ptr<repowerd::ProximitySensor>
 repowerd::DefaultDaemonConfig::the_proximity_sensor()
 {
+    check_task_dependency("proximity_sensor");
+
     if (!proximity_sensor)
     try
     {
         proximity_sensor = std::make_shared<UbuntuProximitySensor>(
+            the_event_loop_reactor(),
             the_log(),
-            *the_device_quirks());
+            *the_device_quirks(),
+            *the_device_config());
     }
     catch (std::exception const& e)
     {
@@ -255,6 +378,8 @@ repowerd::DefaultDaemonConfig::the_proximity_sensor()
 std::shared_ptr<repowerd::ShutdownControl>
 repowerd::DefaultDaemonConfig::the_shutdown_control()
 {
+    check_task_dependency("shutdown_control");
+
     if (!shutdown_control)
         shutdown_control = std::make_shared<SystemShutdownControl>(the_log());
     return shutdown_control;
@@ -263,6 +388,8 @@ repowerd::DefaultDaemonConfig::the_shutdown_control()
 std::shared_ptr<repowerd::StateMachine>
 repowerd::DefaultDaemonConfig::the_state_machine()
 {
+    check_task_dependency("state_machine");
+
     if (!state_machine)
         state_machine = std::make_shared<DefaultStateMachine>(*this);
     return state_machine;
@@ -271,6 +398,8 @@ repowerd::DefaultDaemonConfig::the_state_machine()
 std::shared_ptr<repowerd::SuspendControl>
 repowerd::DefaultDaemonConfig::the_suspend_control()
 {
+    check_task_dependency("suspend_control");
+
     if (!suspend_control)
     {
         suspend_control = std::make_shared<LibsuspendSuspendControl>(
@@ -282,16 +411,21 @@ repowerd::DefaultDaemonConfig::the_suspend_control()
 std::shared_ptr<repowerd::Timer>
 repowerd::DefaultDaemonConfig::the_timer()
 {
+    check_task_dependency("timer");
+
     if (!timer)
-        timer = std::make_shared<EventLoopTimer>();
+        timer = std::make_shared<EventLoopTimer>(the_event_loop_reactor(), the_log());
     return timer;
 }
 
 std::shared_ptr<repowerd::UserActivity>
 repowerd::DefaultDaemonConfig::the_user_activity()
 {
+    check_task_dependency("user_activity");
+
     if (!user_activity)
-        user_activity = std::make_shared<UnityUserActivity>(the_dbus_bus_address());
+        user_activity = std::make_shared<UnityUserActivity>(
+            the_event_loop_reactor(), the_dbus_bus_address());
     return user_activity;
 }
 
@@ -342,9 +476,108 @@ bool repowerd::DefaultDaemonConfig::turn_on_display_at_startup()
     return true;
 }
 
+void repowerd::DefaultDaemonConfig::run_event_processing_startup(
+    std::function<void()> const& start_event_processing)
+{
+    // The adapters share their bus connections, so a single batch around
+    // all of them needs just one round trip per bus to finish starting
+    DBusEventLoop::RegistrationBatch registration_batch;
+    start_event_processing();
+}
+
+void repowerd::DefaultDaemonConfig::build_all()
+{
+    // Objects are only ever built by their own task, and only after all
+    // the objects they use, so the lazy accessors are safe to call
+    // concurrently while the graph runs. In debug builds, each accessor
+    // checks that it is called from a task that depends on the object, so
+    // a missing dependency fails the startup instead of racing.
+    TaskGraph task_graph;
+
+    task_graph.add_task("log", {}, [this] { the_log(); });
+    task_graph.add_task("filesystem", {}, [this] { the_filesystem(); });
+    task_graph.add_task("chrono", {}, [this] { the_chrono(); });
+    task_graph.add_task("event_stats", {}, [this] { the_event_stats(); });
+    task_graph.add_task("event_loop_reactor", {"log"}, [this] { the_event_loop_reactor(); });
+    task_graph.add_task("timer", {"log", "event_loop_reactor"}, [this] { the_timer(); });
+    task_graph.add_task("user_activity", {"event_loop_reactor"}, [this] { the_user_activity(); });
+    task_graph.add_task("unity_power_button", {"event_loop_reactor"},
+                        [this] { the_unity_power_button(); });
+    task_graph.add_task("event_journal", {"log"}, [this] { the_event_journal(); });
+    task_graph.add_task("device_quirks", {"log"}, [this] { the_device_quirks(); });
+    task_graph.add_task("device_config", {"log", "filesystem"}, [this] { the_device_config(); });
+    task_graph.add_task("suspend_control", {"log"}, [this] { the_suspend_control(); });
+    task_graph.add_task("temporary_suspend_inhibition", {"suspend_control", "event_loop_reactor"},
+                        [this] { the_temporary_suspend_inhibition(); });
+    task_graph.add_task("light_sensor", {"log", "event_loop_reactor"},
+                        [this] { the_light_sensor(); });
+    task_graph.add_task("brightness_control",
+                        {"log", "filesystem", "light_sensor", "chrono",
+                         "device_config", "device_quirks", "event_loop_reactor"},
+                        [this] { the_brightness_control(); });
+    task_graph.add_task("brightness_notification", {"brightness_control"},
+                        [this] { the_brightness_notification(); });
+    task_graph.add_task("wakeup_service", {"log", "filesystem"}, [this] { the_wakeup_service(); });
+    task_graph.add_task("unity_screen_service",
+                        {"wakeup_service", "brightness_notification", "event_stats", "log",
+                         "suspend_control", "temporary_suspend_inhibition", "device_config",
+                         "event_loop_reactor"},
+                        [this] { the_unity_screen_service(); });
+    task_graph.add_task("display_power_control", {"log"}, [this] { the_display_power_control(); });
+    task_graph.add_task("ofono_voice_call_service", {"log", "event_loop_reactor"},
+                        [this] { the_ofono_voice_call_service(); });
+    task_graph.add_task("performance_booster", {"log"}, [this] { the_performance_booster(); });
+    task_graph.add_task("power_source",
+                        {"log", "temporary_suspend_inhibition", "device_config", "filesystem",
+                         "event_loop_reactor"},
+                        [this] { the_power_source(); });
+    task_graph.add_task("proximity_sensor",
+                        {"log", "device_quirks", "device_config", "event_loop_reactor"},
+                        [this] { the_proximity_sensor(); });
+    task_graph.add_task("shutdown_control", {"log"}, [this] { the_shutdown_control(); });
+    task_graph.add_task("light_control", {"log", "event_loop_reactor"},
+                        [this] { the_light_control(); });
+    task_graph.add_task("state_machine",
+                        {"brightness_control", "display_power_control", "light_control",
+                         "log", "ofono_voice_call_service", "performance_booster",
+                         "power_source", "proximity_sensor", "shutdown_control",
+                         "suspend_control", "timer", "unity_power_button",
+                         "unity_screen_service", "user_activity", "event_journal"},
+                        [this] { the_state_machine(); });
+
+    auto const parallel_env_cstr = getenv("REPOWERD_PARALLEL_STARTUP");
+    std::string const parallel_env{parallel_env_cstr ? parallel_env_cstr : ""};
+    auto const parallel_concurrency = parallel_startup_concurrency(parallel_env);
+    size_t const max_concurrency = parallel_concurrency ? parallel_concurrency : 1;
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const timings = task_graph.run(max_concurrency);
+    auto const total = std::chrono::steady_clock::now() - start;
+
+    if (!parallel_concurrency)
+    {
+        the_log()->log(log_tag, "Ignoring invalid REPOWERD_PARALLEL_STARTUP value '%s'",
+                       parallel_env.c_str());
+    }
+
+    for (auto const& timing : timings)
+    {
+        the_log()->log(log_tag, "Built %s in %lldms", timing.name.c_str(),
+            static_cast<long long>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(timing.duration).count()));
+    }
+
+    the_log()->log(log_tag, "Built all objects in %lldms using up to %zu threads",
+        static_cast<long long>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(total).count()),
+        max_concurrency);
+}
+
 std::shared_ptr<repowerd::Backlight>
 repowerd::DefaultDaemonConfig::the_backlight()
 {
+    check_task_dependency("brightness_control");
+
     if (!backlight)
     {
         try
@@ -378,6 +611,8 @@ repowerd::DefaultDaemonConfig::the_backlight()
 std::shared_ptr<repowerd::BacklightBrightnessControl>
 repowerd::DefaultDaemonConfig::the_backlight_brightness_control()
 {
+    check_task_dependency("brightness_control");
+
     if (!backlight_brightness_control)
     {
         auto const ab_log_env_cstr = getenv("REPOWERD_LOG_AUTOBRIGHTNESS");
@@ -386,9 +621,11 @@ repowerd::DefaultDaemonConfig::the_backlight_brightness_control()
         auto const ab_log = ab_log_env.empty() ? std::make_shared<NullLog>() : the_log();
 
         backlight_brightness_control = std::make_shared<BacklightBrightnessControl>(
+            the_event_loop_reactor(),
             the_backlight(),
             the_light_sensor(),
-            std::make_shared<AndroidAutobrightnessAlgorithm>(*the_device_config(), ab_log), 
+            std::make_shared<AndroidAutobrightnessAlgorithm>(
+                *the_device_config(), the_chrono(), ab_log),
             the_chrono(),
             the_log(),
             *the_device_config(),
@@ -401,6 +638,8 @@ repowerd::DefaultDaemonConfig::the_backlight_brightness_control()
 std::shared_ptr<repowerd::BrightnessNotification>
 repowerd::DefaultDaemonConfig::the_brightness_notification()
 {
+    check_task_dependency("brightness_notification");
+
     if (!brightness_notification)
     try
     {
@@ -419,6 +658,8 @@ repowerd::DefaultDaemonConfig::the_brightness_notification()
 std::shared_ptr<repowerd::Chrono>
 repowerd::DefaultDaemonConfig::the_chrono()
 {
+    check_task_dependency("chrono");
+
     if (!chrono)
         chrono = std::make_shared<RealChrono>();
 
@@ -437,6 +678,8 @@ std::string repowerd::DefaultDaemonConfig::the_dbus_bus_address()
 std::shared_ptr<repowerd::DeviceConfig>
 repowerd::DefaultDaemonConfig::the_device_config()
 {
+    check_task_dependency("device_config");
+
     if (!device_config)
     {
         device_config = std::make_shared<AndroidDeviceConfig>(
@@ -452,15 +695,39 @@ repowerd::DefaultDaemonConfig::the_device_config()
 std::shared_ptr<repowerd::DeviceQuirks>
 repowerd::DefaultDaemonConfig::the_device_quirks()
 {
+    check_task_dependency("device_quirks");
+
     if (!device_quirks)
         device_quirks = std::make_shared<AndroidDeviceQuirks>(*the_log());
 
     return device_quirks;
 }
 
+std::shared_ptr<repowerd::EventLoopReactor>
+repowerd::DefaultDaemonConfig::the_event_loop_reactor()
+{
+    check_task_dependency("event_loop_reactor");
+
+    if (!event_loop_reactor)
+    {
+        auto const threads_env_cstr = getenv("REPOWERD_EVENT_LOOP_THREADS");
+        auto const num_threads = threads_env_cstr ? atoi(threads_env_cstr) : 0;
+
+        if (num_threads > 0)
+        {
+            event_loop_reactor = std::make_shared<EventLoopReactor>(num_threads);
+            the_log()->log(log_tag, "Event loops share %d reactor threads", num_threads);
+        }
+    }
+
+    return event_loop_reactor;
+}
+
 std::shared_ptr<repowerd::Filesystem>
 repowerd::DefaultDaemonConfig::the_filesystem()
 {
+    check_task_dependency("filesystem");
+
     if (!filesystem)
         filesystem = std::make_shared<RealFilesystem>();
 
@@ -470,11 +737,13 @@ repowerd::DefaultDaemonConfig::the_filesystem()
 std::shared_ptr<repowerd::LightControl>
 repowerd::DefaultDaemonConfig::the_light_control()
 {
+    check_task_dependency("light_control");
+
     if (!light_control)
     try
     {
         light_control = std::make_shared<UBPortsLightControl>(
-            the_log(), the_dbus_bus_address());
+            the_event_loop_reactor(), the_log(), the_dbus_bus_address());
     }
     catch (std::exception const& e)
     {
@@ -489,10 +758,12 @@ repowerd::DefaultDaemonConfig::the_light_control()
 std::shared_ptr<repowerd::LightSensor>
 repowerd::DefaultDaemonConfig::the_light_sensor()
 {
+    check_task_dependency("light_sensor");
+
     if (!light_sensor)
     try
     {
-        light_sensor = std::make_shared<UbuntuLightSensor>();
+        light_sensor = std::make_shared<UbuntuLightSensor>(the_event_loop_reactor());
     }
     catch (std::exception const& e)
     {
@@ -507,9 +778,12 @@ repowerd::DefaultDaemonConfig::the_light_sensor()
 std::shared_ptr<repowerd::OfonoVoiceCallService>
 repowerd::DefaultDaemonConfig::the_ofono_voice_call_service()
 {
+    check_task_dependency("ofono_voice_call_service");
+
     if (!ofono_voice_call_service)
     {
         ofono_voice_call_service = std::make_shared<OfonoVoiceCallService>(
+            the_event_loop_reactor(),
             the_log(),
             the_dbus_bus_address());
     }
@@ -519,10 +793,12 @@ repowerd::DefaultDaemonConfig::the_ofono_voice_call_service()
 std::shared_ptr<repowerd::TemporarySuspendInhibition>
 repowerd::DefaultDaemonConfig::the_temporary_suspend_inhibition()
 {
+    check_task_dependency("temporary_suspend_inhibition");
+
     if (!temporary_suspend_inhibition)
     {
         temporary_suspend_inhibition = std::make_shared<RealTemporarySuspendInhibition>(
-            the_suspend_control());
+            the_event_loop_reactor(), the_suspend_control());
     }
     return temporary_suspend_inhibition;
 }
@@ -530,6 +806,8 @@ repowerd::DefaultDaemonConfig::the_temporary_suspend_inhibition()
 std::shared_ptr<repowerd::Log>
 repowerd::DefaultDaemonConfig::the_log()
 {
+    check_task_dependency("log");
+
     if (!log)
     {
         auto const log_env_cstr = getenv("REPOWERD_LOG");
@@ -547,11 +825,15 @@ repowerd::DefaultDaemonConfig::the_log()
 std::shared_ptr<repowerd::UnityScreenService>
 repowerd::DefaultDaemonConfig::the_unity_screen_service()
 {
+    check_task_dependency("unity_screen_service");
+
     if (!unity_screen_service)
     {
         unity_screen_service = std::make_shared<UnityScreenService>(
+            the_event_loop_reactor(),
             the_wakeup_service(),
             the_brightness_notification(),
+            the_event_stats(),
             the_log(),
             the_suspend_control(),
             the_temporary_suspend_inhibition(),
@@ -565,14 +847,19 @@ repowerd::DefaultDaemonConfig::the_unity_screen_service()
 std::shared_ptr<repowerd::UnityPowerButton>
 repowerd::DefaultDaemonConfig::the_unity_power_button()
 {
+    check_task_dependency("unity_power_button");
+
     if (!unity_power_button)
-        unity_power_button = std::make_shared<UnityPowerButton>(the_dbus_bus_address());
+        unity_power_button = std::make_shared<UnityPowerButton>(
+            the_event_loop_reactor(), the_dbus_bus_address());
     return unity_power_button;
 }
 
 std::shared_ptr<repowerd::WakeupService>
 repowerd::DefaultDaemonConfig::the_wakeup_service()
 {
+    check_task_dependency("wakeup_service");
+
     if (!wakeup_service)
     try
     {
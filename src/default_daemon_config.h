@@ -29,6 +29,7 @@ class BrightnessNotification;
 class Chrono;
 class DeviceConfig;
 class DeviceQuirks;
+class EventLoopReactor;
 class Filesystem;
 class LightSensor;
 class OfonoVoiceCallService;
@@ -45,6 +46,8 @@ public:
     std::shared_ptr<ClientRequests> the_client_requests() override;
     std::shared_ptr<DisplayPowerControl> the_display_power_control() override;
     std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() override;
+    std::shared_ptr<EventJournal> the_event_journal() override;
+    std::shared_ptr<EventStats> the_event_stats() override;
     std::shared_ptr<Log> the_log() override;
     std::shared_ptr<ModemPowerControl> the_modem_power_control() override;
     std::shared_ptr<NotificationService> the_notification_service() override;
@@ -68,6 +71,17 @@ public:
     std::chrono::milliseconds user_inactivity_reduced_display_off_timeout() override;
 
     bool turn_on_display_at_startup() override;
+    void run_event_processing_startup(
+        std::function<void()> const& start_event_processing) override;
+
+    // Builds all objects up front, following their dependencies. If
+    // REPOWERD_PARALLEL_STARTUP is a thread count above 1, or true for a
+    // thread per core, independent objects are built concurrently. The
+    // construction time of each object is logged.
+    // If REPOWERD_EVENT_LOOP_THREADS is set to N > 0, the event loops of
+    // all adapters share a pool of N threads, instead of running one
+    // thread each.
+    void build_all();
 
     std::shared_ptr<Backlight> the_backlight();
     std::shared_ptr<BacklightBrightnessControl> the_backlight_brightness_control();
@@ -76,6 +90,7 @@ public:
     std::string the_dbus_bus_address();
     std::shared_ptr<DeviceConfig> the_device_config();
     std::shared_ptr<DeviceQuirks> the_device_quirks();
+    std::shared_ptr<EventLoopReactor> the_event_loop_reactor();
     std::shared_ptr<Filesystem> the_filesystem();
     std::shared_ptr<LightSensor> the_light_sensor();
     std::shared_ptr<OfonoVoiceCallService> the_ofono_voice_call_service();
@@ -94,6 +109,9 @@ private:
     std::shared_ptr<DeviceConfig> device_config;
     std::shared_ptr<DeviceQuirks> device_quirks;
     std::shared_ptr<DisplayPowerControl> display_power_control;
+    std::shared_ptr<EventJournal> event_journal;
+    std::shared_ptr<EventLoopReactor> event_loop_reactor;
+    std::shared_ptr<EventStats> event_stats;
     std::shared_ptr<Filesystem> filesystem;
     std::shared_ptr<LightSensor> light_sensor;
     std::shared_ptr<Log> log;
@@ -22,6 +22,8 @@
 
 #include <csignal>
 #include <cstring>
+#include <fstream>
+#include <string>
 
 namespace
 {
@@ -66,6 +68,24 @@ struct SignalHandler
 repowerd::Daemon* SignalHandler::daemon_ptr{nullptr};
 repowerd::Log* SignalHandler::log_ptr{nullptr};
 
+std::string proc_status_value(std::string const& key)
+{
+    std::ifstream status{"/proc/self/status"};
+    std::string line;
+
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, key.size() + 1, key + ":") == 0)
+        {
+            auto const value_start = line.find_first_not_of(" \t", key.size() + 1);
+            if (value_start != std::string::npos)
+                return line.substr(value_start);
+        }
+    }
+
+    return "unknown";
+}
+
 }
 
 int main()
@@ -75,10 +95,23 @@ int main()
 
     log->log(log_tag, "Starting repowerd %s", REPOWERD_VERSION);
 
+    config.build_all();
+
+    log->log(log_tag, "Running with %s threads, RSS %s",
+             proc_status_value("Threads").c_str(),
+             proc_status_value("VmRSS").c_str());
+
     repowerd::Daemon daemon{config};
     SignalHandler signal_handler{&daemon, log.get()};
 
     daemon.run();
 
+    log->log(log_tag, "Coalesced events: user_activity_extending_power_state=%llu, "
+             "set_normal_brightness_value=%llu",
+             static_cast<unsigned long long>(daemon.num_coalesced_events(
+                 repowerd::DaemonEvent::Type::user_activity_extending_power_state)),
+             static_cast<unsigned long long>(daemon.num_coalesced_events(
+                 repowerd::DaemonEvent::Type::set_normal_brightness_value)));
+
     log->log(log_tag, "Exiting repowerd");
 }
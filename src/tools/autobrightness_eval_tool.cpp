@@ -0,0 +1,511 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "src/adapters/android_autobrightness_algorithm.h"
+#include "src/adapters/android_device_config.h"
+#include "src/adapters/backlight.h"
+#include "src/adapters/brightness_animation.h"
+#include "src/adapters/brightness_curve.h"
+#include "src/adapters/chrono.h"
+#include "src/adapters/device_config.h"
+#include "src/adapters/event_loop.h"
+#include "src/adapters/event_loop_reactor.h"
+#include "src/adapters/null_log.h"
+#include "src/adapters/real_filesystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+// Runs the algorithm in simulated time. Scheduled callbacks are queued
+// here instead of being handed to the event loop, and run when the
+// simulated time reaches them, so traces are replayed as fast as the
+// algorithm can process them.
+class SimulatedChrono : public repowerd::Chrono
+{
+public:
+    void sleep_for(std::chrono::nanoseconds t) override
+    {
+        advance_to(now + t);
+    }
+
+    std::chrono::steady_clock::time_point steady_now() override
+    {
+        return std::chrono::steady_clock::time_point{
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(now)};
+    }
+
+    std::unique_ptr<repowerd::Timeout> create_timeout(
+        repowerd::EventLoop&,
+        std::function<void()> const& callback) override
+    {
+        return std::make_unique<SimulatedTimeout>(*this, callback);
+    }
+
+    std::chrono::nanoseconds current_time() const
+    {
+        return now;
+    }
+
+    // Runs the callbacks scheduled up to the specified time, in order
+    void advance_to(std::chrono::nanoseconds t)
+    {
+        while (!timers.empty() && timers.top().time <= t)
+        {
+            auto const timer = timers.top();
+            timers.pop();
+            now = std::max(now, timer.time);
+            timer.callback();
+        }
+
+        now = std::max(now, t);
+    }
+
+    // Runs callbacks until none is pending, or the time limit is reached
+    void run_pending_until(std::chrono::nanoseconds limit)
+    {
+        while (!timers.empty() && timers.top().time <= limit)
+            advance_to(timers.top().time);
+    }
+
+    void reset()
+    {
+        timers = {};
+        now = {};
+    }
+
+private:
+    // Armed timeouts are queued like other callbacks, and dropped when they
+    // run if the timeout has been rearmed or cancelled in the meantime
+    class SimulatedTimeout : public repowerd::Timeout
+    {
+    public:
+        SimulatedTimeout(SimulatedChrono& chrono, std::function<void()> const& callback)
+            : chrono(chrono),
+              state{std::make_shared<State>(State{callback, 0})}
+        {
+        }
+
+        ~SimulatedTimeout()
+        {
+            cancel();
+        }
+
+        void arm_in(std::chrono::nanoseconds t) override
+        {
+            auto const generation = ++state->generation;
+            chrono.timers.push(
+                {chrono.now + t, chrono.next_timer_seqnum++,
+                 [state = state, generation]
+                 {
+                     if (state->generation == generation)
+                         state->callback();
+                 }});
+        }
+
+        void cancel() override
+        {
+            ++state->generation;
+        }
+
+    private:
+        struct State
+        {
+            std::function<void()> callback;
+            int generation;
+        };
+
+        SimulatedChrono& chrono;
+        std::shared_ptr<State> const state;
+    };
+
+    struct Timer
+    {
+        std::chrono::nanoseconds time;
+        uint64_t seqnum;
+        std::function<void()> callback;
+    };
+
+    struct LaterTimer
+    {
+        bool operator()(Timer const& a, Timer const& b) const
+        {
+            return a.time != b.time ? a.time > b.time : a.seqnum > b.seqnum;
+        }
+    };
+
+    std::chrono::nanoseconds now{0};
+    uint64_t next_timer_seqnum{0};
+    std::priority_queue<Timer,std::vector<Timer>,LaterTimer> timers;
+};
+
+// Device config values overridden from the command line, to sweep
+// algorithm parameters without editing the device config files
+class OverridingDeviceConfig : public repowerd::DeviceConfig
+{
+public:
+    OverridingDeviceConfig(repowerd::DeviceConfig const& base)
+        : base{base}
+    {
+    }
+
+    std::string get(std::string const& name, std::string const& default_value) const override
+    {
+        auto const iter = overrides.find(name);
+        if (iter != overrides.end())
+            return iter->second;
+        return base.get(name, default_value);
+    }
+
+    void set(std::string const& name, std::string const& value)
+    {
+        overrides[name] = value;
+    }
+
+private:
+    repowerd::DeviceConfig const& base;
+    std::unordered_map<std::string,std::string> overrides;
+};
+
+struct LightSample
+{
+    std::chrono::milliseconds time;
+    double light;
+};
+
+struct Trace
+{
+    std::string name;
+    std::vector<LightSample> samples;
+};
+
+struct TraceResult
+{
+    int brightness_changes;
+    int backlight_writes;
+    int step_changes;
+    std::chrono::milliseconds total_convergence_time;
+    std::chrono::milliseconds max_convergence_time;
+};
+
+// Traces contain a "<time in ms> <light in lux>" sample per line, in time
+// order. Empty lines and lines starting with '#' are ignored.
+Trace load_trace(std::string const& path)
+{
+    std::ifstream ifs{path};
+    if (!ifs)
+        throw std::runtime_error{"Failed to open trace " + path};
+
+    Trace trace{path, {}};
+    std::string line;
+    int line_num = 0;
+
+    while (std::getline(ifs, line))
+    {
+        ++line_num;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream ss{line};
+        int64_t time_ms;
+        double light;
+
+        if (!(ss >> time_ms >> light) ||
+            (!trace.samples.empty() && time_ms < trace.samples.back().time.count()))
+        {
+            throw std::runtime_error{
+                "Invalid sample at " + path + ":" + std::to_string(line_num)};
+        }
+
+        trace.samples.push_back({std::chrono::milliseconds{time_ms}, light});
+    }
+
+    return trace;
+}
+
+class Evaluator
+{
+public:
+    Evaluator(
+        repowerd::DeviceConfig const& device_config,
+        int max_raw_brightness,
+        double step_factor)
+        : reactor{std::make_shared<repowerd::EventLoopReactor>(0)},
+          event_loop{reactor},
+          chrono{std::make_shared<SimulatedChrono>()},
+          algorithm{device_config, chrono, std::make_shared<repowerd::NullLog>()},
+          brightness_curve{
+              repowerd::BrightnessCurve::from_device_config(device_config, max_raw_brightness)},
+          step_factor{step_factor}
+    {
+        if (!algorithm.init(event_loop))
+            throw std::runtime_error{"Device config doesn't contain autobrightness curves"};
+
+        registration = algorithm.register_autobrightness_handler(
+            [this] (double brightness) { handle_brightness(brightness); });
+    }
+
+    TraceResult evaluate(Trace const& trace)
+    {
+        chrono->reset();
+        result = {0, 0, 0, 0ms, 0ms};
+        brightness = repowerd::Backlight::unknown_brightness;
+        last_brightness_change_time = -1ms;
+
+        auto step_time = -1ms;
+        auto last_light = 0.0;
+
+        algorithm.start();
+
+        for (auto const& sample : trace.samples)
+        {
+            chrono->advance_to(sample.time);
+
+            if (&sample != &trace.samples.front())
+            {
+                auto const ratio = std::max(sample.light, 1.0) / std::max(last_light, 1.0);
+                if (ratio >= step_factor || ratio <= 1.0 / step_factor)
+                {
+                    end_step(step_time);
+                    step_time = sample.time;
+                    last_brightness_change_time = -1ms;
+                }
+            }
+
+            algorithm.new_light_value(sample.light);
+            last_light = sample.light;
+        }
+
+        // Let the algorithm settle after the last sample
+        if (!trace.samples.empty())
+            chrono->run_pending_until(trace.samples.back().time + settle_time);
+
+        end_step(step_time);
+        algorithm.stop();
+
+        return result;
+    }
+
+private:
+    static std::chrono::milliseconds constexpr settle_time{600s};
+
+    std::chrono::milliseconds now() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(chrono->current_time());
+    }
+
+    void handle_brightness(double new_brightness)
+    {
+        if (new_brightness == brightness)
+            return;
+
+        ++result.brightness_changes;
+        last_brightness_change_time = now();
+
+        if (brightness == repowerd::Backlight::unknown_brightness)
+        {
+            ++result.backlight_writes;
+        }
+        else
+        {
+            // Count the frames of the transition BacklightBrightnessControl
+            // would run, skipping frames that don't change the backlight value
+            repowerd::BrightnessAnimation const animation{
+                brightness, new_brightness, 100ms,
+                brightness_curve.raw_levels_between(brightness, new_brightness),
+                repowerd::BrightnessEasing::linear};
+
+            auto backlight_value = brightness_curve.backlight_value_for(brightness);
+
+            for (int i = 0; i < animation.num_frames(); ++i)
+            {
+                auto const frame_backlight_value =
+                    brightness_curve.backlight_value_for(animation.frame_value(i));
+                if (frame_backlight_value != backlight_value)
+                {
+                    ++result.backlight_writes;
+                    backlight_value = frame_backlight_value;
+                }
+            }
+        }
+
+        brightness = new_brightness;
+    }
+
+    // The algorithm has converged after a step change when the brightness
+    // stops changing, i.e., at the last brightness change before the next
+    // step change
+    void end_step(std::chrono::milliseconds step_time)
+    {
+        if (step_time < 0ms)
+            return;
+
+        auto const convergence_time =
+            last_brightness_change_time >= step_time ?
+            last_brightness_change_time - step_time : 0ms;
+
+        ++result.step_changes;
+        result.total_convergence_time += convergence_time;
+        result.max_convergence_time = std::max(result.max_convergence_time, convergence_time);
+    }
+
+    // The loop belongs to this thread and is never dispatched. The algorithm
+    // only uses it to register its handler, which runs immediately, since
+    // its timeouts come from the simulated chrono.
+    std::shared_ptr<repowerd::EventLoopReactor> const reactor;
+    repowerd::EventLoop event_loop;
+    std::shared_ptr<SimulatedChrono> const chrono;
+    repowerd::AndroidAutobrightnessAlgorithm algorithm;
+    repowerd::BrightnessCurve const brightness_curve;
+    double const step_factor;
+    repowerd::HandlerRegistration registration;
+
+    TraceResult result;
+    double brightness;
+    std::chrono::milliseconds last_brightness_change_time;
+};
+
+std::chrono::milliseconds constexpr Evaluator::settle_time;
+
+void usage(char const* prog)
+{
+    std::cerr << "Usage: " << prog << " [OPTION]... TRACE..." << std::endl
+              << "Replays light traces through the autobrightness algorithm in simulated time"
+              << std::endl << std::endl
+              << "  --set KEY=VALUE     override a device config value, e.g.," << std::endl
+              << "                      autoBrightnessDebounceMs=2000" << std::endl
+              << "  --max-raw N         maximum raw backlight value (default 255)" << std::endl
+              << "  --step-factor F     light ratio considered a step change (default 2)"
+              << std::endl
+              << "  --repeat N          evaluate the traces N times, to measure throughput"
+              << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+try
+{
+    repowerd::AndroidDeviceConfig const base_device_config{
+        std::make_shared<repowerd::NullLog>(),
+        std::make_shared<repowerd::RealFilesystem>(),
+        {POWERD_DEVICE_CONFIGS_PATH, REPOWERD_DEVICE_CONFIGS_PATH}};
+    OverridingDeviceConfig device_config{base_device_config};
+    int max_raw_brightness = 255;
+    double step_factor = 2.0;
+    int repeat = 1;
+    std::vector<Trace> traces;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg{argv[i]};
+        bool const has_value = i + 1 < argc;
+
+        if (arg == "--set" && has_value)
+        {
+            std::string const setting{argv[++i]};
+            auto const eq = setting.find('=');
+            if (eq == std::string::npos)
+                throw std::runtime_error{"Invalid setting " + setting};
+            device_config.set(setting.substr(0, eq), setting.substr(eq + 1));
+        }
+        else if (arg == "--max-raw" && has_value)
+        {
+            max_raw_brightness = std::stoi(argv[++i]);
+        }
+        else if (arg == "--step-factor" && has_value)
+        {
+            step_factor = std::stod(argv[++i]);
+        }
+        else if (arg == "--repeat" && has_value)
+        {
+            repeat = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            traces.push_back(load_trace(arg));
+        }
+    }
+
+    if (traces.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Evaluator evaluator{device_config, max_raw_brightness, step_factor};
+    std::vector<TraceResult> results;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < repeat; ++r)
+    {
+        results.clear();
+        for (auto const& trace : traces)
+            results.push_back(evaluator.evaluate(trace));
+    }
+
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    printf("%-32s %8s %8s %6s %12s %12s\n",
+           "trace", "changes", "writes", "steps", "avg conv ms", "max conv ms");
+
+    for (size_t i = 0; i < traces.size(); ++i)
+    {
+        auto const& result = results[i];
+        auto const avg_convergence_ms = result.step_changes ?
+            static_cast<double>(result.total_convergence_time.count()) / result.step_changes :
+            0.0;
+
+        printf("%-32s %8d %8d %6d %12.0f %12lld\n",
+               traces[i].name.c_str(),
+               result.brightness_changes,
+               result.backlight_writes,
+               result.step_changes,
+               avg_convergence_ms,
+               static_cast<long long>(result.max_convergence_time.count()));
+    }
+
+    auto const elapsed_s = std::chrono::duration<double>(elapsed).count();
+    printf("\n%zu trace evaluations in %.3fs (%.0f traces/s)\n",
+           traces.size() * repeat, elapsed_s, traces.size() * repeat / elapsed_s);
+}
+catch (std::exception const& e)
+{
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+}
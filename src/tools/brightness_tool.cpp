@@ -63,7 +63,7 @@ int main()
         else if (line == "o")
         {
             std::cout << "Setting off brightness" << std::endl;
-            brightness_control->set_off_brightness();
+            brightness_control->set_off_brightness([]{});
         }
         else if (line == "ae")
         {
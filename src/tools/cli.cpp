@@ -21,11 +21,26 @@
 #include <gio/gio.h>
 
 #include <csignal>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <stdexcept>
 #include <vector>
 
+namespace
+{
+
+struct EventStats
+{
+    std::string name;
+    std::vector<uint64_t> queue_latency;
+    std::vector<uint64_t> handling_time;
+};
+
+}
+
 std::string get_progname(int argc, char** argv)
 {
     if (argc == 0)
@@ -50,6 +65,7 @@ void show_usage(std::string const& progname)
     std::cerr << "Available commands: " << std::endl;
     std::cerr << "  display <on>: keep display on until program is terminated" << std::endl;
     std::cerr << "  active: inhibit device suspend until program is terminated" << std::endl;
+    std::cerr << "  stats: show queue latency and handling time of daemon events" << std::endl;
 }
 
 std::unique_ptr<GDBusProxy,void(*)(void*)> create_unity_screen_proxy()
@@ -196,6 +212,83 @@ void clear_sys_state(GDBusProxy* powerd_proxy, std::string const& cookie)
     g_variant_unref(ret);
 }
 
+std::vector<uint64_t> get_histogram(GVariantIter* iter)
+{
+    std::vector<uint64_t> histogram;
+    guint64 count{0};
+
+    while (g_variant_iter_next(iter, "t", &count))
+        histogram.push_back(count);
+
+    return histogram;
+}
+
+std::vector<EventStats> get_event_stats(GDBusProxy* powerd_proxy)
+{
+    repowerd::ScopedGError error;
+
+    auto const ret = g_dbus_proxy_call_sync(
+        powerd_proxy,
+        "getEventStats",
+        NULL,
+        G_DBUS_CALL_FLAGS_NONE,
+        -1,
+        NULL,
+        error);
+
+    if (ret == nullptr)
+    {
+        throw std::runtime_error(
+            "com.canonical.powerd.getEventStats() failed: " + error.message_str());
+    }
+
+    std::vector<EventStats> event_stats;
+    GVariantIter* stats_iter{nullptr};
+    char const* name_raw{""};
+    GVariantIter* queue_latency_iter{nullptr};
+    GVariantIter* handling_time_iter{nullptr};
+
+    g_variant_get(ret, "(a(satat))", &stats_iter);
+
+    while (g_variant_iter_next(stats_iter, "(&satat)",
+                               &name_raw, &queue_latency_iter, &handling_time_iter))
+    {
+        event_stats.push_back(
+            {name_raw, get_histogram(queue_latency_iter), get_histogram(handling_time_iter)});
+
+        g_variant_iter_free(queue_latency_iter);
+        g_variant_iter_free(handling_time_iter);
+    }
+
+    g_variant_iter_free(stats_iter);
+    g_variant_unref(ret);
+
+    return event_stats;
+}
+
+// Returns the upper bound of the log2 bucket that contains the requested
+// percentile, formatted as "<Nus"
+std::string percentile_bound(std::vector<uint64_t> const& histogram, double percentile)
+{
+    auto const total = std::accumulate(histogram.begin(), histogram.end(), uint64_t{0});
+    auto const target = static_cast<uint64_t>(total * percentile / 100.0 + 0.5);
+    uint64_t seen{0};
+
+    for (size_t i = 0; i < histogram.size(); ++i)
+    {
+        seen += histogram[i];
+        if (seen >= target && seen > 0)
+        {
+            if (i == histogram.size() - 1)
+                return ">=" + std::to_string(uint64_t{1} << (i - 1)) + "us";
+            else
+                return "<" + std::to_string(uint64_t{1} << i) + "us";
+        }
+    }
+
+    return "-";
+}
+
 
 void handle_display_command(GDBusProxy* uscreen_proxy)
 {
@@ -221,6 +314,36 @@ void handle_active_command(GDBusProxy* uscreen_proxy)
     clear_sys_state(uscreen_proxy, cookie);
 }
 
+void handle_stats_command(GDBusProxy* powerd_proxy)
+{
+    auto const event_stats = get_event_stats(powerd_proxy);
+
+    std::cout << std::left
+              << std::setw(40) << "event"
+              << std::setw(10) << "count"
+              << std::setw(12) << "queue p50"
+              << std::setw(12) << "queue p99"
+              << std::setw(12) << "handle p50"
+              << std::setw(12) << "handle p99" << std::endl;
+
+    for (auto const& stats : event_stats)
+    {
+        auto const count = std::accumulate(
+            stats.queue_latency.begin(), stats.queue_latency.end(), uint64_t{0});
+
+        if (count == 0)
+            continue;
+
+        std::cout << std::setw(40) << stats.name
+                  << std::setw(10) << count
+                  << std::setw(12) << percentile_bound(stats.queue_latency, 50)
+                  << std::setw(12) << percentile_bound(stats.queue_latency, 99)
+                  << std::setw(12) << percentile_bound(stats.handling_time, 50)
+                  << std::setw(12) << percentile_bound(stats.handling_time, 99)
+                  << std::endl;
+    }
+}
+
 void null_signal_handler(int) {}
 
 int main(int argc, char** argv)
@@ -249,6 +372,10 @@ try
     {
         handle_active_command(powerd_proxy.get());
     }
+    else if (args[0] == "stats")
+    {
+        handle_stats_command(powerd_proxy.get());
+    }
 }
 catch (std::exception const& e)
 {
@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "src/adapters/event_loop.h"
+#include "src/adapters/event_loop_reactor.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+long proc_status_kb(std::string const& key)
+{
+    std::ifstream status{"/proc/self/status"};
+    std::string line;
+
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, key.size() + 1, key + ":") == 0)
+            return atol(line.c_str() + key.size() + 1);
+    }
+
+    return -1;
+}
+
+// Passes a callback along a chain of event loops, like an event crossing
+// adapters, and returns the average time per hop
+double ns_per_hop(std::vector<std::unique_ptr<repowerd::EventLoop>>& loops, int rounds)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (auto& loop : loops)
+            loop->enqueue([]{}).get();
+    }
+
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double,std::nano>(elapsed).count() /
+           (rounds * loops.size());
+}
+
+}
+
+// Creates as many event loops as the daemon's adapters use, and reports the
+// threads and memory they take with a dedicated thread per loop and with
+// loops sharing reactor threads
+int main(int argc, char** argv)
+{
+    int const num_loops = argc > 1 ? atoi(argv[1]) : 12;
+    int const rounds = argc > 2 ? atoi(argv[2]) : 10000;
+
+    printf("%-12s %8s %8s %10s %10s %10s\n",
+           "mode", "loops", "threads", "RSS kB", "VM kB", "ns/hop");
+
+    for (auto const reactor_threads : {0, 1, 2})
+    {
+        auto const reactor = reactor_threads > 0 ?
+            std::make_shared<repowerd::EventLoopReactor>(reactor_threads) : nullptr;
+
+        std::vector<std::unique_ptr<repowerd::EventLoop>> loops;
+        for (int i = 0; i < num_loops; ++i)
+            loops.push_back(std::make_unique<repowerd::EventLoop>(reactor));
+
+        auto const hop_ns = ns_per_hop(loops, rounds);
+
+        auto const mode = reactor_threads > 0 ?
+            "reactor(" + std::to_string(reactor_threads) + ")" : std::string{"dedicated"};
+
+        printf("%-12s %8d %8ld %10ld %10ld %10.0f\n",
+               mode.c_str(), num_loops, proc_status_kb("Threads"),
+               proc_status_kb("VmRSS"), proc_status_kb("VmSize"), hop_ns);
+    }
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/adapters/event_loop.h"
+#include "src/adapters/event_loop_timer.h"
+#include "src/adapters/null_log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+// The previous EventLoopTimer implementation: one GSource per alarm, with
+// cancellations delivered through the loop and blocking cancel_alarm()
+class GSourceTimer
+{
+public:
+    ~GSourceTimer()
+    {
+        event_loop.stop();
+        for (auto const& alarm : alarms)
+            alarm.second();
+    }
+
+    repowerd::AlarmId schedule_alarm_in(std::chrono::milliseconds t)
+    {
+        repowerd::AlarmId alarm_id;
+
+        {
+            std::lock_guard<std::mutex> lock{alarms_mutex};
+            alarm_id = next_alarm_id++;
+        }
+
+        event_loop.schedule_with_cancellation_in(
+            t,
+            [this, alarm_id] { cancel_alarm_unqueued(alarm_id); },
+            [this, alarm_id] (repowerd::EventLoopCancellation const& cancellation)
+            {
+                std::lock_guard<std::mutex> lock{alarms_mutex};
+                alarms[alarm_id] = cancellation;
+            });
+
+        return alarm_id;
+    }
+
+    void cancel_alarm(repowerd::AlarmId id)
+    {
+        event_loop.enqueue([this,id] { cancel_alarm_unqueued(id); }).get();
+    }
+
+private:
+    void cancel_alarm_unqueued(repowerd::AlarmId id)
+    {
+        std::lock_guard<std::mutex> lock{alarms_mutex};
+
+        auto const iter = alarms.find(id);
+        if (iter != alarms.end())
+        {
+            iter->second();
+            alarms.erase(iter);
+        }
+    }
+
+    repowerd::EventLoop event_loop;
+    std::mutex alarms_mutex;
+    std::unordered_map<repowerd::AlarmId,repowerd::EventLoopCancellation> alarms;
+    repowerd::AlarmId next_alarm_id{1};
+};
+
+// Reschedules the display dim and off alarms, like the state machine does
+// on every user activity event, with a number of other alarms active
+template <typename TimerType>
+double ns_per_user_activity(TimerType& timer, int iterations, int background_alarms)
+{
+    for (int i = 0; i < background_alarms; ++i)
+        timer.schedule_alarm_in(std::chrono::milliseconds{3600000 + i});
+
+    auto dim_id = timer.schedule_alarm_in(50s);
+    auto off_id = timer.schedule_alarm_in(60s);
+
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        timer.cancel_alarm(dim_id);
+        timer.cancel_alarm(off_id);
+        dim_id = timer.schedule_alarm_in(50s);
+        off_id = timer.schedule_alarm_in(60s);
+    }
+
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double,std::nano>(elapsed).count() / iterations;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int const iterations = argc > 1 ? atoi(argv[1]) : 20000;
+
+    printf("%-16s %10s %14s %14s\n",
+           "timer", "alarms", "ns/activity", "speedup");
+
+    for (auto const background_alarms : {0, 100, 10000})
+    {
+        GSourceTimer gsource_timer;
+        repowerd::EventLoopTimer event_loop_timer{
+            nullptr, std::make_shared<repowerd::NullLog>()};
+
+        auto const gsource_ns =
+            ns_per_user_activity(gsource_timer, iterations, background_alarms);
+        auto const wheel_ns =
+            ns_per_user_activity(event_loop_timer, iterations, background_alarms);
+
+        printf("%-16s %10d %14.0f\n", "GSourceTimer", background_alarms, gsource_ns);
+        printf("%-16s %10d %14.0f %13.1fx\n",
+               "EventLoopTimer", background_alarms, wheel_ns, gsource_ns / wheel_ns);
+    }
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "src/adapters/monotone_spline.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+// The previous MonotoneSpline interpolation: linear scan for the interval
+// and Hermite basis evaluation on every call, with the same tangents
+class ScanningSpline
+{
+public:
+    ScanningSpline(std::vector<repowerd::MonotoneSpline::Point> const& points)
+        : points{points}
+    {
+        // Tangents only affect the cost through the arithmetic done with
+        // them, so use the finite difference ones
+        for (auto i = 0u; i < points.size(); ++i)
+        {
+            auto const prev = i > 0 ? i - 1 : i;
+            auto const next = i < points.size() - 1 ? i + 1 : i;
+            tangents.push_back(
+                (points[next].y - points[prev].y) / (points[next].x - points[prev].x));
+        }
+    }
+
+    double interpolate(double x) const
+    {
+        auto const i = find_index(x);
+
+        if (i < 0)
+            return points.front().y;
+        if (i >= static_cast<int>(points.size() - 1))
+            return points.back().y;
+
+        auto const h = points[i+1].x - points[i].x;
+        auto const t = (x - points[i].x) / h;
+        auto const h00 = t * t * (2 * t - 3) + 1;
+        auto const h10 = t * (1 + t * (t - 2));
+        auto const h01 = t * t * (3 - 2 * t);
+        auto const h11 = t * t * (t - 1);
+
+        return h00 * points[i].y +
+               h10 * h * tangents[i] +
+               h01 * points[i+1].y +
+               h11 * h * tangents[i+1];
+    }
+
+private:
+    int find_index(double x) const
+    {
+        if (x < points[0].x)
+            return -1;
+
+        for (auto i = 0u; i < points.size() - 1; ++i)
+        {
+            if (x >= points[i].x && x < points[i+1].x)
+                return i;
+        }
+
+        return points.size() - 1;
+    }
+
+    std::vector<repowerd::MonotoneSpline::Point> points;
+    std::vector<double> tangents;
+};
+
+// config_autoBrightnessLevels and config_autoBrightnessLcdBacklightValues
+// of the flo device config, as AndroidAutobrightnessAlgorithm builds them
+std::vector<repowerd::MonotoneSpline::Point> const flo_points{
+    {0, 11}, {5, 18}, {15, 27}, {50, 38}, {100, 48}, {200, 55}, {400, 64},
+    {1000, 74}, {2000, 120}, {3000, 164}, {5000, 225}, {10000, 255}, {30000, 255}};
+
+std::vector<repowerd::MonotoneSpline::Point> log_spaced_points(int num_points)
+{
+    std::vector<repowerd::MonotoneSpline::Point> points{{0, 5}};
+    for (int i = 1; i < num_points; ++i)
+    {
+        auto const x = std::pow(10.0, 4.5 * i / (num_points - 1));
+        points.push_back({x, 5 + 250 * std::log10(1 + x) / 4.5});
+    }
+    return points;
+}
+
+std::vector<repowerd::MonotoneSpline::Point> config_points(int config)
+{
+    return config == 0 ? flo_points : log_spaced_points(64);
+}
+
+// Light values are spread over orders of magnitude
+std::vector<double> light_values()
+{
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<double> exponent{-1.0, 4.6};
+
+    std::vector<double> values;
+    for (int i = 0; i < 4096; ++i)
+        values.push_back(std::pow(10.0, exponent(rng)));
+    return values;
+}
+
+repowerd::MonotoneSpline::LookupTableParams const lut_params{1.0, 1000.0, 64};
+
+void label(benchmark::State& state)
+{
+    state.SetLabel(state.range(0) == 0 ? "flo" : "64 points");
+    state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+void BM_ScanningSpline(benchmark::State& state)
+{
+    ScanningSpline const spline{config_points(state.range(0))};
+    auto const in = light_values();
+
+    for (auto _ : state)
+        for (auto const x : in)
+            benchmark::DoNotOptimize(spline.interpolate(x));
+
+    label(state);
+}
+
+void BM_MonotoneSpline(benchmark::State& state)
+{
+    repowerd::MonotoneSpline const spline{config_points(state.range(0))};
+    auto const in = light_values();
+
+    for (auto _ : state)
+        for (auto const x : in)
+            benchmark::DoNotOptimize(spline.interpolate(x));
+
+    label(state);
+}
+
+void BM_MonotoneSplineBatch(benchmark::State& state)
+{
+    repowerd::MonotoneSpline const spline{config_points(state.range(0))};
+    auto const in = light_values();
+    std::vector<double> out(in.size());
+
+    for (auto _ : state)
+    {
+        spline.interpolate(in.data(), out.data(), in.size());
+        benchmark::ClobberMemory();
+    }
+
+    label(state);
+}
+
+void BM_MonotoneSplineLookupTable(benchmark::State& state)
+{
+    repowerd::MonotoneSpline const spline{config_points(state.range(0)), lut_params};
+    auto const in = light_values();
+
+    for (auto _ : state)
+        for (auto const x : in)
+            benchmark::DoNotOptimize(spline.interpolate(x));
+
+    label(state);
+}
+
+void BM_MonotoneSplineLookupTableBatch(benchmark::State& state)
+{
+    repowerd::MonotoneSpline const spline{config_points(state.range(0)), lut_params};
+    auto const in = light_values();
+    std::vector<double> out(in.size());
+
+    for (auto _ : state)
+    {
+        spline.interpolate(in.data(), out.data(), in.size());
+        benchmark::ClobberMemory();
+    }
+
+    label(state);
+}
+
+}
+
+BENCHMARK(BM_ScanningSpline)->Arg(0)->Arg(1);
+BENCHMARK(BM_MonotoneSpline)->Arg(0)->Arg(1);
+BENCHMARK(BM_MonotoneSplineBatch)->Arg(0)->Arg(1);
+BENCHMARK(BM_MonotoneSplineLookupTable)->Arg(0)->Arg(1);
+BENCHMARK(BM_MonotoneSplineLookupTableBatch)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
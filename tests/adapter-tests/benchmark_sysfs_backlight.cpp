@@ -0,0 +1,193 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "src/adapters/fd.h"
+#include "src/adapters/null_log.h"
+#include "src/adapters/real_filesystem.h"
+#include "src/adapters/sysfs_backlight.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Serves a fake sysfs tree from a temporary directory, and counts the
+// system calls each operation takes. Streams take three: open, a read or
+// write, and close.
+class CountingFilesystem : public repowerd::Filesystem
+{
+public:
+    CountingFilesystem(std::string const& root, bool allow_open)
+        : root{root}, allow_open{allow_open}
+    {
+    }
+
+    bool is_regular_file(std::string const& path) const override
+    {
+        ++syscalls;
+        return real_fs.is_regular_file(root + path);
+    }
+
+    std::unique_ptr<std::istream> istream(std::string const& path) const override
+    {
+        syscalls += 3;
+        return real_fs.istream(root + path);
+    }
+
+    std::unique_ptr<std::ostream> ostream(std::string const& path) const override
+    {
+        syscalls += 3;
+        ++raw_writes;
+        return real_fs.ostream(root + path);
+    }
+
+    std::vector<std::string> subdirs(std::string const& path) const override
+    {
+        std::vector<std::string> result;
+        for (auto const& dir : real_fs.subdirs(root + path))
+            result.push_back(dir.substr(root.size()));
+        return result;
+    }
+
+    repowerd::Fd open(char const* pathname, int flags) const override
+    {
+        if (!allow_open)
+            return -1;
+        // The open, and the close when the fd is released
+        syscalls += 2;
+        return real_fs.open((root + pathname).c_str(), flags);
+    }
+
+    int ioctl(int fd, unsigned long request, void* args) const override
+    {
+        ++syscalls;
+        return real_fs.ioctl(fd, request, args);
+    }
+
+    ssize_t pread(int fd, void* buf, size_t count, off_t offset) const override
+    {
+        ++syscalls;
+        return real_fs.pread(fd, buf, count, offset);
+    }
+
+    ssize_t pwrite(int fd, void const* buf, size_t count, off_t offset) const override
+    {
+        ++syscalls;
+        ++raw_writes;
+        auto const written = real_fs.pwrite(fd, buf, count, offset);
+        // Writes replace sysfs attributes, but not regular files, so
+        // truncate (not counted, since sysfs doesn't need it)
+        if (written >= 0 && ftruncate(fd, offset + written) < 0)
+            return -1;
+        return written;
+    }
+
+    mutable int syscalls{0};
+    mutable int raw_writes{0};
+
+private:
+    repowerd::RealFilesystem real_fs;
+    std::string const root;
+    bool const allow_open;
+};
+
+struct RampResult
+{
+    double syscalls_per_ramp;
+    double raw_writes_per_ramp;
+    double us_per_ramp;
+};
+
+// A full 0 => 1 ramp, in the 0.01 steps brightness transitions use
+RampResult ramp(std::string const& root, bool use_fd, int iterations)
+{
+    auto const fs = std::make_shared<CountingFilesystem>(root, use_fd);
+    auto const backlight = std::make_shared<repowerd::SysfsBacklight>(
+        std::make_shared<repowerd::NullLog>(), fs);
+
+    auto const syscalls_before = fs->syscalls;
+    auto const writes_before = fs->raw_writes;
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        backlight->set_brightness(0.0);
+        backlight->get_brightness();
+        for (int step = 1; step <= 100; ++step)
+            backlight->set_brightness(step * 0.01);
+    }
+
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    return {
+        static_cast<double>(fs->syscalls - syscalls_before) / iterations,
+        static_cast<double>(fs->raw_writes - writes_before) / iterations,
+        std::chrono::duration<double,std::micro>(elapsed).count() / iterations};
+}
+
+void write_file(std::string const& path, std::string const& contents)
+{
+    std::ofstream{path} << contents;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int const iterations = argc > 1 ? atoi(argv[1]) : 200;
+
+    char root_template[] = "/tmp/repowerd-sysfs-backlight-benchmark-XXXXXX";
+    std::string const root{mkdtemp(root_template)};
+    std::string const backlight_dir{root + "/sys/class/backlight/panel"};
+
+    for (auto const& dir : {"/sys", "/sys/class", "/sys/class/backlight", "/sys/class/backlight/panel"})
+        mkdir((root + dir).c_str(), 0700);
+
+    write_file(backlight_dir + "/type", "raw");
+    write_file(backlight_dir + "/brightness", "0");
+
+    printf("%-8s %8s %14s %14s %12s\n",
+           "backend", "levels", "syscalls/ramp", "writes/ramp", "us/ramp");
+
+    for (auto const max_brightness : {15, 100, 255, 1023})
+    {
+        write_file(backlight_dir + "/max_brightness", std::to_string(max_brightness));
+
+        auto const stream = ramp(root, false, iterations);
+        auto const fd = ramp(root, true, iterations);
+
+        printf("%-8s %8d %14.0f %14.0f %12.1f\n", "stream", max_brightness,
+               stream.syscalls_per_ramp, stream.raw_writes_per_ramp, stream.us_per_ramp);
+        printf("%-8s %8d %14.0f %14.0f %12.1f\n", "fd", max_brightness,
+               fd.syscalls_per_ramp, fd.raw_writes_per_ramp, fd.us_per_ramp);
+    }
+
+    for (auto const file : {"/type", "/brightness", "/max_brightness"})
+        unlink((backlight_dir + file).c_str());
+    for (auto const& dir : {"/sys/class/backlight/panel", "/sys/class/backlight", "/sys/class", "/sys", ""})
+        rmdir((root + dir).c_str());
+
+    return 0;
+}
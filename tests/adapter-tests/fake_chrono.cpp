@@ -17,9 +17,65 @@
  */
 
 #include "fake_chrono.h"
+#include "src/adapters/event_loop.h"
+
+#include <atomic>
 
 namespace rt = repowerd::test;
 
+namespace
+{
+
+class FakeTimeout : public repowerd::Timeout
+{
+public:
+    FakeTimeout(
+        rt::FakeChrono& chrono,
+        repowerd::EventLoop& event_loop,
+        std::function<void()> const& callback)
+        : chrono(chrono),
+          event_loop(event_loop),
+          state{std::make_shared<State>(callback)}
+    {
+    }
+
+    ~FakeTimeout()
+    {
+        cancel();
+    }
+
+    void arm_in(std::chrono::nanoseconds t) override
+    {
+        auto const generation = ++state->generation;
+        chrono.sleep_for(t);
+        event_loop.post(
+            [state = state, generation]
+            {
+                if (state->generation == generation)
+                    state->callback();
+            });
+    }
+
+    void cancel() override
+    {
+        ++state->generation;
+    }
+
+private:
+    struct State
+    {
+        State(std::function<void()> const& callback) : callback{callback}, generation{0} {}
+        std::function<void()> const callback;
+        std::atomic<int> generation;
+    };
+
+    rt::FakeChrono& chrono;
+    repowerd::EventLoop& event_loop;
+    std::shared_ptr<State> const state;
+};
+
+}
+
 rt::FakeChrono::FakeChrono() : now{0}
 {
 }
@@ -36,3 +92,10 @@ std::chrono::steady_clock::time_point rt::FakeChrono::steady_now()
     using namespace std::chrono;
     return steady_clock::time_point{duration_cast<steady_clock::duration>(now)};
 }
+
+std::unique_ptr<repowerd::Timeout> rt::FakeChrono::create_timeout(
+    EventLoop& event_loop,
+    std::function<void()> const& callback)
+{
+    return std::make_unique<FakeTimeout>(*this, event_loop, callback);
+}
@@ -32,8 +32,13 @@ public:
     FakeChrono();
 
     void sleep_for(std::chrono::nanoseconds t) override;
-
-    std::chrono::steady_clock::time_point steady_now();
+    std::chrono::steady_clock::time_point steady_now() override;
+    // Arming the timeout advances the fake time immediately, and posts the
+    // callback to the event loop, so that expirations run back to back.
+    // Cancelled expirations are dropped when they run.
+    std::unique_ptr<Timeout> create_timeout(
+        EventLoop& event_loop,
+        std::function<void()> const& callback) override;
 
 private:
     std::mutex now_mutex;
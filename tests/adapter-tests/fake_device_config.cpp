@@ -26,6 +26,7 @@ repowerd::test::FakeDeviceConfig::FakeDeviceConfig()
     set("screenBrightnessSettingDefault", std::to_string(brightness_default_value));
     set("automatic_brightness_available", "true");
     set("shutdownBatteryTemperature", std::to_string(shutdown_battery_temperature));
+    set("batteryLevelChangeMinIntervalMs", std::to_string(battery_level_change_min_interval_ms));
 }
 
 std::string repowerd::test::FakeDeviceConfig::get(
@@ -44,6 +44,7 @@ struct FakeDeviceConfig : repowerd::DeviceConfig
     int const brightness_default_value = 50;
     bool const brightness_autobrightness_supported = true;
     int const shutdown_battery_temperature = 990;
+    int const battery_level_change_min_interval_ms = 500;
 
 private:
     std::unordered_map<std::string,std::string> properties;
@@ -21,6 +21,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 
@@ -161,6 +162,36 @@ int repowerd::test::FakeFilesystem::ioctl(
         return ioctl_handlers.at(path)(path.c_str(), request, args);
 }
 
+ssize_t repowerd::test::FakeFilesystem::pread(
+    int fd, void* buf, size_t count, off_t offset) const
+{
+    if (paths.find(fd) == paths.end() || files.find(paths[fd]) == files.end())
+        return -1;
+
+    auto const& contents = files[paths[fd]]->back();
+    if (static_cast<size_t>(offset) >= contents.size())
+        return 0;
+
+    auto const n = std::min(count, contents.size() - offset);
+    contents.copy(static_cast<char*>(buf), n, offset);
+
+    return n;
+}
+
+ssize_t repowerd::test::FakeFilesystem::pwrite(
+    int fd, void const* buf, size_t count, off_t offset) const
+{
+    if (paths.find(fd) == paths.end() || files.find(paths[fd]) == files.end() ||
+        offset != 0)
+    {
+        return -1;
+    }
+
+    files[paths[fd]]->push_back(std::string(static_cast<char const*>(buf), count));
+
+    return count;
+}
+
 void repowerd::test::FakeFilesystem::add_file_with_contents(
     std::string const& path, std::string const& contents)
 {
@@ -45,6 +45,10 @@ public:
 
     Fd open(char const* pathname, int flags) const override;
     int ioctl(int fd, unsigned long request, void* args) const override;
+    // Reads return the latest contents of the file, and each write at
+    // offset 0 replaces them, like for sysfs attributes
+    ssize_t pread(int fd, void* buf, size_t count, off_t offset) const override;
+    ssize_t pwrite(int fd, void const* buf, size_t count, off_t offset) const override;
 
     void add_file_with_contents(std::string const& path, std::string const& contents);
     std::shared_ptr<std::deque<std::string>> add_file_with_live_contents(
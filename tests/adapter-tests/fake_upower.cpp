@@ -197,6 +197,41 @@ void rt::FakeUPower::change_device(std::string const& device_path, DeviceInfo co
     emit_signal_full(device_path.c_str(), "org.freedesktop.DBus.Properties", "PropertiesChanged", params);
 }
 
+void rt::FakeUPower::invalidate_device(std::string const& device_path, DeviceInfo const& info)
+{
+    DeviceInfo old_info;
+
+    {
+        std::lock_guard<std::mutex> lock{devices_mutex};
+
+        old_info = devices[device_path];
+        devices[device_path] = info;
+    }
+
+    std::string invalidated_properties_str;
+    auto const add_invalidated =
+        [&invalidated_properties_str] (std::string const& property)
+        {
+            if (!invalidated_properties_str.empty()) invalidated_properties_str += ", ";
+            invalidated_properties_str += "'" + property + "'";
+        };
+
+    if (old_info.type != info.type) add_invalidated("Type");
+    if (old_info.online != info.online) add_invalidated("Online");
+    if (old_info.percentage != info.percentage) add_invalidated("Percentage");
+    if (old_info.temperature != info.temperature) add_invalidated("Temperature");
+    if (old_info.is_present != info.is_present) add_invalidated("IsPresent");
+    if (old_info.state != info.state) add_invalidated("State");
+
+    auto const params_str =
+        "(@s 'org.freedesktop.UPower.Device',"s +
+        " @a{sv} {}," +
+        " @as [" + invalidated_properties_str + "])";
+
+    auto const params = g_variant_new_parsed(params_str.c_str());
+    emit_signal_full(device_path.c_str(), "org.freedesktop.DBus.Properties", "PropertiesChanged", params);
+}
+
 void rt::FakeUPower::remove_device(std::string const& device_path)
 {
     {
@@ -71,6 +71,9 @@ public:
     void add_device(std::string const& device_path, DeviceInfo const& info);
     void remove_device(std::string const& device_path);
     void change_device(std::string const& device_path, DeviceInfo const& info);
+    // Like change_device(), but reports the changed properties as
+    // invalidated, without their new values
+    void invalidate_device(std::string const& device_path, DeviceInfo const& info);
 
 private:
     void dbus_method_call(
@@ -19,6 +19,7 @@
 #include "src/adapters/android_autobrightness_algorithm.h"
 #include "src/adapters/event_loop.h"
 
+#include "fake_chrono.h"
 #include "fake_device_config.h"
 #include "fake_log.h"
 
@@ -44,6 +45,7 @@ struct AnAndroidAutobrightnessAlgorithm : Test
     }
 
     repowerd::EventLoop event_loop;
+    std::shared_ptr<rt::FakeChrono> const fake_chrono{std::make_shared<rt::FakeChrono>()};
     std::shared_ptr<rt::FakeLog> const fake_log{std::make_shared<rt::FakeLog>()};
 
     rt::FakeDeviceConfig device_config_with_valid_curves;
@@ -58,7 +60,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
     rt::FakeDeviceConfig device_config_without_curves;
 
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_without_curves, fake_log};
+        device_config_without_curves, fake_chrono, fake_log};
 
     EXPECT_FALSE(ab_algorithm.init(event_loop));
 }
@@ -71,7 +73,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
     device_config_with_invalid_curves.set("autoBrightnessLcdBacklightValues", "1,2,3");
 
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_with_invalid_curves, fake_log};
+        device_config_with_invalid_curves, fake_chrono, fake_log};
 
     EXPECT_FALSE(ab_algorithm.init(event_loop));
 }
@@ -80,7 +82,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
        initializes_with_autobrightness_curves_of_correct_size)
 {
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_with_valid_curves, fake_log};
+        device_config_with_valid_curves, fake_chrono, fake_log};
 
     EXPECT_TRUE(ab_algorithm.init(event_loop));
 }
@@ -89,7 +91,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
        reacts_immediately_to_first_light_value_after_started)
 {
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_with_valid_curves, fake_log};
+        device_config_with_valid_curves, fake_chrono, fake_log};
     ASSERT_TRUE(ab_algorithm.init(event_loop));
 
     std::vector<double> ab_values;
@@ -107,7 +109,7 @@ TEST_F(AnAndroidAutobrightnessAlgorithm,
 TEST_F(AnAndroidAutobrightnessAlgorithm, ignores_light_values_when_stopped)
 {
     repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
-        device_config_with_valid_curves, fake_log};
+        device_config_with_valid_curves, fake_chrono, fake_log};
     ASSERT_TRUE(ab_algorithm.init(event_loop));
 
     std::vector<double> ab_values;
@@ -124,3 +126,107 @@ TEST_F(AnAndroidAutobrightnessAlgorithm, ignores_light_values_when_stopped)
     wait_for_event_loop_processing();
     EXPECT_THAT(ab_values, IsEmpty());
 }
+
+TEST_F(AnAndroidAutobrightnessAlgorithm,
+       applies_light_change_beyond_hysteresis_after_debounce_delay)
+{
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, fake_chrono, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(event_loop));
+
+    std::vector<double> ab_values;
+    auto const reg = ab_algorithm.register_autobrightness_handler(
+        [&] (double brightness) { ab_values.push_back(brightness); });
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_value(0.0);
+    wait_for_event_loop_processing();
+
+    auto const start = fake_chrono->steady_now();
+    ab_algorithm.new_light_value(3.0);
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(fake_chrono->steady_now() - start, Ge(std::chrono::seconds{4}));
+    ASSERT_THAT(ab_values.size(), Ge(2));
+    EXPECT_THAT(ab_values.back(), Gt(ab_values.front()));
+}
+
+TEST_F(AnAndroidAutobrightnessAlgorithm, uses_debounce_delay_from_device_config)
+{
+    device_config_with_valid_curves.set("autoBrightnessDebounceMs", "500");
+
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, fake_chrono, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(event_loop));
+
+    auto const reg = ab_algorithm.register_autobrightness_handler([] (double) {});
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_value(0.0);
+    wait_for_event_loop_processing();
+
+    auto const start = fake_chrono->steady_now();
+    ab_algorithm.new_light_value(3.0);
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(fake_chrono->steady_now() - start, Lt(std::chrono::seconds{4}));
+}
+
+TEST_F(AnAndroidAutobrightnessAlgorithm, reports_stable_light_when_light_values_settle)
+{
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, fake_chrono, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(event_loop));
+
+    auto const reg = ab_algorithm.register_autobrightness_handler([] (double) {});
+
+    EXPECT_FALSE(ab_algorithm.light_is_stable());
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_value(100.0);
+    ab_algorithm.new_light_value(101.0);
+    wait_for_event_loop_processing();
+
+    EXPECT_TRUE(ab_algorithm.light_is_stable());
+}
+
+TEST_F(AnAndroidAutobrightnessAlgorithm, reports_unstable_light_after_large_light_change)
+{
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, fake_chrono, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(event_loop));
+
+    auto const reg = ab_algorithm.register_autobrightness_handler([] (double) {});
+
+    ab_algorithm.start();
+    ab_algorithm.new_light_value(100.0);
+    wait_for_event_loop_processing();
+    ASSERT_TRUE(ab_algorithm.light_is_stable());
+
+    event_loop.enqueue([&] { ab_algorithm.new_light_value(500.0); }).get();
+
+    EXPECT_FALSE(ab_algorithm.light_is_stable());
+}
+
+TEST_F(AnAndroidAutobrightnessAlgorithm, does_not_debounce_after_being_stopped)
+{
+    repowerd::AndroidAutobrightnessAlgorithm ab_algorithm{
+        device_config_with_valid_curves, fake_chrono, fake_log};
+    ASSERT_TRUE(ab_algorithm.init(event_loop));
+
+    std::vector<double> ab_values;
+    auto const reg = ab_algorithm.register_autobrightness_handler(
+        [&] (double brightness) { ab_values.push_back(brightness); });
+
+    event_loop.enqueue(
+        [&]
+        {
+            ab_algorithm.start();
+            ab_algorithm.new_light_value(0.0);
+            ab_algorithm.new_light_value(3.0);
+            ab_algorithm.stop();
+        }).get();
+    wait_for_event_loop_processing();
+
+    EXPECT_THAT(ab_values.size(), Eq(1));
+}
@@ -19,6 +19,7 @@
 #include "src/adapters/autobrightness_algorithm.h"
 #include "src/adapters/backlight_brightness_control.h"
 #include "src/adapters/backlight.h"
+#include "src/adapters/brightness_curve.h"
 #include "src/adapters/event_loop_handler_registration.h"
 #include "src/adapters/light_sensor.h"
 
@@ -31,6 +32,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <functional>
+#include <future>
 #include <thread>
 #include <algorithm>
 #include <numeric>
@@ -50,6 +53,8 @@ public:
     void set_brightness(double v) override
     {
         brightness_history.push_back(v);
+        if (brightness_history.size() == call_at_history_size)
+            call_at_history_size_func();
     }
 
     double get_brightness() override
@@ -57,6 +62,11 @@ public:
         return brightness_history.back();
     }
 
+    int max_raw_brightness() override
+    {
+        return 255;
+    }
+
     void clear_brightness_history()
     {
         auto const last = brightness_history.back();
@@ -88,8 +98,16 @@ public:
         return sqrt(accum / (steps.size() - 1));
     }
 
+    void call_when_history_size_is(size_t size, std::function<void()> const& func)
+    {
+        call_at_history_size = size;
+        call_at_history_size_func = func;
+    }
+
     double const starting_brightness = 0.5;
     std::vector<double> brightness_history{starting_brightness};
+    size_t call_at_history_size{0};
+    std::function<void()> call_at_history_size_func;
 };
 
 class FakeLightSensor : public repowerd::LightSensor
@@ -104,7 +122,9 @@ public:
     }
 
     void enable_light_events() override { enabled = true; }
-    void disable_light_events() override { enabled = false; }
+    void disable_light_events() override { enabled = false; reduced_sampling = false; }
+    void enable_reduced_light_sampling() override { reduced_sampling = true; }
+    void disable_reduced_light_sampling() override { reduced_sampling = false; }
 
     void emit_light_if_enabled(double light)
     {
@@ -114,6 +134,7 @@ public:
 
     repowerd::LightHandler light_handler{[](double){}};
     bool enabled{false};
+    bool reduced_sampling{false};
 };
 
 class FakeAutobrightnessAlgorithm : public repowerd::AutobrightnessAlgorithm
@@ -140,6 +161,11 @@ public:
         mock.stop();
     }
 
+    bool light_is_stable() override
+    {
+        return light_stable;
+    }
+
     struct MockMethods
     {
         MOCK_METHOD0(start, void());
@@ -164,6 +190,7 @@ public:
     repowerd::EventLoop* event_loop;
     repowerd::AutobrightnessHandler autobrightness_handler{[](double){}};
     std::vector<double> light_history;
+    bool light_stable{false};
 };
 
 struct ABacklightBrightnessControl : Test
@@ -189,6 +216,7 @@ struct ABacklightBrightnessControl : Test
     rt::FakeLog fake_log;
     rt::FakeDeviceQuirks fake_device_quirks;
     repowerd::BacklightBrightnessControl brightness_control{
+        nullptr,
         rt::fake_shared(backlight), 
         rt::fake_shared(light_sensor), 
         rt::fake_shared(autobrightness_algorithm),
@@ -213,10 +241,39 @@ MATCHER_P(IsAbout, a, "")
 
 }
 
+TEST_F(ABacklightBrightnessControl, notifies_without_blocking_when_brightness_reaches_off)
+{
+    brightness_control.set_normal_brightness();
+    brightness_control.flush();
+
+    // Hold the fade at its first frame until set_off_brightness() returns
+    std::promise<void> request_returned;
+    auto request_returned_future = request_returned.get_future();
+    bool returned_during_fade{false};
+    backlight.call_when_history_size_is(
+        backlight.brightness_history.size() + 1,
+        [&]
+        {
+            returned_during_fade =
+                request_returned_future.wait_for(1s) == std::future_status::ready;
+        });
+
+    std::promise<double> brightness_off;
+    auto brightness_off_future = brightness_off.get_future();
+
+    brightness_control.set_off_brightness(
+        [&] { brightness_off.set_value(backlight.brightness_history.back()); });
+    request_returned.set_value();
+
+    EXPECT_THAT(brightness_off_future.get(), Eq(0.0));
+    EXPECT_TRUE(returned_during_fade);
+}
+
 TEST_F(ABacklightBrightnessControl,
        writes_normal_brightness_based_on_device_config)
 {
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
 
     expect_brightness_value(normal_percent);
 }
@@ -224,7 +281,8 @@ TEST_F(ABacklightBrightnessControl,
 TEST_F(ABacklightBrightnessControl, writes_zero_brightness_value_for_off_brightness)
 {
     brightness_control.set_normal_brightness();
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
 
     expect_brightness_value(0);
 }
@@ -233,6 +291,7 @@ TEST_F(ABacklightBrightnessControl,
        writes_default_dim_brightness_based_on_device_config)
 {
     brightness_control.set_dim_brightness();
+    brightness_control.flush();
 
     expect_brightness_value(dim_percent);
 }
@@ -241,22 +300,27 @@ TEST_F(ABacklightBrightnessControl, sets_write_normal_brightness_value_immediate
 {
     brightness_control.set_normal_brightness();
     brightness_control.set_normal_brightness_value(0.7);
+    brightness_control.flush();
 
     expect_brightness_value(0.7);
 }
 
 TEST_F(ABacklightBrightnessControl, does_not_write_new_normal_brightness_value_if_not_in_normal_mode)
 {
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
     brightness_control.set_normal_brightness_value(0.7);
+    brightness_control.flush();
 
     expect_brightness_value(0);
 }
 
 TEST_F(ABacklightBrightnessControl, transitions_smoothly_between_brightness_values_when_increasing)
 {
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
+    backlight.clear_brightness_history();
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
 
     EXPECT_THAT(backlight.brightness_history.size(), Ge(20));
     EXPECT_THAT(backlight.brightness_steps_stddev(), Le(0.01));
@@ -264,24 +328,199 @@ TEST_F(ABacklightBrightnessControl, transitions_smoothly_between_brightness_valu
 
 TEST_F(ABacklightBrightnessControl, transitions_smoothly_between_brightness_values_when_decreasing)
 {
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
     backlight.clear_brightness_history();
 
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
 
     EXPECT_THAT(backlight.brightness_history.size(), Ge(20));
     EXPECT_THAT(backlight.brightness_steps_stddev(), Le(0.01));
 }
 
+TEST_F(ABacklightBrightnessControl, applies_brightness_requests_in_order)
+{
+    brightness_control.set_normal_brightness();
+    brightness_control.set_dim_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.set_normal_brightness();
+    brightness_control.set_normal_brightness_value(0.7);
+    brightness_control.set_dim_brightness();
+    brightness_control.flush();
+
+    expect_brightness_value(dim_percent);
+}
+
 TEST_F(ABacklightBrightnessControl,
        transitions_between_zero_and_non_zero_brightness_in_100ms)
 {
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
+
+    EXPECT_THAT(
+        duration_of([&]{ brightness_control.set_normal_brightness(); brightness_control.flush(); }),
+        IsAbout(100ms));
+    EXPECT_THAT(
+        duration_of([&]{ brightness_control.set_off_brightness([]{}); brightness_control.flush(); }),
+        IsAbout(100ms));
+    EXPECT_THAT(
+        duration_of([&]{ brightness_control.set_dim_brightness(); brightness_control.flush(); }),
+        IsAbout(100ms));
+}
+
+TEST_F(ABacklightBrightnessControl, retargets_brightness_transition_in_progress)
+{
+    auto const interrupted_at = 11u;
+    backlight.call_when_history_size_is(
+        interrupted_at, [this] { brightness_control.set_normal_brightness_value(0.7); });
+
+    brightness_control.set_normal_brightness();
+    brightness_control.set_normal_brightness_value(0.1);
+    brightness_control.flush();
+
+    auto const& history = backlight.brightness_history;
+    auto const interrupted_brightness = history[interrupted_at - 1];
+
+    // The new target takes effect from the very next frame, starting from
+    // the brightness the interrupted transition had reached
+    EXPECT_THAT(interrupted_brightness, Gt(0.1));
+    EXPECT_THAT(history[interrupted_at], Gt(interrupted_brightness));
+    EXPECT_THAT(*std::min_element(history.begin(), history.end()),
+                Eq(interrupted_brightness));
+    expect_brightness_value(0.7);
+}
+
+TEST_F(ABacklightBrightnessControl, cancels_brightness_transition_in_progress)
+{
+    auto const cancelled_at = 11u;
+    backlight.call_when_history_size_is(
+        cancelled_at, [this] { brightness_control.cancel_brightness_transition(); });
+
+    brightness_control.set_normal_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
+
+    EXPECT_THAT(backlight.brightness_history.size(), Eq(cancelled_at));
+    EXPECT_THAT(backlight.brightness_history.back(), Gt(0.0));
+    EXPECT_TRUE(fake_log.contains_line({"cancelled"}));
+}
+
+TEST_F(ABacklightBrightnessControl, notifies_only_of_final_brightness_of_retargeted_transition)
+{
+    std::vector<double> notified_brightness;
+
+    auto const handler_registration =
+        brightness_control.register_brightness_handler(
+            [&](double brightness) { notified_brightness.push_back(brightness); });
+
+    backlight.call_when_history_size_is(
+        5, [this] { brightness_control.set_dim_brightness(); });
+
+    brightness_control.set_normal_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
+
+    EXPECT_THAT(notified_brightness, ElementsAre(dim_percent));
+}
+
+TEST_F(ABacklightBrightnessControl, maps_brightness_through_perceptual_curve_from_device_config)
+{
+    fake_device_config.set("brightnessCurve", "gamma");
+    auto const curve = repowerd::BrightnessCurve::from_device_config(
+        fake_device_config, backlight.max_raw_brightness());
+
+    repowerd::BacklightBrightnessControl perceptual_brightness_control{
+        nullptr,
+        rt::fake_shared(backlight),
+        rt::fake_shared(light_sensor),
+        rt::fake_shared(autobrightness_algorithm),
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        fake_device_config,
+        fake_device_quirks};
+
+    perceptual_brightness_control.set_normal_brightness();
+    perceptual_brightness_control.set_normal_brightness_value(0.5);
+    perceptual_brightness_control.flush();
+
+    expect_brightness_value(curve.backlight_value_for(0.5));
+}
+
+TEST_F(ABacklightBrightnessControl, ramps_with_fewer_writes_through_perceptual_curve)
+{
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
+    backlight.clear_brightness_history();
+    brightness_control.set_normal_brightness();
+    brightness_control.flush();
+    auto const linear_writes = backlight.brightness_history.size();
+
+    fake_device_config.set("brightnessCurve", "cie_lightness");
+    repowerd::BacklightBrightnessControl perceptual_brightness_control{
+        nullptr,
+        rt::fake_shared(backlight),
+        rt::fake_shared(light_sensor),
+        rt::fake_shared(autobrightness_algorithm),
+        rt::fake_shared(fake_chrono),
+        rt::fake_shared(fake_log),
+        fake_device_config,
+        fake_device_quirks};
+
+    perceptual_brightness_control.set_off_brightness([]{});
+    perceptual_brightness_control.flush();
+    backlight.clear_brightness_history();
+    perceptual_brightness_control.set_normal_brightness();
+    perceptual_brightness_control.flush();
 
-    EXPECT_THAT(duration_of([&]{brightness_control.set_normal_brightness();}), IsAbout(100ms));
-    EXPECT_THAT(duration_of([&]{brightness_control.set_off_brightness();}), IsAbout(100ms));
-    EXPECT_THAT(duration_of([&]{brightness_control.set_dim_brightness();}), IsAbout(100ms));
+    EXPECT_THAT(backlight.brightness_history.size(), Lt(linear_writes));
+    EXPECT_THAT(backlight.brightness_history.size(), Ge(20));
+}
+
+TEST_F(ABacklightBrightnessControl,
+       reduces_light_sampling_while_light_is_stable)
+{
+    brightness_control.set_normal_brightness();
+    brightness_control.enable_autobrightness();
+    brightness_control.flush();
+
+    light_sensor.emit_light_if_enabled(500.0);
+    brightness_control.flush();
+    EXPECT_FALSE(light_sensor.reduced_sampling);
+
+    autobrightness_algorithm.light_stable = true;
+    light_sensor.emit_light_if_enabled(500.0);
+    brightness_control.flush();
+    EXPECT_TRUE(light_sensor.reduced_sampling);
+
+    autobrightness_algorithm.light_stable = false;
+    light_sensor.emit_light_if_enabled(5000.0);
+    brightness_control.flush();
+    EXPECT_FALSE(light_sensor.reduced_sampling);
+}
+
+TEST_F(ABacklightBrightnessControl,
+       reduces_light_sampling_again_after_light_events_are_reenabled)
+{
+    brightness_control.set_normal_brightness();
+    brightness_control.enable_autobrightness();
+    autobrightness_algorithm.light_stable = true;
+    brightness_control.flush();
+
+    light_sensor.emit_light_if_enabled(500.0);
+    brightness_control.flush();
+    ASSERT_TRUE(light_sensor.reduced_sampling);
+
+    brightness_control.set_off_brightness([]{});
+    brightness_control.set_normal_brightness();
+    brightness_control.flush();
+    EXPECT_FALSE(light_sensor.reduced_sampling);
+
+    light_sensor.emit_light_if_enabled(500.0);
+    brightness_control.flush();
+    EXPECT_TRUE(light_sensor.reduced_sampling);
 }
 
 TEST_F(ABacklightBrightnessControl,
@@ -297,6 +536,7 @@ TEST_F(ABacklightBrightnessControl,
 {
     brightness_control.set_normal_brightness();
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     light_sensor.emit_light_if_enabled(500.0);
 
     EXPECT_THAT(autobrightness_algorithm.light_history.size(), Eq(0));
@@ -307,6 +547,7 @@ TEST_F(ABacklightBrightnessControl,
 {
     brightness_control.enable_autobrightness();
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
     light_sensor.emit_light_if_enabled(500.0);
 
     EXPECT_THAT(autobrightness_algorithm.light_history.size(), Eq(0));
@@ -317,7 +558,9 @@ TEST_F(ABacklightBrightnessControl,
 {
     brightness_control.set_normal_brightness();
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.7);
+    brightness_control.flush();
 
     expect_brightness_value(0.7);
 }
@@ -327,7 +570,9 @@ TEST_F(ABacklightBrightnessControl,
 {
     brightness_control.enable_autobrightness();
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.7);
+    brightness_control.flush();
 
     expect_brightness_value(0.7);
 }
@@ -339,11 +584,13 @@ TEST_F(ABacklightBrightnessControl,
 
     brightness_control.enable_autobrightness();
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
 
     EXPECT_THAT(backlight.brightness_history.size(), Eq(prev_history_size));
 
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
 
     expect_brightness_value(0.0);
 }
@@ -353,6 +600,7 @@ TEST_F(ABacklightBrightnessControl,
 {
     fake_device_quirks.set_normal_before_display_on_autobrightness(true);
     repowerd::BacklightBrightnessControl quirked_brightness_control{
+        nullptr,
         rt::fake_shared(backlight), 
         rt::fake_shared(light_sensor), 
         rt::fake_shared(autobrightness_algorithm),
@@ -363,9 +611,11 @@ TEST_F(ABacklightBrightnessControl,
 
     quirked_brightness_control.enable_autobrightness();
     quirked_brightness_control.set_normal_brightness();
-    quirked_brightness_control.set_off_brightness();
+    quirked_brightness_control.set_off_brightness([]{});
+    quirked_brightness_control.flush();
 
     quirked_brightness_control.set_normal_brightness();
+    quirked_brightness_control.flush();
     expect_brightness_value(normal_percent);
 }
 
@@ -373,7 +623,9 @@ TEST_F(ABacklightBrightnessControl,
        ignores_brightness_from_autobrightness_algorithm_if_disabled)
 {
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.7);
+    brightness_control.flush();
 
     expect_brightness_value(normal_percent);
 }
@@ -383,7 +635,9 @@ TEST_F(ABacklightBrightnessControl,
 {
     brightness_control.enable_autobrightness();
     brightness_control.set_dim_brightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.7);
+    brightness_control.flush();
 
     expect_brightness_value(dim_percent);
 }
@@ -393,12 +647,16 @@ TEST_F(ABacklightBrightnessControl,
 {
     brightness_control.set_normal_brightness();
     brightness_control.set_normal_brightness_value(0.7);
+    brightness_control.flush();
 
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.1);
+    brightness_control.flush();
     expect_brightness_value(0.1);
 
     brightness_control.disable_autobrightness();
+    brightness_control.flush();
     expect_brightness_value(0.7);
 }
 
@@ -406,13 +664,17 @@ TEST_F(ABacklightBrightnessControl,
        disabling_autobrightness_leaves_brightness_unchanged_if_not_in_normal_mode)
 {
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
 
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.7);
+    brightness_control.flush();
     expect_brightness_value(0.7);
 
     brightness_control.set_dim_brightness();
     brightness_control.disable_autobrightness();
+    brightness_control.flush();
 
     expect_brightness_value(dim_percent);
 }
@@ -421,10 +683,14 @@ TEST_F(ABacklightBrightnessControl,
        normal_brightness_value_set_by_user_not_applied_if_autobrightness_is_enabled)
 {
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
 
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.7);
+    brightness_control.flush();
     brightness_control.set_normal_brightness_value(0.9);
+    brightness_control.flush();
 
     expect_brightness_value(0.7);
 }
@@ -436,6 +702,7 @@ TEST_F(ABacklightBrightnessControl,
     brightness_control.set_normal_brightness();
     brightness_control.enable_autobrightness();
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     Mock::VerifyAndClearExpectations(&autobrightness_algorithm.mock);
 }
 
@@ -448,6 +715,7 @@ TEST_F(ABacklightBrightnessControl,
     brightness_control.enable_autobrightness();
     brightness_control.disable_autobrightness();
     brightness_control.disable_autobrightness();
+    brightness_control.flush();
     Mock::VerifyAndClearExpectations(&autobrightness_algorithm.mock);
 }
 
@@ -455,7 +723,8 @@ TEST_F(ABacklightBrightnessControl,
        stops_autobrightness_algorithm_when_setting_off_brightness)
 {
     EXPECT_CALL(autobrightness_algorithm.mock, stop()).Times(1);
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
     Mock::VerifyAndClearExpectations(&autobrightness_algorithm.mock);
 }
 
@@ -465,6 +734,7 @@ TEST_F(ABacklightBrightnessControl,
     EXPECT_CALL(autobrightness_algorithm.mock, start()).Times(1);
     brightness_control.enable_autobrightness();
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
     Mock::VerifyAndClearExpectations(&autobrightness_algorithm.mock);
 }
 
@@ -473,11 +743,15 @@ TEST_F(ABacklightBrightnessControl,
 {
     brightness_control.set_normal_brightness();
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.9);
+    brightness_control.flush();
     brightness_control.set_dim_brightness();
+    brightness_control.flush();
     expect_brightness_value(dim_percent);
 
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
 
     expect_brightness_value(0.9);
 }
@@ -492,10 +766,12 @@ TEST_F(ABacklightBrightnessControl, notifies_of_brightness_change)
 
     brightness_control.set_normal_brightness();
     brightness_control.set_normal_brightness_value(0.9);
+    brightness_control.flush();
 
     EXPECT_THAT(notified_brightness, Eq(0.9));
 
     brightness_control.set_dim_brightness();
+    brightness_control.flush();
 
     EXPECT_THAT(notified_brightness, Eq(dim_percent));
 }
@@ -510,7 +786,9 @@ TEST_F(ABacklightBrightnessControl, notifies_of_autobrightness_change)
 
     brightness_control.set_normal_brightness();
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(0.9);
+    brightness_control.flush();
 
     EXPECT_THAT(notified_brightness, Eq(0.9));
 }
@@ -528,14 +806,17 @@ TEST_F(ABacklightBrightnessControl, does_not_notify_if_brightness_does_not_chang
     brightness_control.set_normal_brightness();
     brightness_control.set_normal_brightness_value(backlight.starting_brightness);
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(backlight.starting_brightness);
+    brightness_control.flush();
 
     EXPECT_THAT(notified_brightness, Eq(-1.0));
 }
 
 TEST_F(ABacklightBrightnessControl, logs_brightness_transition)
 {
-    brightness_control.set_off_brightness();
+    brightness_control.set_off_brightness([]{});
+    brightness_control.flush();
 
     EXPECT_TRUE(fake_log.contains_line(
         {std::to_string(normal_percent).substr(0, 4), "0.00", "steps"}));
@@ -546,6 +827,7 @@ TEST_F(ABacklightBrightnessControl, logs_brightness_transition)
 TEST_F(ABacklightBrightnessControl, does_not_log_null_brightness_transition)
 {
     brightness_control.set_normal_brightness();
+    brightness_control.flush();
 
     EXPECT_FALSE(fake_log.contains_line({"steps"}));
     EXPECT_FALSE(fake_log.contains_line({"done"}));
@@ -557,6 +839,7 @@ TEST_F(ABacklightBrightnessControl, transitions_directly_to_new_value_if_current
     auto const prev_history_size = backlight.brightness_history.size();
 
     brightness_control.set_dim_brightness();
+    brightness_control.flush();
 
     EXPECT_THAT(backlight.brightness_history.size(), Eq(prev_history_size + 1));
     expect_brightness_value(dim_percent);
@@ -568,7 +851,9 @@ TEST_F(ABacklightBrightnessControl, logs_autobrightness_values)
 
     brightness_control.set_normal_brightness();
     brightness_control.enable_autobrightness();
+    brightness_control.flush();
     autobrightness_algorithm.emit_autobrightness(autobrightness_value);
+    brightness_control.flush();
 
     EXPECT_TRUE(fake_log.contains_line(
         {"autobrightness", "value", std::to_string(autobrightness_value).substr(0, 4)}));
@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "src/adapters/brightness_animation.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+std::vector<double> frame_values(repowerd::BrightnessAnimation const& animation)
+{
+    std::vector<double> values;
+    for (int i = 0; i < animation.num_frames(); ++i)
+        values.push_back(animation.frame_value(i));
+    return values;
+}
+
+}
+
+TEST(ABrightnessAnimation, has_a_frame_for_each_raw_level_crossed)
+{
+    repowerd::BrightnessAnimation const animation{
+        0.2, 0.6, 100ms, 40, repowerd::BrightnessEasing::linear};
+
+    EXPECT_THAT(animation.num_frames(), Eq(40));
+    EXPECT_THAT(animation.frame_interval(), Eq(2500us));
+}
+
+TEST(ABrightnessAnimation, does_not_show_frames_more_often_than_min_frame_interval)
+{
+    repowerd::BrightnessAnimation const animation{
+        0.0, 1.0, 100ms, 1024, repowerd::BrightnessEasing::linear};
+
+    EXPECT_THAT(animation.num_frames(), Eq(100));
+    EXPECT_THAT(animation.frame_interval(),
+                Ge(repowerd::BrightnessAnimation::min_frame_interval));
+}
+
+TEST(ABrightnessAnimation, has_at_least_one_frame)
+{
+    repowerd::BrightnessAnimation const animation{
+        0.5, 0.501, 100ms, 0, repowerd::BrightnessEasing::linear};
+
+    EXPECT_THAT(animation.num_frames(), Eq(1));
+    EXPECT_THAT(animation.frame_value(0), Eq(0.501));
+}
+
+TEST(ABrightnessAnimation, spaces_frames_evenly_over_its_duration)
+{
+    repowerd::BrightnessAnimation const animation{
+        0.0, 0.1, 100ms, 10, repowerd::BrightnessEasing::linear};
+
+    EXPECT_THAT(animation.frame_time(0), Eq(0us));
+    EXPECT_THAT(animation.frame_time(1), Eq(10ms));
+    EXPECT_THAT(animation.frame_time(9), Eq(90ms));
+}
+
+TEST(ABrightnessAnimation, ends_exactly_at_target_brightness)
+{
+    for (auto const easing : {repowerd::BrightnessEasing::linear,
+                              repowerd::BrightnessEasing::ease_in_out,
+                              repowerd::BrightnessEasing::ease_out})
+    {
+        repowerd::BrightnessAnimation const animation{0.9, 0.13, 100ms, 196, easing};
+
+        EXPECT_THAT(frame_values(animation).back(), Eq(0.13));
+    }
+}
+
+TEST(ABrightnessAnimation, changes_brightness_monotonically_with_all_easings)
+{
+    for (auto const easing : {repowerd::BrightnessEasing::linear,
+                              repowerd::BrightnessEasing::ease_in_out,
+                              repowerd::BrightnessEasing::ease_out})
+    {
+        repowerd::BrightnessAnimation const animation{0.1, 0.8, 100ms, 179, easing};
+        auto const values = frame_values(animation);
+
+        EXPECT_THAT(values.front(), Gt(0.1));
+        EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+    }
+}
+
+TEST(ABrightnessAnimation, uses_equal_steps_with_linear_easing)
+{
+    repowerd::BrightnessAnimation const animation{
+        0.0, 0.5, 100ms, 50, repowerd::BrightnessEasing::linear};
+
+    auto const values = frame_values(animation);
+    for (size_t i = 1; i < values.size(); ++i)
+        EXPECT_THAT(values[i] - values[i - 1], DoubleNear(0.01, 1e-9));
+}
+
+TEST(ABrightnessAnimation, slows_down_towards_the_end_with_ease_out_easing)
+{
+    repowerd::BrightnessAnimation const animation{
+        0.0, 1.0, 100ms, 100, repowerd::BrightnessEasing::ease_out};
+
+    auto const values = frame_values(animation);
+    auto const first_step = values[1] - values[0];
+    auto const last_step = values[values.size() - 1] - values[values.size() - 2];
+
+    EXPECT_THAT(last_step, Lt(first_step));
+}
+
+TEST(ABrightnessAnimation, starts_and_ends_slowly_with_ease_in_out_easing)
+{
+    repowerd::BrightnessAnimation const animation{
+        0.0, 1.0, 100ms, 100, repowerd::BrightnessEasing::ease_in_out};
+
+    auto const values = frame_values(animation);
+    auto const mid = values.size() / 2;
+    auto const first_step = values[1] - values[0];
+    auto const mid_step = values[mid] - values[mid - 1];
+    auto const last_step = values[values.size() - 1] - values[values.size() - 2];
+
+    EXPECT_THAT(first_step, Lt(mid_step));
+    EXPECT_THAT(last_step, Lt(mid_step));
+}
+
+TEST(ABrightnessAnimation, parses_easing_names)
+{
+    auto const def = repowerd::BrightnessEasing::ease_out;
+
+    EXPECT_THAT(repowerd::brightness_easing_from_string("linear", def),
+                Eq(repowerd::BrightnessEasing::linear));
+    EXPECT_THAT(repowerd::brightness_easing_from_string("ease_in_out", def),
+                Eq(repowerd::BrightnessEasing::ease_in_out));
+    EXPECT_THAT(repowerd::brightness_easing_from_string("ease_out", def),
+                Eq(repowerd::BrightnessEasing::ease_out));
+    EXPECT_THAT(repowerd::brightness_easing_from_string("bouncy", def), Eq(def));
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "src/adapters/brightness_curve.h"
+#include "src/adapters/brightness_params.h"
+
+#include "fake_device_config.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <set>
+
+namespace rt = repowerd::test;
+
+using namespace testing;
+
+namespace
+{
+
+struct ABrightnessCurve : Test
+{
+    repowerd::BrightnessCurve curve_of_type(repowerd::BrightnessCurve::Type type)
+    {
+        return repowerd::BrightnessCurve{
+            type, 2.2,
+            repowerd::BrightnessParams::from_device_config(fake_device_config),
+            max_raw_brightness};
+    }
+
+    rt::FakeDeviceConfig fake_device_config;
+    int const max_raw_brightness = 255;
+    double const min_brightness =
+        static_cast<double>(fake_device_config.brightness_min_value) /
+            fake_device_config.brightness_max_value;
+    std::vector<repowerd::BrightnessCurve::Type> const perceptual_types{
+        repowerd::BrightnessCurve::Type::gamma,
+        repowerd::BrightnessCurve::Type::cie_lightness};
+};
+
+}
+
+TEST_F(ABrightnessCurve, is_linear_by_default)
+{
+    auto const curve = repowerd::BrightnessCurve::from_device_config(
+        fake_device_config, max_raw_brightness);
+
+    EXPECT_THAT(curve.type(), Eq(repowerd::BrightnessCurve::Type::linear));
+    EXPECT_THAT(curve.backlight_value_for(0.7123), Eq(0.7123));
+    EXPECT_THAT(curve.brightness_for(0.7123), Eq(0.7123));
+}
+
+TEST_F(ABrightnessCurve, uses_curve_from_device_config)
+{
+    fake_device_config.set("brightnessCurve", "cie_lightness");
+    EXPECT_THAT(repowerd::BrightnessCurve::from_device_config(
+                    fake_device_config, max_raw_brightness).type(),
+                Eq(repowerd::BrightnessCurve::Type::cie_lightness));
+
+    fake_device_config.set("brightnessCurve", "gamma");
+    fake_device_config.set("brightnessCurveGamma", "3.0");
+    auto const gamma_curve = repowerd::BrightnessCurve::from_device_config(
+        fake_device_config, max_raw_brightness);
+
+    EXPECT_THAT(gamma_curve.type(), Eq(repowerd::BrightnessCurve::Type::gamma));
+    EXPECT_THAT(gamma_curve.backlight_value_for(0.5),
+                Lt(curve_of_type(repowerd::BrightnessCurve::Type::gamma).backlight_value_for(0.5)));
+}
+
+TEST_F(ABrightnessCurve, maps_perceived_brightness_to_less_light_in_the_middle)
+{
+    for (auto const type : perceptual_types)
+    {
+        auto const curve = curve_of_type(type);
+
+        EXPECT_THAT(curve.backlight_value_for(0.0), Eq(0.0));
+        EXPECT_THAT(curve.backlight_value_for(0.5), Lt(0.3));
+        EXPECT_THAT(curve.backlight_value_for(1.0), Eq(1.0));
+    }
+}
+
+TEST_F(ABrightnessCurve, maps_to_whole_raw_levels)
+{
+    for (auto const type : perceptual_types)
+    {
+        auto const raw = curve_of_type(type).backlight_value_for(0.6789) * max_raw_brightness;
+        EXPECT_THAT(raw, DoubleNear(std::round(raw), 1e-9));
+    }
+}
+
+TEST_F(ABrightnessCurve, keeps_brightness_up_to_minimum_setting_linear)
+{
+    for (auto const type : perceptual_types)
+    {
+        auto const curve = curve_of_type(type);
+
+        EXPECT_THAT(curve.backlight_value_for(min_brightness),
+                    DoubleNear(min_brightness, 0.5 / max_raw_brightness));
+    }
+}
+
+TEST_F(ABrightnessCurve, does_not_turn_backlight_off_for_non_zero_brightness)
+{
+    for (auto const type : perceptual_types)
+        EXPECT_THAT(curve_of_type(type).backlight_value_for(0.001), Gt(0.0));
+}
+
+TEST_F(ABrightnessCurve, maps_backlight_values_back_to_brightness)
+{
+    for (auto const type : perceptual_types)
+    {
+        auto const curve = curve_of_type(type);
+
+        for (auto const brightness : {0.0, 0.1, 0.25, 0.5, 0.75, 1.0})
+        {
+            auto const backlight_value = curve.backlight_value_for(brightness);
+            EXPECT_THAT(curve.backlight_value_for(curve.brightness_for(backlight_value)),
+                        Eq(backlight_value));
+        }
+    }
+}
+
+TEST_F(ABrightnessCurve, reaches_every_raw_level)
+{
+    for (auto const type : perceptual_types)
+    {
+        auto const curve = curve_of_type(type);
+
+        std::set<double> backlight_values;
+        for (int i = 0; i <= 10000; ++i)
+            backlight_values.insert(curve.backlight_value_for(i / 10000.0));
+
+        EXPECT_THAT(backlight_values.size(), Eq(max_raw_brightness + 1u));
+    }
+}
+
+TEST_F(ABrightnessCurve, crosses_fewer_raw_levels_at_low_brightness)
+{
+    for (auto const type : perceptual_types)
+    {
+        auto const curve = curve_of_type(type);
+
+        EXPECT_THAT(curve.raw_levels_between(0.1, 0.2),
+                    Lt(curve.raw_levels_between(0.8, 0.9)));
+        EXPECT_THAT(curve.raw_levels_between(0.0, 1.0), Eq(max_raw_brightness));
+    }
+}
+
+TEST_F(ABrightnessCurve, uses_default_gamma_for_invalid_gamma_from_device_config)
+{
+    auto const default_gamma_curve = curve_of_type(repowerd::BrightnessCurve::Type::gamma);
+
+    fake_device_config.set("brightnessCurve", "gamma");
+
+    for (auto const gamma : {"0", "-1.5", "nan", "inf", "bogus"})
+    {
+        fake_device_config.set("brightnessCurveGamma", gamma);
+        auto const curve = repowerd::BrightnessCurve::from_device_config(
+            fake_device_config, max_raw_brightness);
+
+        for (auto const brightness : {0.1, 0.5, 0.9})
+        {
+            EXPECT_THAT(curve.backlight_value_for(brightness),
+                        Eq(default_gamma_curve.backlight_value_for(brightness)))
+                << "gamma " << gamma;
+        }
+    }
+}
+
+TEST_F(ABrightnessCurve, counts_brightness_setting_levels_for_linear_curve)
+{
+    auto const curve = curve_of_type(repowerd::BrightnessCurve::Type::linear);
+
+    EXPECT_THAT(curve.raw_levels_between(0.0, 1.0),
+                Eq(fake_device_config.brightness_max_value));
+    EXPECT_THAT(curve.raw_levels_between(0.5, 0.25),
+                Eq(fake_device_config.brightness_max_value / 4));
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_bus.h"
+#include "src/adapters/dbus_connection_handle.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string>
+
+namespace rt = repowerd::test;
+using namespace testing;
+
+namespace
+{
+
+struct ADBusConnectionHandle : testing::Test
+{
+    std::string unique_name(repowerd::DBusConnectionHandle const& handle)
+    {
+        return g_dbus_connection_get_unique_name(handle);
+    }
+
+    rt::DBusBus bus;
+};
+
+}
+
+TEST_F(ADBusConnectionHandle, opens_separate_private_connections)
+{
+    repowerd::DBusConnectionHandle const handle1{bus.address()};
+    repowerd::DBusConnectionHandle const handle2{bus.address()};
+
+    EXPECT_THAT(unique_name(handle1), Ne(unique_name(handle2)));
+}
+
+TEST_F(ADBusConnectionHandle, shares_connection_for_same_address)
+{
+    auto const handle1 = repowerd::DBusConnectionHandle::shared(bus.address());
+    auto const handle2 = repowerd::DBusConnectionHandle::shared(bus.address());
+
+    EXPECT_THAT(static_cast<GDBusConnection*>(handle1),
+                Eq(static_cast<GDBusConnection*>(handle2)));
+}
+
+TEST_F(ADBusConnectionHandle, does_not_share_connection_for_different_addresses)
+{
+    rt::DBusBus other_bus;
+
+    auto const handle1 = repowerd::DBusConnectionHandle::shared(bus.address());
+    auto const handle2 = repowerd::DBusConnectionHandle::shared(other_bus.address());
+
+    EXPECT_THAT(static_cast<GDBusConnection*>(handle1),
+                Ne(static_cast<GDBusConnection*>(handle2)));
+}
+
+TEST_F(ADBusConnectionHandle, keeps_shared_connection_open_while_handles_remain)
+{
+    auto const handle1 = repowerd::DBusConnectionHandle::shared(bus.address());
+    auto const name = unique_name(handle1);
+
+    {
+        auto const handle2 = repowerd::DBusConnectionHandle::shared(bus.address());
+    }
+
+    EXPECT_FALSE(g_dbus_connection_is_closed(handle1));
+    EXPECT_THAT(unique_name(handle1), Eq(name));
+}
+
+TEST_F(ADBusConnectionHandle, reconnects_after_last_shared_handle_goes_away)
+{
+    std::string first_name;
+
+    {
+        auto const handle = repowerd::DBusConnectionHandle::shared(bus.address());
+        first_name = unique_name(handle);
+    }
+
+    auto const handle = repowerd::DBusConnectionHandle::shared(bus.address());
+
+    EXPECT_THAT(unique_name(handle), Ne(first_name));
+}
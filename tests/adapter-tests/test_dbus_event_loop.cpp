@@ -0,0 +1,139 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbus_bus.h"
+#include "dbus_client.h"
+#include "src/adapters/dbus_connection_handle.h"
+#include "src/adapters/dbus_event_loop.h"
+
+#include "wait_condition.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <vector>
+
+namespace rt = repowerd::test;
+using namespace testing;
+
+namespace
+{
+
+char const* const test_interface = "com.test.Interface";
+char const* const test_path = "/com/test/Path";
+
+struct ADBusEventLoop : testing::Test
+{
+    repowerd::HandlerRegistration register_signal_handler(
+        char const* signal, rt::WaitCondition& wait_condition)
+    {
+        return dbus_event_loop.register_signal_handler(
+            dbus_connection,
+            nullptr,
+            test_interface,
+            signal,
+            test_path,
+            [&wait_condition] (
+                GDBusConnection*, gchar const*, gchar const*,
+                gchar const*, gchar const*, GVariant*)
+            {
+                wait_condition.wake_up();
+            });
+    }
+
+    rt::DBusBus bus;
+    repowerd::DBusConnectionHandle dbus_connection{bus.address()};
+    repowerd::DBusEventLoop dbus_event_loop;
+    rt::DBusClient client{bus.address(), "com.test.Service", test_path};
+
+    std::chrono::seconds const default_timeout{3};
+};
+
+}
+
+TEST_F(ADBusEventLoop, delivers_signals_to_handlers_registered_in_finished_batch)
+{
+    rt::WaitCondition signal1_received;
+    rt::WaitCondition signal2_received;
+    std::vector<repowerd::HandlerRegistration> registrations;
+
+    repowerd::DBusEventLoop::RegistrationBatch batch;
+    registrations.push_back(register_signal_handler("Signal1", signal1_received));
+    registrations.push_back(register_signal_handler("Signal2", signal2_received));
+    batch.finish();
+
+    client.emit_signal(test_interface, "Signal1", nullptr);
+    client.emit_signal(test_interface, "Signal2", nullptr);
+
+    signal1_received.wait_for(default_timeout);
+    signal2_received.wait_for(default_timeout);
+    EXPECT_TRUE(signal1_received.woken());
+    EXPECT_TRUE(signal2_received.woken());
+}
+
+TEST_F(ADBusEventLoop, batches_registrations_through_different_event_loops)
+{
+    rt::WaitCondition signal1_received;
+    rt::WaitCondition signal2_received;
+    repowerd::DBusEventLoop other_dbus_event_loop;
+    std::vector<repowerd::HandlerRegistration> registrations;
+
+    repowerd::DBusEventLoop::RegistrationBatch batch;
+    registrations.push_back(register_signal_handler("Signal1", signal1_received));
+    registrations.push_back(
+        other_dbus_event_loop.register_signal_handler(
+            dbus_connection,
+            nullptr,
+            test_interface,
+            "Signal2",
+            test_path,
+            [&signal2_received] (
+                GDBusConnection*, gchar const*, gchar const*,
+                gchar const*, gchar const*, GVariant*)
+            {
+                signal2_received.wake_up();
+            }));
+    batch.finish();
+
+    client.emit_signal(test_interface, "Signal1", nullptr);
+    client.emit_signal(test_interface, "Signal2", nullptr);
+
+    signal1_received.wait_for(default_timeout);
+    signal2_received.wait_for(default_timeout);
+    EXPECT_TRUE(signal1_received.woken());
+    EXPECT_TRUE(signal2_received.woken());
+}
+
+TEST_F(ADBusEventLoop, waits_for_registrations_of_nested_batches_when_outermost_finishes)
+{
+    rt::WaitCondition signal_received;
+    repowerd::HandlerRegistration registration;
+
+    {
+        repowerd::DBusEventLoop::RegistrationBatch outer_batch;
+
+        {
+            repowerd::DBusEventLoop::RegistrationBatch inner_batch;
+            registration = register_signal_handler("Signal1", signal_received);
+        }
+    }
+
+    client.emit_signal(test_interface, "Signal1", nullptr);
+
+    signal_received.wait_for(default_timeout);
+    EXPECT_TRUE(signal_received.woken());
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/adapters/event_loop.h"
+#include "src/adapters/event_loop_reactor.h"
+#include "src/adapters/event_loop_timeout.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct AnEventLoop : testing::Test
+{
+    repowerd::EventLoop event_loop;
+};
+
+struct AnEventLoopReactor : testing::Test
+{
+    std::thread::id loop_thread_id(repowerd::EventLoop& loop)
+    {
+        std::thread::id id;
+        loop.enqueue([&] { id = std::this_thread::get_id(); }).get();
+        return id;
+    }
+
+    std::shared_ptr<repowerd::EventLoopReactor> const reactor{
+        std::make_shared<repowerd::EventLoopReactor>(2)};
+};
+
+}
+
+TEST_F(AnEventLoop, runs_enqueued_callbacks_in_loop_thread)
+{
+    std::thread::id callback_thread_id;
+
+    event_loop.enqueue(
+        [&] { callback_thread_id = std::this_thread::get_id(); }).get();
+
+    EXPECT_THAT(callback_thread_id, Ne(std::this_thread::get_id()));
+}
+
+TEST_F(AnEventLoop, runs_enqueued_and_posted_callbacks_in_order)
+{
+    std::vector<int> order;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (i % 2)
+            event_loop.post([&order, i] { order.push_back(i); });
+        else
+            event_loop.enqueue([&order, i] { order.push_back(i); });
+    }
+    event_loop.enqueue([]{}).get();
+
+    ASSERT_THAT(order.size(), Eq(1000u));
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_THAT(order[i], Eq(i));
+}
+
+TEST_F(AnEventLoop, runs_callbacks_posted_from_multiple_threads)
+{
+    int const num_threads = 4;
+    int const callbacks_per_thread = 1000;
+    int count = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back(
+            [&]
+            {
+                for (int i = 0; i < callbacks_per_thread; ++i)
+                    event_loop.post([&count] { ++count; });
+            });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    event_loop.enqueue([]{}).get();
+
+    EXPECT_THAT(count, Eq(num_threads * callbacks_per_thread));
+}
+
+TEST_F(AnEventLoop, runs_callbacks_enqueued_from_callbacks)
+{
+    bool inner_called = false;
+
+    event_loop.enqueue(
+        [&] { event_loop.post([&] { inner_called = true; }); }).get();
+    event_loop.enqueue([]{}).get();
+
+    EXPECT_TRUE(inner_called);
+}
+
+TEST_F(AnEventLoop, runs_callbacks_enqueued_from_callbacks_after_current_callback)
+{
+    std::vector<int> order;
+
+    event_loop.enqueue(
+        [&]
+        {
+            event_loop.enqueue([&] { order.push_back(2); });
+            order.push_back(1);
+        }).get();
+    event_loop.enqueue([]{}).get();
+
+    EXPECT_THAT(order, ElementsAre(1, 2));
+}
+
+TEST_F(AnEventLoop, propagates_exceptions_of_enqueued_callbacks)
+{
+    auto future = event_loop.enqueue([] { throw std::runtime_error{"error"}; });
+
+    EXPECT_THROW({ future.get(); }, std::runtime_error);
+}
+
+TEST_F(AnEventLoop, keeps_running_after_posted_callback_throws)
+{
+    bool called = false;
+
+    event_loop.post([] { throw std::runtime_error{"error"}; });
+    event_loop.enqueue([&] { called = true; }).get();
+
+    EXPECT_TRUE(called);
+}
+
+TEST_F(AnEventLoop, runs_timeout_callback_when_timeout_expires)
+{
+    std::atomic<int> calls{0};
+    repowerd::EventLoopTimeout timeout{event_loop, [&] { ++calls; }};
+
+    timeout.arm_in(10ms);
+    std::this_thread::sleep_for(100ms);
+
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST_F(AnEventLoop, does_not_run_callback_of_cancelled_timeout)
+{
+    std::atomic<int> calls{0};
+    repowerd::EventLoopTimeout timeout{event_loop, [&] { ++calls; }};
+
+    timeout.arm_in(20ms);
+    timeout.cancel();
+    std::this_thread::sleep_for(100ms);
+
+    EXPECT_THAT(calls, Eq(0));
+}
+
+TEST_F(AnEventLoop, replaces_pending_timeout_expiration_when_rearmed)
+{
+    std::atomic<int> calls{0};
+    repowerd::EventLoopTimeout timeout{event_loop, [&] { ++calls; }};
+
+    timeout.arm_in(20ms);
+    timeout.arm_in(500ms);
+    std::this_thread::sleep_for(100ms);
+    EXPECT_THAT(calls, Eq(0));
+
+    timeout.arm_in(10ms);
+    timeout.arm_in(10ms);
+    std::this_thread::sleep_for(100ms);
+    EXPECT_THAT(calls, Eq(1));
+}
+
+TEST_F(AnEventLoop, allows_rearming_timeout_from_its_callback)
+{
+    std::atomic<int> calls{0};
+    std::unique_ptr<repowerd::EventLoopTimeout> timeout;
+    timeout = std::make_unique<repowerd::EventLoopTimeout>(
+        event_loop,
+        [&] { if (++calls < 3) timeout->arm_in(5ms); });
+
+    timeout->arm_in(5ms);
+    std::this_thread::sleep_for(200ms);
+
+    EXPECT_THAT(calls, Eq(3));
+
+    event_loop.enqueue([&] { timeout.reset(); }).get();
+}
+
+TEST_F(AnEventLoopReactor, runs_event_loops_in_its_threads)
+{
+    repowerd::EventLoop loop1{reactor};
+    repowerd::EventLoop loop2{reactor};
+    repowerd::EventLoop loop3{reactor};
+
+    auto const thread1 = loop_thread_id(loop1);
+    auto const thread2 = loop_thread_id(loop2);
+
+    EXPECT_THAT(thread1, Ne(std::this_thread::get_id()));
+    EXPECT_THAT(thread2, Ne(std::this_thread::get_id()));
+    EXPECT_THAT(thread2, Ne(thread1));
+    EXPECT_THAT(loop_thread_id(loop3), Eq(thread1));
+}
+
+TEST_F(AnEventLoopReactor, is_not_used_by_event_loops_created_without_it)
+{
+    repowerd::EventLoop reactor_loop1{reactor};
+    repowerd::EventLoop reactor_loop2{reactor};
+    repowerd::EventLoop dedicated_loop1;
+    repowerd::EventLoop dedicated_loop2{nullptr};
+
+    std::set<std::thread::id> const reactor_threads{
+        loop_thread_id(reactor_loop1), loop_thread_id(reactor_loop2)};
+
+    EXPECT_THAT(reactor_threads.count(loop_thread_id(dedicated_loop1)), Eq(0u));
+    EXPECT_THAT(reactor_threads.count(loop_thread_id(dedicated_loop2)), Eq(0u));
+    EXPECT_THAT(loop_thread_id(dedicated_loop2), Ne(loop_thread_id(dedicated_loop1)));
+}
+
+TEST_F(AnEventLoopReactor, runs_callbacks_enqueued_from_event_loop_sharing_thread_immediately)
+{
+    repowerd::EventLoop loop1{reactor};
+    repowerd::EventLoop loop2{reactor};
+    repowerd::EventLoop loop3{reactor};
+
+    bool inner_called = false;
+
+    loop1.enqueue(
+        [&]
+        {
+            loop3.enqueue([&] { inner_called = true; }).get();
+            EXPECT_TRUE(inner_called);
+        }).get();
+
+    EXPECT_TRUE(inner_called);
+}
+
+TEST_F(AnEventLoopReactor, runs_callbacks_enqueued_from_event_loop_sharing_thread_after_pending_ones)
+{
+    repowerd::EventLoop loop1{reactor};
+    repowerd::EventLoop loop2{reactor};
+    repowerd::EventLoop loop3{reactor};
+
+    std::vector<int> order;
+
+    loop1.enqueue(
+        [&]
+        {
+            loop3.post([&] { order.push_back(1); });
+            loop3.enqueue([&] { order.push_back(2); }).get();
+        }).get();
+
+    EXPECT_THAT(order, ElementsAre(1, 2));
+}
+
+TEST_F(AnEventLoopReactor, runs_callbacks_enqueued_from_own_callbacks_in_order)
+{
+    repowerd::EventLoop loop{reactor};
+
+    std::vector<int> order;
+
+    loop.enqueue(
+        [&]
+        {
+            loop.enqueue([&] { order.push_back(2); });
+            order.push_back(1);
+        }).get();
+    loop.enqueue([]{}).get();
+
+    EXPECT_THAT(order, ElementsAre(1, 2));
+}
+
+TEST_F(AnEventLoopReactor, without_threads_runs_event_loops_in_creating_thread)
+{
+    auto const threadless_reactor = std::make_shared<repowerd::EventLoopReactor>(0);
+    repowerd::EventLoop loop{threadless_reactor};
+
+    std::thread::id enqueued_thread_id;
+    bool posted_called = false;
+
+    loop.enqueue([&] { enqueued_thread_id = std::this_thread::get_id(); }).get();
+    loop.post([&] { posted_called = true; });
+
+    EXPECT_THAT(enqueued_thread_id, Eq(std::this_thread::get_id()));
+    EXPECT_FALSE(posted_called);
+
+    threadless_reactor->dispatch_pending();
+
+    EXPECT_TRUE(posted_called);
+}
+
+TEST_F(AnEventLoopReactor, does_not_run_callbacks_of_stopped_event_loop)
+{
+    repowerd::EventLoop other_loop{reactor};
+    bool called = false;
+
+    {
+        repowerd::EventLoop loop{reactor};
+        loop.schedule_in(50ms, [&] { called = true; });
+        loop.stop();
+    }
+
+    std::this_thread::sleep_for(100ms);
+    other_loop.enqueue([]{}).get();
+
+    EXPECT_FALSE(called);
+}
@@ -18,6 +18,7 @@
 
 #include "src/adapters/event_loop_timer.h"
 
+#include "fake_log.h"
 #include "wait_condition.h"
 
 #include <gtest/gtest.h>
@@ -35,7 +36,7 @@ namespace
 
 struct AnEventLoopTimer : testing::Test
 {
-    repowerd::EventLoopTimer timer;
+    repowerd::EventLoopTimer timer{nullptr, std::make_shared<rt::FakeLog>()};
     repowerd::HandlerRegistration const reg{
         timer.register_alarm_handler(
             [this](repowerd::AlarmId id) { alarm_handler(id); })};
@@ -133,3 +134,105 @@ TEST_F(AnEventLoopTimer, does_not_notify_for_cancelled_alarms)
 
     std::this_thread::sleep_for(250ms);
 }
+
+TEST_F(AnEventLoopTimer, can_cancel_and_schedule_alarms_from_alarm_handler)
+{
+    auto const id1 = timer.schedule_alarm_in(50ms);
+    auto const id2 = timer.schedule_alarm_in(100ms);
+    repowerd::AlarmId id3;
+
+    rt::WaitCondition alarm_triggered;
+
+    testing::InSequence s;
+    EXPECT_CALL(*this, alarm_handler(id1))
+        .WillOnce(Invoke(
+            [&](repowerd::AlarmId)
+            {
+                timer.cancel_alarm(id2);
+                id3 = timer.schedule_alarm_in(10ms);
+            }));
+    EXPECT_CALL(*this, alarm_handler(id2)).Times(0);
+    EXPECT_CALL(*this, alarm_handler(_))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    alarm_triggered.wait_for(150ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+    EXPECT_THAT(id3, Ne(id2));
+}
+
+TEST_F(AnEventLoopTimer, fires_alarms_with_overlapping_windows_in_single_wakeup)
+{
+    auto const id1 = timer.schedule_alarm_in(50ms, 100ms);
+    auto const id2 = timer.schedule_alarm_in(100ms, 0ms);
+
+    rt::WaitCondition alarm_triggered;
+
+    testing::InSequence s;
+    EXPECT_CALL(*this, alarm_handler(id1));
+    EXPECT_CALL(*this, alarm_handler(id2))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    alarm_triggered.wait_for(200ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+
+    EXPECT_THAT(timer.num_wakeups(), Eq(1u));
+    EXPECT_THAT(timer.num_wakeups_saved(), Eq(1u));
+}
+
+TEST_F(AnEventLoopTimer, fires_alarm_with_slack_by_its_deadline)
+{
+    auto const start = timer.now();
+    std::chrono::steady_clock::time_point fired;
+
+    rt::WaitCondition alarm_triggered;
+
+    EXPECT_CALL(*this, alarm_handler(_))
+        .WillOnce(DoAll(
+            Invoke([&](repowerd::AlarmId) { fired = timer.now(); }),
+            WakeUp(&alarm_triggered)));
+
+    timer.schedule_alarm_in(50ms, 50ms);
+
+    alarm_triggered.wait_for(200ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+    EXPECT_THAT(fired - start, Ge(50ms));
+    EXPECT_THAT(fired - start, Le(120ms));
+}
+
+TEST_F(AnEventLoopTimer, fires_exact_alarms_separately)
+{
+    auto const id1 = timer.schedule_alarm_in(50ms, 100ms);
+    auto const id2 = timer.schedule_alarm_in(60ms);
+    auto const id3 = timer.schedule_alarm_in(100ms);
+
+    rt::WaitCondition alarm_triggered;
+
+    testing::InSequence s;
+    EXPECT_CALL(*this, alarm_handler(id1));
+    EXPECT_CALL(*this, alarm_handler(id2));
+    EXPECT_CALL(*this, alarm_handler(id3))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    alarm_triggered.wait_for(200ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+
+    EXPECT_THAT(timer.num_wakeups(), Eq(2u));
+    EXPECT_THAT(timer.num_wakeups_saved(), Eq(1u));
+}
+
+TEST_F(AnEventLoopTimer, does_not_count_alarms_with_the_same_expiry_as_saved_wakeups)
+{
+    timer.schedule_alarm_in(50ms);
+    auto const id2 = timer.schedule_alarm_in(50ms);
+
+    rt::WaitCondition alarm_triggered;
+
+    EXPECT_CALL(*this, alarm_handler(_)).Times(AnyNumber());
+    EXPECT_CALL(*this, alarm_handler(id2))
+        .WillOnce(WakeUp(&alarm_triggered));
+
+    alarm_triggered.wait_for(200ms);
+    EXPECT_TRUE(alarm_triggered.woken());
+
+    EXPECT_THAT(timer.num_wakeups_saved(), Eq(0u));
+}
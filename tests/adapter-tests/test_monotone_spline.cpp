@@ -104,3 +104,68 @@ TEST_F(AMonotoneSpline, with_fewer_than_two_point_cannot_be_created)
         repowerd::MonotoneSpline({{1,1}});
     }, std::logic_error);
 }
+
+TEST_F(AMonotoneSpline, reproduces_straight_lines)
+{
+    // A straight line has the same tangent everywhere, so any cubic
+    // Hermite interpolation of it must reproduce it exactly
+    repowerd::MonotoneSpline const line{{{0.0, 1.0}, {1.0, 3.0}, {2.0, 5.0}, {4.0, 9.0}}};
+
+    for (auto x = 0.0; x < 4.0; x += 0.01)
+        EXPECT_THAT(line.interpolate(x), DoubleNear(1.0 + 2.0 * x, 1e-12));
+}
+
+TEST_F(AMonotoneSpline, interpolates_batches_of_values)
+{
+    std::vector<double> in;
+    for (auto x = 0.0; x < 1.0; x += 0.005)
+        in.push_back(x);
+    std::vector<double> out(in.size());
+
+    spline.interpolate(in.data(), out.data(), in.size());
+
+    for (auto i = 0u; i < in.size(); ++i)
+        EXPECT_THAT(out[i], Eq(spline.interpolate(in[i])));
+}
+
+TEST_F(AMonotoneSpline, with_lookup_table_approximates_spline)
+{
+    repowerd::MonotoneSpline const lut_spline{points, {0.001, 0.5, 200}};
+
+    for (auto x = 0.0; x < 1.0; x += 0.0037)
+        EXPECT_THAT(lut_spline.interpolate(x), DoubleNear(spline.interpolate(x), 0.001));
+}
+
+TEST_F(AMonotoneSpline, with_lookup_table_returns_original_points_on_table_entries)
+{
+    std::vector<repowerd::MonotoneSpline::Point> const lux_points{
+        {0, 11}, {5, 18}, {15, 27}, {50, 38}, {100, 48}, {200, 55}, {400, 64},
+        {1000, 74}, {2000, 120}, {3000, 164}, {5000, 225}, {10000, 255}, {30000, 255}};
+    repowerd::MonotoneSpline const exact_spline{lux_points};
+    repowerd::MonotoneSpline const lut_spline{lux_points, {1.0, 1000.0, 64}};
+
+    for (auto const& point : lux_points)
+    {
+        if (point.x <= 1000.0)
+        {
+            EXPECT_THAT(lut_spline.interpolate(point.x), DoubleNear(point.y, 1e-9));
+        }
+    }
+
+    for (auto x = 0.0; x < 40000.0; x = x * 1.05 + 0.3)
+    {
+        EXPECT_THAT(lut_spline.interpolate(x),
+                    DoubleNear(exact_spline.interpolate(x), 0.5));
+    }
+}
+
+TEST_F(AMonotoneSpline, with_invalid_lookup_table_params_cannot_be_created)
+{
+    EXPECT_THROW({
+        repowerd::MonotoneSpline(points, {0.0, 0.5, 10});
+    }, std::logic_error);
+
+    EXPECT_THROW({
+        repowerd::MonotoneSpline(points, {0.01, 0.5, 0});
+    }, std::logic_error);
+}
@@ -97,6 +97,7 @@ struct AnOfonoVoiceCallService : testing::Test
     rt::DBusBus bus;
     rt::FakeLog fake_log;
     repowerd::OfonoVoiceCallService ofono_voice_call_service{
+        nullptr,
         rt::fake_shared(fake_log),
         bus.address()};
     rt::FakeOfono ofono{bus.address()};
@@ -20,6 +20,7 @@
 #include "src/adapters/dbus_message_handle.h"
 #include "src/adapters/temporary_suspend_inhibition.h"
 #include "src/adapters/unity_screen_service.h"
+#include "src/core/event_stats.h"
 
 #include "dbus_bus.h"
 #include "dbus_client.h"
@@ -108,6 +109,12 @@ struct PowerdDBusClient : rt::DBusClient
             powerd_interface, "getBrightnessParams", nullptr);
     }
 
+    rt::DBusAsyncReply request_get_event_stats()
+    {
+        return invoke_with_reply<rt::DBusAsyncReply>(
+            powerd_interface, "getEventStats", nullptr);
+    }
+
     repowerd::HandlerRegistration register_wakeup_handler(
         std::function<void()> const& func)
     {
@@ -198,14 +205,17 @@ struct APowerdService : testing::Test
 
     rt::DBusBus bus;
     rt::FakeBrightnessNotification fake_brightness_notification;
+    repowerd::EventStats event_stats;
     rt::FakeDeviceConfig fake_device_config;
     rt::FakeLog fake_log;
     rt::FakeSuspendControl fake_suspend_control;
     rt::FakeWakeupService fake_wakeup_service;
     NiceMock<MockTemporarySuspendInhibition> mock_temporary_suspend_inhibition;
     repowerd::UnityScreenService unity_screen_service{
+        nullptr,
         rt::fake_shared(fake_wakeup_service),
         rt::fake_shared(fake_brightness_notification),
+        rt::fake_shared(event_stats),
         rt::fake_shared(fake_log),
         rt::fake_shared(fake_suspend_control),
         rt::fake_shared(mock_temporary_suspend_inhibition),
@@ -415,6 +425,60 @@ TEST_F(APowerdService, replies_to_get_brightness_params_request)
                 Eq(fake_device_config.brightness_autobrightness_supported));
 }
 
+TEST_F(APowerdService, replies_to_get_event_stats_request)
+{
+    using EventType = repowerd::DaemonEvent::Type;
+
+    event_stats.record(EventType::proximity_far, std::chrono::microseconds{3}, std::chrono::microseconds{0});
+    event_stats.record(EventType::proximity_far, std::chrono::microseconds{3}, std::chrono::microseconds{100});
+
+    auto reply = client.request_get_event_stats().get();
+    auto body = g_dbus_message_get_body(reply);
+
+    GVariantIter* stats_iter;
+    g_variant_get(body, "(a(satat))", &stats_iter);
+
+    std::vector<std::string> names;
+    std::vector<uint64_t> proximity_far_queue_latency;
+    std::vector<uint64_t> proximity_far_handling_time;
+
+    char const* name_cstr{""};
+    GVariantIter* queue_latency_iter;
+    GVariantIter* handling_time_iter;
+
+    while (g_variant_iter_next(stats_iter, "(&satat)",
+                               &name_cstr, &queue_latency_iter, &handling_time_iter))
+    {
+        std::string const name{name_cstr};
+        names.push_back(name);
+
+        guint64 count;
+        while (g_variant_iter_next(queue_latency_iter, "t", &count))
+        {
+            if (name == "proximity_far")
+                proximity_far_queue_latency.push_back(count);
+        }
+        while (g_variant_iter_next(handling_time_iter, "t", &count))
+        {
+            if (name == "proximity_far")
+                proximity_far_handling_time.push_back(count);
+        }
+
+        g_variant_iter_free(queue_latency_iter);
+        g_variant_iter_free(handling_time_iter);
+    }
+
+    g_variant_iter_free(stats_iter);
+
+    EXPECT_THAT(names.size(), Eq(repowerd::DaemonEvent::num_types));
+    EXPECT_THAT(names, Contains("user_activity_extending_power_state"));
+    ASSERT_THAT(proximity_far_queue_latency.size(), Eq(repowerd::EventStats::num_buckets));
+    ASSERT_THAT(proximity_far_handling_time.size(), Eq(repowerd::EventStats::num_buckets));
+    EXPECT_THAT(proximity_far_queue_latency[2], Eq(2u));
+    EXPECT_THAT(proximity_far_handling_time[0], Eq(1u));
+    EXPECT_THAT(proximity_far_handling_time[7], Eq(1u));
+}
+
 TEST_F(APowerdService, emits_brightness_property_change)
 {
     std::promise<int32_t> brightness_promise;
@@ -17,11 +17,13 @@
  */
 
 #include "src/adapters/real_chrono.h"
+#include "src/adapters/event_loop.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
 #include <functional>
+#include <future>
 
 using namespace testing;
 using namespace std::chrono_literals;
@@ -53,3 +55,19 @@ TEST_F(ARealChrono, sleeps_for_right_amount_of_time)
 {
     EXPECT_THAT(duration_of([this]{real_chrono.sleep_for(50ms);}), IsAbout(50ms));
 }
+
+TEST_F(ARealChrono, creates_timeout_that_expires_after_right_amount_of_time)
+{
+    repowerd::EventLoop event_loop;
+    std::promise<void> done;
+    auto const timeout = real_chrono.create_timeout(event_loop, [&] { done.set_value(); });
+
+    EXPECT_THAT(
+        duration_of(
+            [&]
+            {
+                timeout->arm_in(50ms);
+                done.get_future().wait();
+            }),
+        IsAbout(50ms));
+}
@@ -170,3 +170,22 @@ TEST_F(ARealFilesystem, writes_through_ostream)
 
     EXPECT_THAT(file_contents("/file"), StrEq("123"));
 }
+
+TEST_F(ARealFilesystem, reads_through_pread)
+{
+    auto const fd = fs.open(full_path("/file").c_str(), O_RDONLY);
+    char buf[8] = {0};
+
+    EXPECT_THAT(fs.pread(fd, buf, sizeof(buf), 1), Eq(2));
+    EXPECT_THAT(buf, StrEq("bc"));
+}
+
+TEST_F(ARealFilesystem, writes_through_pwrite)
+{
+    {
+        auto const fd = fs.open(full_path("/file").c_str(), O_WRONLY);
+        EXPECT_THAT(fs.pwrite(fd, "12", 2, 1), Eq(2));
+    }
+
+    EXPECT_THAT(file_contents("/file"), StrEq("a12"));
+}
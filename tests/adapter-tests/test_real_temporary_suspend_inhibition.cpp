@@ -39,7 +39,7 @@ struct ARealTemporarySuspendInhibition : Test
 {
     rt::FakeSuspendControl fake_suspend_control;
     repowerd::RealTemporarySuspendInhibition real_temporary_suspend_inhbition{
-        rt::fake_shared(fake_suspend_control)};
+        nullptr, rt::fake_shared(fake_suspend_control)};
 
     std::chrono::milliseconds duration_of(std::function<void()> const& func)
     {
@@ -200,6 +200,34 @@ TEST_F(ASysfsBacklight, gets_real_brightness_if_brightness_changed_externally)
     EXPECT_THAT(backlight->get_brightness(), Eq(102.0/max_brightness));
 }
 
+TEST_F(ASysfsBacklight, does_not_write_brightness_if_raw_value_is_unchanged)
+{
+    set_up_sysfs_backlight();
+
+    auto const backlight = create_sysfs_backlight();
+    backlight->set_brightness(0.5);
+    auto const contents_size = sysfs_backlight->brightness_contents->size();
+
+    backlight->set_brightness(0.501);
+
+    EXPECT_THAT(sysfs_backlight->brightness_contents->size(), Eq(contents_size));
+    EXPECT_THAT(backlight->get_brightness(), Eq(0.501));
+}
+
+TEST_F(ASysfsBacklight, writes_unchanged_raw_value_again_if_brightness_changed_externally)
+{
+    set_up_sysfs_backlight();
+
+    auto const backlight = create_sysfs_backlight();
+    backlight->set_brightness(0.7);
+
+    sysfs_backlight->brightness_contents->push_back("102");
+    backlight->get_brightness();
+    backlight->set_brightness(0.7);
+
+    expect_brightness_value(round(max_brightness * 0.7));
+}
+
 TEST_F(ASysfsBacklight, logs_used_sysfs_backlight_dir)
 {
     set_up_sysfs_backlight();
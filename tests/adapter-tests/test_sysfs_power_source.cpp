@@ -0,0 +1,340 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "src/adapters/sysfs_power_source.h"
+#include "src/adapters/temporary_suspend_inhibition.h"
+
+#include "fake_device_config.h"
+#include "fake_filesystem.h"
+#include "fake_log.h"
+#include "fake_shared.h"
+#include "spin_wait.h"
+#include "wait_condition.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <sys/socket.h>
+
+namespace rt = repowerd::test;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct MockTemporarySuspendInhibition : repowerd::TemporarySuspendInhibition
+{
+    MOCK_METHOD2(inhibit_suspend_for, void(std::chrono::milliseconds,std::string const&));
+};
+
+std::array<int,2> create_uevent_socketpair()
+{
+    std::array<int,2> fds;
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds.data()) == -1)
+        throw std::system_error{errno, std::system_category(), "Failed to create socketpair"};
+    return fds;
+}
+
+struct ASysfsPowerSource : testing::Test
+{
+    ASysfsPowerSource()
+    {
+        registrations.push_back(
+            sysfs_power_source.register_power_source_change_handler(
+                [this] { mock_handlers.power_source_change(); }));
+
+        registrations.push_back(
+            sysfs_power_source.register_power_source_critical_handler(
+                [this] { mock_handlers.power_source_critical(); }));
+
+        registrations.push_back(
+            sysfs_power_source.register_power_source_level_change_handler(
+                [this](repowerd::BatteryInfo* value)
+                {
+                    mock_handlers.power_source_level_change(value);
+                }));
+
+        add_attribute("ac", "type", "Mains");
+        add_attribute("ac", "online", "0");
+        add_battery("battery");
+
+        sysfs_power_source.start_processing();
+    }
+
+    void add_attribute(
+        std::string const& name, std::string const& attribute, std::string const& value)
+    {
+        fake_filesystem.add_file_with_contents(
+            "/sys/class/power_supply/" + name + "/" + attribute, value + "\n");
+    }
+
+    void add_battery(std::string const& name)
+    {
+        add_attribute(name, "type", "Battery");
+        add_attribute(name, "status", "Full");
+        add_attribute(name, "capacity", "100");
+        add_attribute(name, "temp", "180");
+        add_attribute(name, "present", "1");
+    }
+
+    void send_uevent(
+        std::string const& action,
+        std::string const& name,
+        std::vector<std::string> const& properties)
+    {
+        std::vector<std::string> strings{
+            action + "@/devices/platform/battery/power_supply/" + name,
+            "ACTION=" + action,
+            "SUBSYSTEM=power_supply",
+            "POWER_SUPPLY_NAME=" + name};
+        strings.insert(strings.end(), properties.begin(), properties.end());
+
+        std::string uevent;
+        for (auto const& str : strings)
+            uevent.append(str.c_str(), str.size() + 1);
+
+        if (send(uevent_fds[1], uevent.data(), uevent.size(), 0) == -1)
+            throw std::system_error{errno, std::system_category(), "Failed to send uevent"};
+    }
+
+    void wait_for_tracked_batteries(std::unordered_set<std::string> const& batteries)
+    {
+        auto const result = rt::spin_wait_for_condition_or_timeout(
+            [this,&batteries] { return sysfs_power_source.tracked_batteries() == batteries; },
+            default_timeout);
+        if (!result)
+            throw std::runtime_error("Timeout while waiting for tracked batteries");
+    }
+
+    struct MockHandlers
+    {
+        MOCK_METHOD0(power_source_change, void());
+        MOCK_METHOD0(power_source_critical, void());
+        MOCK_METHOD1(power_source_level_change, void(repowerd::BatteryInfo*));
+    };
+    testing::NiceMock<MockHandlers> mock_handlers;
+
+    rt::FakeDeviceConfig fake_device_config;
+    rt::FakeLog fake_log;
+    rt::FakeFilesystem fake_filesystem;
+    NiceMock<MockTemporarySuspendInhibition> mock_temporary_suspend_inhibition;
+    std::array<int,2> const uevent_fds{create_uevent_socketpair()};
+    repowerd::Fd const kernel_uevent_fd{uevent_fds[1]};
+    repowerd::SysfsPowerSource sysfs_power_source{
+        nullptr,
+        rt::fake_shared(fake_log),
+        rt::fake_shared(mock_temporary_suspend_inhibition),
+        rt::fake_shared(fake_filesystem),
+        fake_device_config,
+        repowerd::Fd{uevent_fds[0]}};
+    std::vector<repowerd::HandlerRegistration> registrations;
+
+    std::chrono::seconds const default_timeout{3};
+};
+
+}
+
+TEST_F(ASysfsPowerSource, tracks_existing_batteries)
+{
+    EXPECT_THAT(sysfs_power_source.tracked_batteries(),
+                Eq(std::unordered_set<std::string>{"battery"}));
+}
+
+TEST_F(ASysfsPowerSource, notifies_of_change_from_full_to_discharging)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_change())
+        .WillOnce(WakeUp(&request_processed));
+
+    send_uevent("change", "battery", {"POWER_SUPPLY_STATUS=Discharging"});
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+}
+
+TEST_F(ASysfsPowerSource, notifies_of_change_from_discharging_to_charging)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_change())
+        .WillOnce(Return())
+        .WillOnce(WakeUp(&request_processed));
+
+    send_uevent("change", "battery", {"POWER_SUPPLY_STATUS=Discharging"});
+    send_uevent("change", "battery", {"POWER_SUPPLY_STATUS=Charging"});
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+}
+
+TEST_F(ASysfsPowerSource, notifies_of_level_change_with_reported_values)
+{
+    rt::WaitCondition request_processed;
+    repowerd::BatteryInfo battery_info{};
+
+    EXPECT_CALL(mock_handlers, power_source_level_change(_))
+        .WillOnce(DoAll(SaveArgPointee<0>(&battery_info), WakeUp(&request_processed)));
+
+    send_uevent("change", "battery",
+                {"POWER_SUPPLY_STATUS=Charging", "POWER_SUPPLY_CAPACITY=42"});
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+    EXPECT_THAT(battery_info.percentage, Eq(42.0));
+    EXPECT_THAT(battery_info.state, Eq(1u));
+}
+
+TEST_F(ASysfsPowerSource, reads_attributes_missing_from_uevent_from_sysfs)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_critical())
+        .WillOnce(WakeUp(&request_processed));
+
+    add_attribute("battery", "status", "Discharging");
+    add_attribute("battery", "capacity", "1");
+    send_uevent("change", "battery", {});
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+
+    EXPECT_TRUE(fake_log.contains_line({"critical", "energy", "1.0%"}));
+}
+
+TEST_F(ASysfsPowerSource, does_not_notify_of_critical_state_for_low_battery_energy_when_plugged)
+{
+    EXPECT_CALL(mock_handlers, power_source_critical()).Times(0);
+
+    send_uevent("change", "ac", {"POWER_SUPPLY_ONLINE=1"});
+    send_uevent("change", "battery",
+                {"POWER_SUPPLY_STATUS=Discharging", "POWER_SUPPLY_CAPACITY=1"});
+
+    std::this_thread::sleep_for(100ms);
+}
+
+TEST_F(ASysfsPowerSource, notifies_of_critical_state_for_high_battery_temperature)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_critical())
+        .WillOnce(WakeUp(&request_processed));
+
+    send_uevent("change", "battery",
+                {"POWER_SUPPLY_TEMP=" +
+                 std::to_string(fake_device_config.shutdown_battery_temperature)});
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+
+    EXPECT_TRUE(fake_log.contains_line({"critical", "temperature"}));
+}
+
+TEST_F(ASysfsPowerSource, does_not_notify_of_level_change_for_unchanged_level)
+{
+    EXPECT_CALL(mock_handlers, power_source_level_change(_)).Times(0);
+
+    send_uevent("change", "battery",
+                {"POWER_SUPPLY_STATUS=Full", "POWER_SUPPLY_CAPACITY=100",
+                 "POWER_SUPPLY_TEMP=185", "POWER_SUPPLY_PRESENT=1"});
+
+    std::this_thread::sleep_for(100ms);
+}
+
+TEST_F(ASysfsPowerSource, coalesces_level_changes_within_minimum_interval)
+{
+    std::mutex percentages_mutex;
+    std::vector<double> percentages;
+
+    EXPECT_CALL(mock_handlers, power_source_level_change(_))
+        .WillRepeatedly(Invoke(
+            [&] (repowerd::BatteryInfo* battery_info)
+            {
+                std::lock_guard<std::mutex> lock{percentages_mutex};
+                percentages.push_back(battery_info->percentage);
+            }));
+
+    auto const get_percentages =
+        [&]
+        {
+            std::lock_guard<std::mutex> lock{percentages_mutex};
+            return percentages;
+        };
+
+    add_attribute("battery", "status", "Discharging");
+    send_uevent("change", "battery", {});
+    for (auto capacity : {"99", "98", "97"})
+        send_uevent("change", "battery", {std::string{"POWER_SUPPLY_CAPACITY="} + capacity});
+
+    std::this_thread::sleep_for(100ms);
+    EXPECT_THAT(get_percentages(), ElementsAre(100.0));
+
+    auto const result = rt::spin_wait_for_condition_or_timeout(
+        [&] { return get_percentages().size() == 2; },
+        default_timeout);
+    EXPECT_TRUE(result);
+    EXPECT_THAT(get_percentages(), ElementsAre(100.0, 97.0));
+}
+
+TEST_F(ASysfsPowerSource, inhibits_suspend_temporarily_on_change)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_temporary_suspend_inhibition, inhibit_suspend_for(2000ms, _))
+        .WillOnce(WakeUp(&request_processed));
+
+    send_uevent("change", "battery", {"POWER_SUPPLY_STATUS=Discharging"});
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+}
+
+TEST_F(ASysfsPowerSource, tracks_added_and_removed_batteries)
+{
+    add_battery("battery2");
+    send_uevent("add", "battery2", {});
+
+    wait_for_tracked_batteries({"battery", "battery2"});
+
+    send_uevent("remove", "battery", {});
+
+    wait_for_tracked_batteries({"battery2"});
+}
+
+TEST_F(ASysfsPowerSource, ignores_uevents_from_other_subsystems)
+{
+    EXPECT_CALL(mock_handlers, power_source_change()).Times(0);
+
+    std::string uevent{"change@/devices/virtual/input/input1"};
+    uevent.push_back('\0');
+    for (auto const str : {"ACTION=change", "SUBSYSTEM=input", "POWER_SUPPLY_NAME=battery",
+                           "POWER_SUPPLY_STATUS=Discharging"})
+    {
+        uevent.append(str);
+        uevent.push_back('\0');
+    }
+    send(uevent_fds[1], uevent.data(), uevent.size(), 0);
+
+    std::this_thread::sleep_for(100ms);
+}
@@ -46,7 +46,7 @@ struct AUbuntuLightSensor : testing::Test
         rt::TemporaryEnvironmentValue test_file{"UBUNTU_PLATFORM_API_SENSOR_TEST", command_file.name().c_str()};
         command_file.write(script);
 
-        sensor = std::make_unique<repowerd::UbuntuLightSensor>();
+        sensor = std::make_unique<repowerd::UbuntuLightSensor>(nullptr);
         registration = sensor->register_light_handler(
             [this](double light) { mock_handlers.light_handler(light); });
     }
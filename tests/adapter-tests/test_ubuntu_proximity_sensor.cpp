@@ -19,6 +19,7 @@
 #include "src/adapters/ubuntu_proximity_sensor.h"
 #include "src/adapters/device_quirks.h"
 
+#include "fake_device_config.h"
 #include "fake_device_quirks.h"
 #include "fake_log.h"
 #include "fake_shared.h"
@@ -48,7 +49,7 @@ struct AUbuntuProximitySensor : testing::Test
         command_file.write(script);
 
         sensor = std::make_unique<repowerd::UbuntuProximitySensor>(
-            rt::fake_shared(fake_log), fake_device_quirks);
+            nullptr, rt::fake_shared(fake_log), fake_device_quirks, fake_device_config);
         registration = sensor->register_proximity_handler(
             [this](repowerd::ProximityState state) { mock_handlers.proximity_handler(state); });
     }
@@ -61,6 +62,7 @@ struct AUbuntuProximitySensor : testing::Test
 
     rt::FakeLog fake_log;
     rt::FakeDeviceQuirks fake_device_quirks;
+    rt::FakeDeviceConfig fake_device_config;
     std::unique_ptr<repowerd::UbuntuProximitySensor> sensor;
     repowerd::HandlerRegistration registration;
 
@@ -243,3 +245,112 @@ TEST_F(AUbuntuProximitySensor, ignores_stray_proximity_events_when_disabled)
         std::this_thread::sleep_for(std::chrono::milliseconds{1100});
     });
 }
+
+TEST_F(AUbuntuProximitySensor, reports_cached_state_within_cache_window)
+{
+    TEST_IN_SEPARATE_PROCESS({
+        fake_device_config.set("proximityStateCacheMs", "10000");
+
+        set_up_sensor(
+            "create proximity\n"
+            "500 proximity near\n");
+
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::near));
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::near));
+
+        EXPECT_TRUE(fake_log.contains_line({"proximity_state", "near", "cached"}));
+
+        auto const stats = sensor->state_cache_stats();
+        EXPECT_THAT(stats.hits, Eq(1u));
+        EXPECT_THAT(stats.misses, Eq(1u));
+        EXPECT_THAT(stats.hit_latency, Lt(stats.miss_latency));
+    });
+}
+
+TEST_F(AUbuntuProximitySensor, logs_state_cache_stats_when_destroyed)
+{
+    TEST_IN_SEPARATE_PROCESS({
+        fake_device_config.set("proximityStateCacheMs", "10000");
+
+        set_up_sensor(
+            "create proximity\n"
+            "500 proximity near\n");
+
+        sensor->proximity_state();
+        sensor->proximity_state();
+        sensor->proximity_state();
+
+        registration = repowerd::HandlerRegistration{};
+        sensor.reset();
+
+        EXPECT_TRUE(fake_log.contains_line({"cache hits: 2 ", "cache misses: 1 "}));
+    });
+}
+
+TEST_F(AUbuntuProximitySensor, does_not_cache_state_by_default)
+{
+    TEST_IN_SEPARATE_PROCESS({
+        set_up_sensor(
+            "create proximity\n");
+
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::far));
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::far));
+
+        EXPECT_FALSE(fake_log.contains_line({"proximity_state", "cached"}));
+        EXPECT_THAT(sensor->state_cache_stats().hits, Eq(0u));
+        EXPECT_THAT(sensor->state_cache_stats().misses, Eq(2u));
+    });
+}
+
+TEST_F(AUbuntuProximitySensor, queries_sensor_again_after_cache_window)
+{
+    TEST_IN_SEPARATE_PROCESS({
+        fake_device_config.set("proximityStateCacheMs", "100");
+
+        set_up_sensor(
+            "create proximity\n");
+
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::far));
+        std::this_thread::sleep_for(std::chrono::milliseconds{200});
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::far));
+
+        EXPECT_FALSE(fake_log.contains_line({"proximity_state", "cached"}));
+        EXPECT_THAT(sensor->state_cache_stats().misses, Eq(2u));
+    });
+}
+
+TEST_F(AUbuntuProximitySensor, reports_current_state_without_querying_sensor_while_enabled)
+{
+    TEST_IN_SEPARATE_PROCESS({
+        fake_device_config.set("proximityStateCacheMs", "0");
+
+        set_up_sensor(
+            "create proximity\n"
+            "500 proximity near\n");
+        sensor->enable_proximity_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{750});
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::near));
+
+        EXPECT_TRUE(fake_log.contains_line({"proximity_state", "near", "cached"}));
+        EXPECT_THAT(sensor->state_cache_stats().hits, Eq(1u));
+    });
+}
+
+TEST_F(AUbuntuProximitySensor, refreshes_aging_cached_state_in_background)
+{
+    TEST_IN_SEPARATE_PROCESS({
+        fake_device_config.set("proximityStateCacheMs", "1000");
+
+        set_up_sensor(
+            "create proximity\n");
+
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::far));
+        std::this_thread::sleep_for(std::chrono::milliseconds{600});
+        EXPECT_THAT(sensor->proximity_state(), Eq(repowerd::ProximityState::far));
+
+        EXPECT_TRUE(fake_log.contains_line({"refresh_state_in_background"}));
+        EXPECT_THAT(sensor->state_cache_stats().hits, Eq(1u));
+    });
+}
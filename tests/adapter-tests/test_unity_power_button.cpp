@@ -96,7 +96,7 @@ struct AUnityPowerButton : testing::Test
     testing::NiceMock<MockHandlers> mock_handlers;
 
     rt::DBusBus bus;
-    repowerd::UnityPowerButton unity_power_button{bus.address()};
+    repowerd::UnityPowerButton unity_power_button{nullptr, bus.address()};
     UnityPowerButtonDBusClient client{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
 
@@ -28,6 +28,7 @@
 #include "src/adapters/temporary_suspend_inhibition.h"
 #include "src/adapters/unity_screen_power_state_change_reason.h"
 #include "src/adapters/unity_screen_service.h"
+#include "src/core/event_stats.h"
 #include "src/core/infinite_timeout.h"
 
 #include "fake_shared.h"
@@ -109,14 +110,17 @@ struct AUnityScreenService : testing::Test
 
     rt::DBusBus bus;
     rt::FakeBrightnessNotification fake_brightness_notification;
+    repowerd::EventStats event_stats;
     rt::FakeDeviceConfig fake_device_config;
     rt::FakeLog fake_log;
     rt::FakeSuspendControl fake_suspend_control;
     rt::FakeWakeupService fake_wakeup_service;
     NullTemporarySuspendInhibition null_temporary_suspend_inhibition;
     repowerd::UnityScreenService service{
+        nullptr,
         rt::fake_shared(fake_wakeup_service),
         rt::fake_shared(fake_brightness_notification),
+        rt::fake_shared(event_stats),
         rt::fake_shared(fake_log),
         rt::fake_shared(fake_suspend_control),
         rt::fake_shared(null_temporary_suspend_inhibition),
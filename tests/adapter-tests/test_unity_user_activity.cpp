@@ -76,7 +76,7 @@ struct AUnityUserActivity : testing::Test
     testing::NiceMock<MockHandlers> mock_handlers;
 
     rt::DBusBus bus;
-    repowerd::UnityUserActivity unity_user_activity{bus.address()};
+    repowerd::UnityUserActivity unity_user_activity{nullptr, bus.address()};
     UnityUserActivityDBusClient client{bus.address()};
     std::vector<repowerd::HandlerRegistration> registrations;
 
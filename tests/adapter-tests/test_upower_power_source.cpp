@@ -32,6 +32,8 @@
 #include <gmock/gmock.h>
 
 #include <chrono>
+#include <mutex>
+#include <vector>
 
 namespace rt = repowerd::test;
 using namespace testing;
@@ -103,6 +105,7 @@ struct AUPowerPowerSource : testing::Test
     rt::FakeLog fake_log;
     NiceMock<MockTemporarySuspendInhibition> mock_temporary_suspend_inhibition;
     repowerd::UPowerPowerSource upower_power_source{
+        nullptr,
         rt::fake_shared(fake_log),
         rt::fake_shared(mock_temporary_suspend_inhibition),
         fake_device_config,
@@ -344,3 +347,95 @@ TEST_F(AUPowerPowerSource, inhibits_suspend_temporarily_on_critical_state)
     request_processed.wait_for(default_timeout);
     EXPECT_TRUE(request_processed.woken());
 }
+
+TEST_F(AUPowerPowerSource, notifies_of_change_for_invalidated_battery_state)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_change())
+        .WillOnce(WakeUp(&request_processed));
+
+    fake_upower.invalidate_device(device_path(1), discharging_battery);
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+}
+
+TEST_F(AUPowerPowerSource, notifies_of_critical_state_for_invalidated_battery_temperature)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_critical())
+        .WillOnce(WakeUp(&request_processed));
+
+    auto exploding_battery = full_battery;
+    // shutdown_battery_temperature is in celcius * 10
+    exploding_battery.temperature = fake_device_config.shutdown_battery_temperature * 0.1;
+    fake_upower.invalidate_device(device_path(1), exploding_battery);
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+}
+
+TEST_F(AUPowerPowerSource, notifies_of_level_change_immediately_on_state_change)
+{
+    rt::WaitCondition request_processed;
+
+    EXPECT_CALL(mock_handlers, power_source_level_change(_))
+        .WillOnce(WakeUp(&request_processed));
+
+    fake_upower.change_device(device_path(1), discharging_battery);
+
+    request_processed.wait_for(default_timeout);
+    EXPECT_TRUE(request_processed.woken());
+}
+
+TEST_F(AUPowerPowerSource, coalesces_level_changes_within_minimum_interval)
+{
+    std::mutex percentages_mutex;
+    std::vector<double> percentages;
+
+    EXPECT_CALL(mock_handlers, power_source_level_change(_))
+        .WillRepeatedly(Invoke(
+            [&] (repowerd::BatteryInfo* battery_info)
+            {
+                std::lock_guard<std::mutex> lock{percentages_mutex};
+                percentages.push_back(battery_info->percentage);
+            }));
+
+    auto const get_percentages =
+        [&]
+        {
+            std::lock_guard<std::mutex> lock{percentages_mutex};
+            return percentages;
+        };
+
+    auto battery = discharging_battery;
+    fake_upower.change_device(device_path(1), battery);
+    for (auto percentage : {99.0, 98.0, 97.0})
+    {
+        battery.percentage = percentage;
+        fake_upower.change_device(device_path(1), battery);
+    }
+
+    std::this_thread::sleep_for(100ms);
+    EXPECT_THAT(get_percentages(), ElementsAre(100.0));
+
+    auto const result = rt::spin_wait_for_condition_or_timeout(
+        [&] { return get_percentages().size() == 2; },
+        default_timeout);
+    EXPECT_TRUE(result);
+    EXPECT_THAT(get_percentages(), ElementsAre(100.0, 97.0));
+}
+
+TEST_F(AUPowerPowerSource, does_not_notify_of_level_change_for_temperature_jitter)
+{
+    EXPECT_CALL(mock_handlers, power_source_level_change(_)).Times(0);
+
+    auto battery = full_battery;
+    battery.temperature += 0.5;
+    fake_upower.change_device(device_path(1), battery);
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds{fake_device_config.battery_level_change_min_interval_ms} + 100ms);
+}
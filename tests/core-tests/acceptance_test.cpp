@@ -74,7 +74,7 @@ rt::AcceptanceTest::~AcceptanceTest()
 void rt::AcceptanceTest::expect_display_turns_off()
 {
     EXPECT_CALL(*config.the_mock_display_power_control(), turn_off());
-    EXPECT_CALL(*config.the_mock_brightness_control(), set_off_brightness());
+    EXPECT_CALL(*config.the_mock_brightness_control(), set_off_brightness(testing::_));
 }
 
 void rt::AcceptanceTest::expect_display_turns_on()
@@ -102,7 +102,7 @@ void rt::AcceptanceTest::expect_no_display_brightness_change()
 {
     EXPECT_CALL(*config.the_mock_brightness_control(), set_dim_brightness()).Times(0);
     EXPECT_CALL(*config.the_mock_brightness_control(), set_normal_brightness()).Times(0);
-    EXPECT_CALL(*config.the_mock_brightness_control(), set_off_brightness()).Times(0);
+    EXPECT_CALL(*config.the_mock_brightness_control(), set_off_brightness(testing::_)).Times(0);
 }
 
 void rt::AcceptanceTest::expect_no_display_power_change()
@@ -273,7 +273,7 @@ void rt::AcceptanceTest::set_proximity_state_near()
 void rt::AcceptanceTest::turn_off_display()
 {
     EXPECT_CALL(*config.the_mock_display_power_control(), turn_off());
-    EXPECT_CALL(*config.the_mock_brightness_control(), set_off_brightness());
+    EXPECT_CALL(*config.the_mock_brightness_control(), set_off_brightness(testing::_));
     press_power_button();
     release_power_button();
     daemon.flush();
@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "daemon_config.h"
+#include "fake_timer.h"
+
+#include "src/core/state_machine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace rt = repowerd::test;
+
+using namespace std::chrono_literals;
+
+// Feeds a steady stream of user activity to the state machine, and reports
+// how many timer operations it performs compared to cancelling and
+// rescheduling both inactivity alarms on every event
+int main(int argc, char** argv)
+{
+    int const events_per_minute = argc > 1 ? atoi(argv[1]) : 10000;
+    int const minutes = argc > 2 ? atoi(argv[2]) : 10;
+
+    rt::DaemonConfig config;
+    auto const timer = config.the_fake_timer();
+    auto const state_machine = config.the_state_machine();
+
+    std::vector<repowerd::AlarmId> fired_alarms;
+    auto const registration = timer->register_alarm_handler(
+        [&](repowerd::AlarmId id) { fired_alarms.push_back(id); });
+
+    state_machine->handle_user_activity_changing_power_state();
+
+    auto const interval = std::chrono::milliseconds{60000 / events_per_minute};
+    int const num_events = events_per_minute * minutes;
+    auto const timer_operations_before = timer->num_timer_operations();
+
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < num_events; ++i)
+    {
+        state_machine->handle_user_activity_extending_power_state();
+        timer->advance_by(interval);
+
+        for (auto const id : fired_alarms)
+            state_machine->handle_alarm(id);
+        fired_alarms.clear();
+    }
+
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    auto const timer_operations = timer->num_timer_operations() - timer_operations_before;
+    auto const eager_timer_operations = 4 * num_events;
+
+    std::cout << num_events << " user activity events over " << minutes << " minutes" << std::endl
+              << "timer operations: " << timer_operations
+              << " (eager rescheduling: " << eager_timer_operations << ", saved "
+              << eager_timer_operations - timer_operations << ")" << std::endl
+              << "state machine time per event: "
+              << std::chrono::duration<double,std::nano>(elapsed).count() / num_events
+              << "ns" << std::endl;
+}
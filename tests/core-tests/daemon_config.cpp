@@ -18,12 +18,15 @@
 
 #include "daemon_config.h"
 #include "src/core/default_state_machine.h"
+#include "src/core/event_journal.h"
+#include "src/core/event_stats.h"
 
 #include "mock_brightness_control.h"
 #include "fake_client_requests.h"
 #include "mock_display_power_control.h"
 #include "mock_display_power_event_sink.h"
 #include "fake_log.h"
+#include "mock_light_control.h"
 #include "mock_modem_power_control.h"
 #include "fake_notification_service.h"
 #include "mock_performance_booster.h"
@@ -61,6 +64,25 @@ std::shared_ptr<repowerd::DisplayPowerEventSink> rt::DaemonConfig::the_display_p
     return the_mock_display_power_event_sink();
 }
 
+std::shared_ptr<repowerd::EventJournal> rt::DaemonConfig::the_event_journal()
+{
+    struct NullEventJournal : EventJournal
+    {
+        void record(DaemonEvent const&) override {}
+    };
+
+    if (!event_journal)
+        event_journal = std::make_shared<NullEventJournal>();
+    return event_journal;
+}
+
+std::shared_ptr<repowerd::EventStats> rt::DaemonConfig::the_event_stats()
+{
+    if (!event_stats)
+        event_stats = std::make_shared<EventStats>();
+    return event_stats;
+}
+
 std::shared_ptr<repowerd::Log> rt::DaemonConfig::the_log()
 {
     return the_fake_log();
@@ -73,7 +95,7 @@ std::shared_ptr<repowerd::ModemPowerControl> rt::DaemonConfig::the_modem_power_c
 
 std::shared_ptr<repowerd::LightControl> rt::DaemonConfig::the_light_control()
 {
-    return NULL; // ToDo the_fake_light_control();
+    return the_mock_light_control();
 }
 
 std::shared_ptr<repowerd::NotificationService> rt::DaemonConfig::the_notification_service()
@@ -179,6 +201,12 @@ bool rt::DaemonConfig::turn_on_display_at_startup()
     return false;
 }
 
+void rt::DaemonConfig::run_event_processing_startup(
+    std::function<void()> const& start_event_processing)
+{
+    start_event_processing();
+}
+
 std::shared_ptr<NiceMock<rt::MockBrightnessControl>>
 rt::DaemonConfig::the_mock_brightness_control()
 {
@@ -231,6 +259,15 @@ rt::DaemonConfig::the_mock_modem_power_control()
     return mock_modem_power_control;
 }
 
+std::shared_ptr<NiceMock<rt::MockLightControl>>
+rt::DaemonConfig::the_mock_light_control()
+{
+    if (!mock_light_control)
+        mock_light_control = std::make_shared<NiceMock<rt::MockLightControl>>();
+
+    return mock_light_control;
+}
+
 std::shared_ptr<rt::FakeNotificationService> rt::DaemonConfig::the_fake_notification_service()
 {
     if (!fake_notification_service)
@@ -32,6 +32,7 @@ class FakeClientRequests;
 class MockDisplayPowerControl;
 class MockDisplayPowerEventSink;
 class FakeLog;
+class MockLightControl;
 class MockModemPowerControl;
 class FakeNotificationService;
 class MockPerformanceBooster;
@@ -52,6 +53,8 @@ public:
     std::shared_ptr<ClientRequests> the_client_requests() override;
     std::shared_ptr<DisplayPowerControl> the_display_power_control() override;
     std::shared_ptr<DisplayPowerEventSink> the_display_power_event_sink() override;
+    std::shared_ptr<EventJournal> the_event_journal() override;
+    std::shared_ptr<EventStats> the_event_stats() override;
     std::shared_ptr<Log> the_log() override;
     std::shared_ptr<ModemPowerControl> the_modem_power_control() override;
     std::shared_ptr<LightControl> the_light_control() override;
@@ -76,6 +79,8 @@ public:
     std::chrono::milliseconds user_inactivity_reduced_display_off_timeout() override;
 
     bool turn_on_display_at_startup() override;
+    void run_event_processing_startup(
+        std::function<void()> const& start_event_processing) override;
 
     std::shared_ptr<testing::NiceMock<MockBrightnessControl>> the_mock_brightness_control();
     std::shared_ptr<FakeClientRequests> the_fake_client_requests();
@@ -83,6 +88,7 @@ public:
     std::shared_ptr<testing::NiceMock<MockDisplayPowerEventSink>> the_mock_display_power_event_sink();
     std::shared_ptr<FakeLog> the_fake_log();
     std::shared_ptr<testing::NiceMock<MockModemPowerControl>> the_mock_modem_power_control();
+    std::shared_ptr<testing::NiceMock<MockLightControl>> the_mock_light_control();
     std::shared_ptr<FakeNotificationService> the_fake_notification_service();
     std::shared_ptr<testing::NiceMock<MockPerformanceBooster>> the_mock_performance_booster();
     std::shared_ptr<FakePowerButton> the_fake_power_button();
@@ -97,6 +103,8 @@ public:
 
 private:
     std::shared_ptr<StateMachine> state_machine;
+    std::shared_ptr<EventJournal> event_journal;
+    std::shared_ptr<EventStats> event_stats;
 
     std::shared_ptr<testing::NiceMock<MockBrightnessControl>> mock_brightness_control;
     std::shared_ptr<FakeClientRequests> fake_client_requests;
@@ -104,6 +112,7 @@ private:
     std::shared_ptr<testing::NiceMock<MockDisplayPowerEventSink>> mock_display_power_event_sink;
     std::shared_ptr<FakeLog> fake_log;
     std::shared_ptr<testing::NiceMock<MockModemPowerControl>> mock_modem_power_control;
+    std::shared_ptr<testing::NiceMock<MockLightControl>> mock_light_control;
     std::shared_ptr<FakeNotificationService> fake_notification_service;
     std::shared_ptr<testing::NiceMock<MockPerformanceBooster>> mock_performance_booster;
     std::shared_ptr<FakePowerButton> fake_power_button;
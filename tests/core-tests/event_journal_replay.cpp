@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "event_journal_replay.h"
+#include "daemon_config.h"
+#include "fake_timer.h"
+
+namespace rt = repowerd::test;
+
+rt::EventJournalReplay::EventJournalReplay(DaemonConfig& config)
+    : config{config},
+      dispatcher{config.the_state_machine(), config.the_brightness_control()},
+      alarm_handler_registration{
+          config.the_fake_timer()->register_alarm_handler(
+              [this] (AlarmId id) { fired_alarms.push_back(id); })},
+      has_start_time{false},
+      start_time_ns{0},
+      num_dispatched{0}
+{
+}
+
+void rt::EventJournalReplay::replay(std::vector<DaemonEvent> const& events)
+{
+    for (auto const& event : events)
+    {
+        if (event.type == DaemonEvent::Type::alarm)
+            continue;
+
+        if (!has_start_time)
+        {
+            start_time_ns = event.enqueue_time_ns;
+            has_start_time = true;
+        }
+
+        advance_time_to(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::nanoseconds{event.enqueue_time_ns - start_time_ns}));
+
+        dispatcher.dispatch(event);
+        ++num_dispatched;
+    }
+}
+
+size_t rt::EventJournalReplay::num_dispatched_events() const
+{
+    return num_dispatched;
+}
+
+void rt::EventJournalReplay::advance_time_to(std::chrono::milliseconds time)
+{
+    auto const timer = config.the_fake_timer();
+    auto const now = [&] { return timer->now().time_since_epoch(); };
+
+    // Step from alarm to alarm, so that alarms scheduled while handling an
+    // alarm are timed relative to when the handled alarm actually fired
+    while (now() < time)
+    {
+        auto const step_end = std::min(timer->next_alarm_time(), time);
+
+        timer->advance_by(
+            std::chrono::duration_cast<std::chrono::milliseconds>(step_end - now()));
+
+        auto alarms = std::move(fired_alarms);
+        fired_alarms.clear();
+
+        for (auto const id : alarms)
+        {
+            dispatcher.dispatch(DaemonEvent::alarm(id));
+            ++num_dispatched;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "src/core/daemon_event.h"
+#include "src/core/daemon_event_dispatcher.h"
+#include "src/core/handler_registration.h"
+
+#include <chrono>
+#include <vector>
+
+namespace repowerd
+{
+namespace test
+{
+
+class DaemonConfig;
+
+// Feeds recorded daemon events synchronously into the state machine of a
+// test DaemonConfig, advancing its FakeTimer by the recorded time between
+// events. Recorded alarms are skipped, since the alarms that the replayed
+// state machine schedules itself are fired by the FakeTimer at the right
+// points in the replayed timeline.
+class EventJournalReplay
+{
+public:
+    EventJournalReplay(DaemonConfig& config);
+
+    void replay(std::vector<DaemonEvent> const& events);
+
+    size_t num_dispatched_events() const;
+
+private:
+    void advance_time_to(std::chrono::milliseconds time);
+
+    DaemonConfig& config;
+    DaemonEventDispatcher dispatcher;
+    std::vector<AlarmId> fired_alarms;
+    HandlerRegistration const alarm_handler_registration;
+    bool has_start_time;
+    int64_t start_time_ns;
+    size_t num_dispatched;
+};
+
+}
+}
@@ -25,7 +25,8 @@ namespace rt = repowerd::test;
 rt::FakeTimer::FakeTimer()
     : handler{[](AlarmId){}},
       next_alarm_id{1},
-      now_ms{0}
+      now_ms{0},
+      timer_operations{0}
 {
 }
 
@@ -41,8 +42,10 @@ repowerd::HandlerRegistration rt::FakeTimer::register_alarm_handler(AlarmHandler
         }};
 }
 
-repowerd::AlarmId rt::FakeTimer::schedule_alarm_in(std::chrono::milliseconds t)
+repowerd::AlarmId rt::FakeTimer::schedule_alarm_in(
+    std::chrono::milliseconds t, std::chrono::milliseconds /*slack*/)
 {
+    ++timer_operations;
     alarms.push_back({next_alarm_id, now_ms + t});
 
     return next_alarm_id++;
@@ -50,6 +53,7 @@ repowerd::AlarmId rt::FakeTimer::schedule_alarm_in(std::chrono::milliseconds t)
 
 void rt::FakeTimer::cancel_alarm(AlarmId id)
 {
+    ++timer_operations;
     alarms.erase(
         std::remove_if(
             alarms.begin(),
@@ -80,3 +84,18 @@ void rt::FakeTimer::advance_by(std::chrono::milliseconds advance)
             [this](auto const& alarm) { return now_ms >= alarm.time; }),
         alarms.end());
 }
+
+std::chrono::milliseconds rt::FakeTimer::next_alarm_time() const
+{
+    auto next = std::chrono::milliseconds::max();
+
+    for (auto const& alarm : alarms)
+        next = std::min(next, alarm.time);
+
+    return next;
+}
+
+int rt::FakeTimer::num_timer_operations() const
+{
+    return timer_operations;
+}
@@ -35,11 +35,18 @@ public:
     FakeTimer();
 
     HandlerRegistration register_alarm_handler(AlarmHandler const& handler) override;
-    AlarmId schedule_alarm_in(std::chrono::milliseconds t) override;
+    using Timer::schedule_alarm_in;
+    // Alarms always fire exactly after t, ignoring their slack
+    AlarmId schedule_alarm_in(
+        std::chrono::milliseconds t, std::chrono::milliseconds slack) override;
     void cancel_alarm(AlarmId id) override;
     std::chrono::steady_clock::time_point now() override;
 
     void advance_by(std::chrono::milliseconds advance);
+    // Time of the earliest pending alarm, or milliseconds::max() if none
+    std::chrono::milliseconds next_alarm_time() const;
+    // Number of schedule_alarm_in() and cancel_alarm() calls so far
+    int num_timer_operations() const;
 
     struct Mock
     {
@@ -59,6 +66,7 @@ private:
     AlarmId next_alarm_id;
     std::chrono::milliseconds now_ms;
     std::vector<Alarm> alarms;
+    int timer_operations;
 };
 
 }
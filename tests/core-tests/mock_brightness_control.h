@@ -30,12 +30,19 @@ namespace test
 class MockBrightnessControl : public BrightnessControl
 {
 public:
+    MockBrightnessControl()
+    {
+        // Brightness reaches off right away
+        ON_CALL(*this, set_off_brightness(testing::_))
+            .WillByDefault(testing::InvokeArgument<0>());
+    }
+
     MOCK_METHOD0(disable_autobrightness, void());
     MOCK_METHOD0(enable_autobrightness, void());
     MOCK_METHOD0(set_dim_brightness, void());
     MOCK_METHOD0(set_normal_brightness, void());
     MOCK_METHOD1(set_normal_brightness_value, void(double));
-    MOCK_METHOD0(set_off_brightness, void());
+    MOCK_METHOD1(set_off_brightness, void(std::function<void()> const&));
 };
 
 }
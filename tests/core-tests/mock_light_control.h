@@ -0,0 +1,47 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#pragma once
+
+#include "src/core/light_control.h"
+
+#include <gmock/gmock.h>
+
+namespace repowerd
+{
+namespace test
+{
+
+class MockLightControl : public LightControl
+{
+public:
+    MOCK_METHOD1(setState, void(State));
+    MOCK_METHOD0(state, State());
+    MOCK_METHOD3(setColor, void(uint, uint, uint));
+    MOCK_METHOD0(onMillisec, int());
+    MOCK_METHOD1(setOnMillisec, void(int));
+    MOCK_METHOD0(offMillisec, int());
+    MOCK_METHOD1(setOffMillisec, void(int));
+
+    MOCK_METHOD0(start_processing, void());
+    MOCK_METHOD1(notify_battery_info, void(BatteryInfo*));
+    MOCK_METHOD1(notify_display_state, void(DisplayState));
+};
+
+}
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "daemon_config.h"
+#include "event_journal_replay.h"
+
+#include "src/core/file_event_journal.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace rt = repowerd::test;
+
+int main(int argc, char** argv)
+try
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <journal>..." << std::endl;
+        return -1;
+    }
+
+    for (int i = 1; i < argc; ++i)
+    {
+        auto const events = repowerd::FileEventJournal::read_events(argv[i]);
+
+        rt::DaemonConfig config;
+        rt::EventJournalReplay replay{config};
+
+        auto const start = std::chrono::steady_clock::now();
+        replay.replay(events);
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+
+        auto const elapsed_s = std::chrono::duration<double>{elapsed}.count();
+        auto const elapsed_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+
+        std::cout << argv[i] << ": "
+                  << events.size() << " recorded events, "
+                  << replay.num_dispatched_events() << " dispatched in "
+                  << elapsed_ms << "ms ("
+                  << static_cast<uint64_t>(replay.num_dispatched_events() / elapsed_s)
+                  << " events/s)" << std::endl;
+    }
+}
+catch (std::exception const& e)
+{
+    std::cerr << e.what() << std::endl;
+    return -1;
+}
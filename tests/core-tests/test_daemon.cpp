@@ -16,6 +16,7 @@
  * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
  */
 
+#include "allocation_counter.h"
 #include "daemon_config.h"
 #include "fake_client_requests.h"
 #include "fake_notification_service.h"
@@ -26,10 +27,14 @@
 #include "fake_user_activity.h"
 #include "fake_voice_call_service.h"
 #include "mock_brightness_control.h"
+#include "wait_condition.h"
 
 #include "src/core/daemon.h"
+#include "src/core/event_stats.h"
 #include "src/core/state_machine.h"
 
+#include <atomic>
+#include <numeric>
 #include <thread>
 
 #include <gmock/gmock.h>
@@ -88,6 +93,19 @@ struct DaemonConfigWithMockStateMachine : rt::DaemonConfig
     std::shared_ptr<MockStateMachine> mock_state_machine;
 };
 
+struct DaemonConfigWithEventProcessingStartup : DaemonConfigWithMockStateMachine
+{
+    void run_event_processing_startup(
+        std::function<void()> const& start_event_processing) override
+    {
+        in_event_processing_startup = true;
+        start_event_processing();
+        in_event_processing_startup = false;
+    }
+
+    bool in_event_processing_startup{false};
+};
+
 struct ADaemon : testing::Test
 {
     DaemonConfigWithMockStateMachine config;
@@ -555,3 +573,118 @@ TEST_F(ADaemon, notifies_state_machine_of_power_source_critical)
 
     config.the_fake_power_source()->emit_power_source_critical();
 }
+
+TEST_F(ADaemon, coalesces_pending_user_activity_extending_power_state_events)
+{
+    using namespace testing;
+
+    rt::WaitCondition handler_blocked;
+    rt::WaitCondition unblock_handler;
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_power_button_press())
+        .WillOnce(DoAll(WakeUp(&handler_blocked), WaitFor(&unblock_handler, 5s)));
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_user_activity_extending_power_state())
+        .Times(1);
+
+    start_daemon();
+
+    config.the_fake_power_button()->press();
+    handler_blocked.wait_for(5s);
+
+    for (int i = 0; i < 5; ++i)
+        config.the_fake_user_activity()->perform(repowerd::UserActivityType::extend_power_state);
+
+    unblock_handler.wake_up();
+    daemon->flush();
+
+    EXPECT_THAT(
+        daemon->num_coalesced_events(
+            repowerd::DaemonEvent::Type::user_activity_extending_power_state),
+        Eq(4u));
+}
+
+TEST_F(ADaemon, does_not_allocate_when_delivering_events_to_state_machine)
+{
+    struct CountingStateMachine : MockStateMachine
+    {
+        void handle_power_button_press() override { ++handled; }
+        void handle_power_button_release() override { ++handled; }
+        void handle_user_activity_extending_power_state() override { ++handled; }
+        std::atomic<int> handled{0};
+    };
+
+    struct DaemonConfigWithCountingStateMachine : rt::DaemonConfig
+    {
+        std::shared_ptr<repowerd::StateMachine> the_state_machine() override
+        {
+            return counting_state_machine;
+        }
+
+        std::shared_ptr<CountingStateMachine> const counting_state_machine{
+            std::make_shared<CountingStateMachine>()};
+    };
+
+    DaemonConfigWithCountingStateMachine config_with_counting_state_machine;
+    start_daemon_with_config(config_with_counting_state_machine);
+
+    auto const& counting_state_machine =
+        *config_with_counting_state_machine.counting_state_machine;
+    auto const& power_button = config_with_counting_state_machine.the_fake_power_button();
+    auto const& user_activity = config_with_counting_state_machine.the_fake_user_activity();
+    int const num_iterations = 1000;
+
+    rt::start_counting_allocations();
+
+    for (int i = 0; i < num_iterations; ++i)
+    {
+        power_button->press();
+        user_activity->perform(repowerd::UserActivityType::extend_power_state);
+        power_button->release();
+
+        while (counting_state_machine.handled != 3 * (i + 1))
+            std::this_thread::yield();
+    }
+
+    EXPECT_THAT(rt::stop_counting_allocations(), testing::Eq(0));
+}
+
+TEST_F(ADaemon, records_queue_latency_and_handling_time_of_events)
+{
+    using namespace testing;
+
+    start_daemon();
+
+    EXPECT_CALL(*config.the_mock_state_machine(), handle_proximity_far())
+        .WillOnce(Invoke([] { std::this_thread::sleep_for(2ms); }));
+
+    config.the_fake_proximity_sensor()->emit_proximity_state(
+        repowerd::ProximityState::far);
+    daemon->flush();
+
+    auto const queue_latency = config.the_event_stats()->queue_latency_histogram(
+        repowerd::DaemonEvent::Type::proximity_far);
+    auto const handling_time = config.the_event_stats()->handling_time_histogram(
+        repowerd::DaemonEvent::Type::proximity_far);
+    auto const min_handling_time_bucket = repowerd::EventStats::bucket_for(2ms);
+
+    EXPECT_THAT(std::accumulate(queue_latency.begin(), queue_latency.end(), uint64_t{0}), Eq(1u));
+    EXPECT_THAT(std::accumulate(handling_time.begin(), handling_time.end(), uint64_t{0}), Eq(1u));
+    EXPECT_THAT(
+        std::accumulate(handling_time.begin() + min_handling_time_bucket, handling_time.end(), uint64_t{0}),
+        Eq(1u));
+}
+
+TEST_F(ADaemon, starts_event_processing_through_config)
+{
+    using namespace testing;
+
+    DaemonConfigWithEventProcessingStartup config;
+
+    EXPECT_CALL(config.the_fake_power_button()->mock, start_processing())
+        .WillOnce(Invoke([&] { EXPECT_TRUE(config.in_event_processing_startup); }));
+    EXPECT_CALL(config.the_fake_user_activity()->mock, start_processing())
+        .WillOnce(Invoke([&] { EXPECT_TRUE(config.in_event_processing_startup); }));
+
+    start_daemon_with_config(config);
+    stop_daemon();
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "daemon_config.h"
+#include "event_journal_replay.h"
+#include "fake_proximity_sensor.h"
+#include "mock_brightness_control.h"
+#include "mock_display_power_control.h"
+#include "temporary_file.h"
+
+#include "src/core/daemon.h"
+#include "src/core/file_event_journal.h"
+
+#include <fstream>
+#include <thread>
+
+#include <gmock/gmock.h>
+
+namespace rt = repowerd::test;
+
+using namespace std::chrono_literals;
+using namespace testing;
+using EventType = repowerd::DaemonEvent::Type;
+
+namespace
+{
+
+repowerd::DaemonEvent at_time(repowerd::DaemonEvent event, std::chrono::nanoseconds t)
+{
+    event.enqueue_time_ns = t.count();
+    return event;
+}
+
+std::vector<EventType> types_of(std::vector<repowerd::DaemonEvent> const& events)
+{
+    std::vector<EventType> types;
+    for (auto const& event : events)
+        types.push_back(event.type);
+    return types;
+}
+
+struct AFileEventJournal : testing::Test
+{
+    rt::TemporaryFile journal_file;
+
+    void truncate_journal_file_by(size_t n)
+    {
+        std::ifstream in{journal_file.name(), std::ios::binary};
+        std::string data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        std::ofstream out{journal_file.name(), std::ios::binary | std::ios::trunc};
+        out << data.substr(0, data.size() - n);
+    }
+};
+
+struct DaemonConfigWithFileEventJournal : rt::DaemonConfig
+{
+    DaemonConfigWithFileEventJournal(std::string const& path)
+        : file_event_journal{std::make_shared<repowerd::FileEventJournal>(path)}
+    {
+    }
+
+    std::shared_ptr<repowerd::EventJournal> the_event_journal() override
+    {
+        return file_event_journal;
+    }
+
+    std::shared_ptr<repowerd::FileEventJournal> const file_event_journal;
+};
+
+struct AnEventJournalReplay : testing::Test
+{
+    rt::DaemonConfig config;
+    rt::EventJournalReplay replay{config};
+};
+
+}
+
+TEST_F(AFileEventJournal, reads_back_recorded_events_with_payloads)
+{
+    repowerd::BatteryInfo battery_info{true, 2, 55.5, 31.0};
+
+    {
+        repowerd::FileEventJournal journal{journal_file.name()};
+        journal.record(at_time(repowerd::DaemonEvent::alarm(7), 10ns));
+        journal.record(at_time(repowerd::DaemonEvent::of_type(EventType::proximity_near), 20ns));
+        journal.record(at_time(repowerd::DaemonEvent::set_inactivity_timeout(30s), 30ns));
+        journal.record(at_time(repowerd::DaemonEvent::set_normal_brightness_value(0.25), 40ns));
+        journal.record(at_time(repowerd::DaemonEvent::power_source_level_change(battery_info), 50ns));
+    }
+
+    auto const events = repowerd::FileEventJournal::read_events(journal_file.name());
+
+    ASSERT_THAT(types_of(events), ElementsAre(
+        EventType::alarm,
+        EventType::proximity_near,
+        EventType::set_inactivity_timeout,
+        EventType::set_normal_brightness_value,
+        EventType::power_source_level_change));
+
+    EXPECT_THAT(events[0].payload.alarm_id, Eq(7));
+    EXPECT_THAT(events[1].enqueue_time_ns, Eq(20));
+    EXPECT_THAT(events[2].payload.timeout_ms, Eq(30000));
+    EXPECT_THAT(events[3].payload.brightness_value, Eq(0.25));
+    EXPECT_THAT(events[4].payload.battery_info.is_present, Eq(true));
+    EXPECT_THAT(events[4].payload.battery_info.state, Eq(2u));
+    EXPECT_THAT(events[4].payload.battery_info.percentage, Eq(55.5));
+    EXPECT_THAT(events[4].payload.battery_info.temperature, Eq(31.0));
+    EXPECT_THAT(events[4].enqueue_time_ns, Eq(50));
+}
+
+TEST_F(AFileEventJournal, does_not_record_daemon_internal_events)
+{
+    std::promise<void> promise;
+
+    {
+        repowerd::FileEventJournal journal{journal_file.name()};
+        journal.record(repowerd::DaemonEvent::flush(&promise));
+        journal.record(repowerd::DaemonEvent::of_type(EventType::proximity_far));
+        journal.record(repowerd::DaemonEvent::of_type(EventType::stop));
+    }
+
+    EXPECT_THAT(types_of(repowerd::FileEventJournal::read_events(journal_file.name())),
+                ElementsAre(EventType::proximity_far));
+}
+
+TEST_F(AFileEventJournal, appends_to_existing_journal)
+{
+    {
+        repowerd::FileEventJournal journal{journal_file.name()};
+        journal.record(repowerd::DaemonEvent::of_type(EventType::proximity_far));
+    }
+
+    {
+        repowerd::FileEventJournal journal{journal_file.name()};
+        journal.record(repowerd::DaemonEvent::of_type(EventType::proximity_near));
+    }
+
+    EXPECT_THAT(types_of(repowerd::FileEventJournal::read_events(journal_file.name())),
+                ElementsAre(EventType::proximity_far, EventType::proximity_near));
+}
+
+TEST_F(AFileEventJournal, ignores_truncated_trailing_record)
+{
+    {
+        repowerd::FileEventJournal journal{journal_file.name()};
+        journal.record(repowerd::DaemonEvent::of_type(EventType::proximity_far));
+        journal.record(repowerd::DaemonEvent::set_normal_brightness_value(0.5));
+    }
+
+    truncate_journal_file_by(3);
+
+    EXPECT_THAT(types_of(repowerd::FileEventJournal::read_events(journal_file.name())),
+                ElementsAre(EventType::proximity_far));
+}
+
+TEST_F(AFileEventJournal, throws_when_reading_file_without_journal_header)
+{
+    journal_file.write("not a journal");
+
+    EXPECT_THROW({
+        repowerd::FileEventJournal::read_events(journal_file.name());
+    }, std::runtime_error);
+}
+
+TEST_F(AFileEventJournal, records_events_entering_daemon)
+{
+    DaemonConfigWithFileEventJournal config{journal_file.name()};
+    repowerd::Daemon daemon{config};
+    std::thread daemon_thread{[&] { daemon.run(); }};
+    daemon.flush();
+
+    config.the_fake_proximity_sensor()->emit_proximity_state(repowerd::ProximityState::near);
+    config.the_fake_proximity_sensor()->emit_proximity_state(repowerd::ProximityState::far);
+
+    daemon.flush();
+    daemon.stop();
+    daemon_thread.join();
+
+    auto const events = repowerd::FileEventJournal::read_events(journal_file.name());
+
+    ASSERT_THAT(types_of(events), ElementsAre(EventType::proximity_near, EventType::proximity_far));
+    EXPECT_THAT(events[0].enqueue_time_ns, Gt(0));
+    EXPECT_THAT(events[1].enqueue_time_ns, Ge(events[0].enqueue_time_ns));
+}
+
+TEST_F(AnEventJournalReplay, fires_alarms_scheduled_by_state_machine_in_recorded_timeline)
+{
+    InSequence s;
+    EXPECT_CALL(*config.the_mock_display_power_control(), turn_on());
+    EXPECT_CALL(*config.the_mock_brightness_control(), set_dim_brightness());
+    EXPECT_CALL(*config.the_mock_display_power_control(), turn_off());
+    EXPECT_CALL(*config.the_mock_display_power_control(), turn_on());
+
+    replay.replay({
+        at_time(repowerd::DaemonEvent::of_type(EventType::power_button_press), 1000s),
+        at_time(repowerd::DaemonEvent::of_type(EventType::power_button_release), 1000s + 100ms),
+        at_time(repowerd::DaemonEvent::of_type(EventType::power_button_press), 1000s + 61s),
+        at_time(repowerd::DaemonEvent::of_type(EventType::power_button_release), 1000s + 61s + 100ms)});
+}
+
+TEST_F(AnEventJournalReplay, skips_recorded_alarms)
+{
+    EXPECT_CALL(*config.the_mock_display_power_control(), turn_off()).Times(0);
+
+    replay.replay({
+        at_time(repowerd::DaemonEvent::of_type(EventType::power_button_press), 0s),
+        at_time(repowerd::DaemonEvent::alarm(1), 100ms),
+        at_time(repowerd::DaemonEvent::alarm(2), 200ms),
+        at_time(repowerd::DaemonEvent::of_type(EventType::power_button_release), 300ms)});
+
+    EXPECT_THAT(replay.num_dispatched_events(), Eq(2u));
+}
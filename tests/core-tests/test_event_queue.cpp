@@ -0,0 +1,217 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "allocation_counter.h"
+#include "src/core/event_queue.h"
+
+#include <thread>
+#include <vector>
+#include <future>
+
+#include <gmock/gmock.h>
+
+namespace rt = repowerd::test;
+
+using namespace std::chrono_literals;
+using EventType = repowerd::DaemonEvent::Type;
+
+namespace
+{
+
+struct AnEventQueue : testing::Test
+{
+    repowerd::EventQueue event_queue{16};
+
+    std::vector<int> dequeue_alarm_ids(size_t n)
+    {
+        std::vector<int> ids;
+        for (size_t i = 0; i < n; ++i)
+            ids.push_back(event_queue.dequeue().payload.alarm_id);
+        return ids;
+    }
+};
+
+}
+
+TEST_F(AnEventQueue, dequeues_events_in_fifo_order)
+{
+    using namespace testing;
+
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(1));
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(2));
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(3));
+
+    EXPECT_THAT(dequeue_alarm_ids(3), ElementsAre(1, 2, 3));
+}
+
+TEST_F(AnEventQueue, dequeues_priority_events_before_pending_events)
+{
+    using namespace testing;
+
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(1));
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(2));
+    event_queue.enqueue_priority(repowerd::DaemonEvent::alarm(3));
+
+    EXPECT_THAT(dequeue_alarm_ids(3), ElementsAre(3, 1, 2));
+}
+
+TEST_F(AnEventQueue, preserves_event_payload)
+{
+    using namespace testing;
+
+    repowerd::BatteryInfo const battery_info{true, 2, 55.0, 30.5};
+
+    event_queue.enqueue(repowerd::DaemonEvent::set_inactivity_timeout(1234ms));
+    event_queue.enqueue(repowerd::DaemonEvent::set_normal_brightness_value(0.25));
+    event_queue.enqueue(repowerd::DaemonEvent::power_source_level_change(battery_info));
+
+    auto const timeout_event = event_queue.dequeue();
+    EXPECT_THAT(timeout_event.type, Eq(EventType::set_inactivity_timeout));
+    EXPECT_THAT(timeout_event.payload.timeout_ms, Eq(1234));
+
+    auto const brightness_event = event_queue.dequeue();
+    EXPECT_THAT(brightness_event.type, Eq(EventType::set_normal_brightness_value));
+    EXPECT_THAT(brightness_event.payload.brightness_value, Eq(0.25));
+
+    auto const battery_event = event_queue.dequeue();
+    EXPECT_THAT(battery_event.type, Eq(EventType::power_source_level_change));
+    EXPECT_THAT(battery_event.payload.battery_info.is_present, Eq(true));
+    EXPECT_THAT(battery_event.payload.battery_info.state, Eq(2u));
+    EXPECT_THAT(battery_event.payload.battery_info.percentage, Eq(55.0));
+    EXPECT_THAT(battery_event.payload.battery_info.temperature, Eq(30.5));
+}
+
+TEST_F(AnEventQueue, dequeue_waits_for_event_to_be_enqueued)
+{
+    auto dequeued = std::async(std::launch::async,
+                               [this] { return event_queue.dequeue().payload.alarm_id; });
+
+    EXPECT_THAT(dequeued.wait_for(50ms), testing::Eq(std::future_status::timeout));
+
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(7));
+
+    EXPECT_THAT(dequeued.wait_for(5s), testing::Eq(std::future_status::ready));
+    EXPECT_THAT(dequeued.get(), testing::Eq(7));
+}
+
+TEST_F(AnEventQueue, handles_more_pending_events_than_pool_size)
+{
+    int const num_events = 100;
+
+    for (int i = 0; i < num_events; ++i)
+        event_queue.enqueue(repowerd::DaemonEvent::alarm(i));
+
+    auto const ids = dequeue_alarm_ids(num_events);
+    for (int i = 0; i < num_events; ++i)
+        EXPECT_THAT(ids[i], testing::Eq(i));
+}
+
+TEST_F(AnEventQueue, coalesces_adjacent_events_of_coalesced_type)
+{
+    using namespace testing;
+
+    event_queue.coalesce_adjacent(EventType::set_normal_brightness_value);
+
+    event_queue.enqueue(repowerd::DaemonEvent::set_normal_brightness_value(0.1));
+    event_queue.enqueue(repowerd::DaemonEvent::set_normal_brightness_value(0.2));
+    event_queue.enqueue(repowerd::DaemonEvent::set_normal_brightness_value(0.3));
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(1));
+
+    auto const event = event_queue.dequeue();
+    EXPECT_THAT(event.type, Eq(EventType::set_normal_brightness_value));
+    EXPECT_THAT(event.payload.brightness_value, Eq(0.3));
+    EXPECT_THAT(event_queue.dequeue().type, Eq(EventType::alarm));
+    EXPECT_THAT(event_queue.num_coalesced(EventType::set_normal_brightness_value), Eq(2u));
+}
+
+TEST_F(AnEventQueue, does_not_coalesce_events_separated_by_other_events)
+{
+    using namespace testing;
+
+    auto const extend = EventType::user_activity_extending_power_state;
+    event_queue.coalesce_adjacent(extend);
+
+    event_queue.enqueue(repowerd::DaemonEvent::of_type(extend));
+    event_queue.enqueue(repowerd::DaemonEvent::of_type(EventType::notification));
+    event_queue.enqueue(repowerd::DaemonEvent::of_type(extend));
+
+    EXPECT_THAT(event_queue.dequeue().type, Eq(extend));
+    EXPECT_THAT(event_queue.dequeue().type, Eq(EventType::notification));
+    EXPECT_THAT(event_queue.dequeue().type, Eq(extend));
+    EXPECT_THAT(event_queue.num_coalesced(extend), Eq(0u));
+}
+
+TEST_F(AnEventQueue, does_not_coalesce_events_of_other_types)
+{
+    using namespace testing;
+
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(1));
+    event_queue.enqueue(repowerd::DaemonEvent::alarm(2));
+
+    EXPECT_THAT(dequeue_alarm_ids(2), ElementsAre(1, 2));
+    EXPECT_THAT(event_queue.num_coalesced(EventType::alarm), Eq(0u));
+}
+
+TEST_F(AnEventQueue, does_not_allocate_when_enqueuing_and_dequeuing)
+{
+    rt::start_counting_allocations();
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        event_queue.enqueue(repowerd::DaemonEvent::alarm(i));
+        event_queue.enqueue_priority(repowerd::DaemonEvent::of_type(EventType::stop));
+        event_queue.dequeue();
+        event_queue.dequeue();
+    }
+
+    EXPECT_THAT(rt::stop_counting_allocations(), testing::Eq(0));
+}
+
+TEST_F(AnEventQueue, preserves_per_producer_order_with_concurrent_producers)
+{
+    int const num_producers = 4;
+    int const events_per_producer = 10000;
+
+    std::vector<std::thread> producers;
+
+    for (int p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back(
+            [this,p]
+            {
+                for (int i = 0; i < events_per_producer; ++i)
+                {
+                    event_queue.enqueue(
+                        repowerd::DaemonEvent::alarm(p * events_per_producer + i));
+                }
+            });
+    }
+
+    std::vector<int> next_expected(num_producers, 0);
+
+    for (int i = 0; i < num_producers * events_per_producer; ++i)
+    {
+        auto const id = event_queue.dequeue().payload.alarm_id;
+        auto const p = id / events_per_producer;
+        ASSERT_THAT(id % events_per_producer, testing::Eq(next_expected[p]));
+        ++next_expected[p];
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/core/event_stats.h"
+
+#include <gmock/gmock.h>
+
+using namespace std::chrono_literals;
+using namespace testing;
+using EventType = repowerd::DaemonEvent::Type;
+
+namespace
+{
+
+struct AnEventStats : testing::Test
+{
+    repowerd::EventStats event_stats;
+};
+
+}
+
+TEST(AnEventStatsBucket, holds_sub_microsecond_durations_in_first_bucket)
+{
+    EXPECT_THAT(repowerd::EventStats::bucket_for(0ns), Eq(0u));
+    EXPECT_THAT(repowerd::EventStats::bucket_for(999ns), Eq(0u));
+}
+
+TEST(AnEventStatsBucket, holds_durations_in_log2_microsecond_buckets)
+{
+    EXPECT_THAT(repowerd::EventStats::bucket_for(1us), Eq(1u));
+    EXPECT_THAT(repowerd::EventStats::bucket_for(2us), Eq(2u));
+    EXPECT_THAT(repowerd::EventStats::bucket_for(3us), Eq(2u));
+    EXPECT_THAT(repowerd::EventStats::bucket_for(4us), Eq(3u));
+    EXPECT_THAT(repowerd::EventStats::bucket_for(1ms), Eq(10u));
+}
+
+TEST(AnEventStatsBucket, holds_very_long_durations_in_last_bucket)
+{
+    EXPECT_THAT(repowerd::EventStats::bucket_for(1h),
+                Eq(repowerd::EventStats::num_buckets - 1));
+}
+
+TEST_F(AnEventStats, starts_with_empty_histograms)
+{
+    repowerd::EventStats::Histogram const empty{};
+
+    for (size_t i = 0; i < repowerd::DaemonEvent::num_types; ++i)
+    {
+        auto const type = static_cast<EventType>(i);
+        EXPECT_THAT(event_stats.queue_latency_histogram(type), Eq(empty));
+        EXPECT_THAT(event_stats.handling_time_histogram(type), Eq(empty));
+    }
+}
+
+TEST_F(AnEventStats, records_durations_in_histograms_of_event_type)
+{
+    event_stats.record(EventType::alarm, 3us, 1ms);
+    event_stats.record(EventType::alarm, 3us, 0us);
+    event_stats.record(EventType::proximity_near, 1us, 1us);
+
+    auto const alarm_queue_latency = event_stats.queue_latency_histogram(EventType::alarm);
+    auto const alarm_handling_time = event_stats.handling_time_histogram(EventType::alarm);
+
+    EXPECT_THAT(alarm_queue_latency[2], Eq(2u));
+    EXPECT_THAT(alarm_handling_time[0], Eq(1u));
+    EXPECT_THAT(alarm_handling_time[10], Eq(1u));
+    EXPECT_THAT(event_stats.queue_latency_histogram(EventType::proximity_near)[1], Eq(1u));
+    EXPECT_THAT(event_stats.queue_latency_histogram(EventType::proximity_far)[1], Eq(0u));
+}
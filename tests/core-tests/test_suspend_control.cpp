@@ -18,9 +18,13 @@
 
 #include "acceptance_test.h"
 #include "fake_suspend_control.h"
+#include "mock_brightness_control.h"
+#include "mock_display_power_control.h"
 
 #include <gtest/gtest.h>
 
+#include <functional>
+
 namespace rt = repowerd::test;
 
 namespace
@@ -80,3 +84,36 @@ TEST_F(ASuspendControl, suspend_is_disallowed_before_display_is_turned_on)
     press_power_button();
     release_power_button();
 }
+
+TEST_F(ASuspendControl, display_brightness_is_off_before_display_is_turned_off_and_suspend_allowed)
+{
+    turn_on_display();
+
+    testing::InSequence s;
+    EXPECT_CALL(*config.the_mock_brightness_control(), set_off_brightness(testing::_));
+    EXPECT_CALL(*config.the_mock_display_power_control(), turn_off());
+    EXPECT_CALL(config.the_fake_suspend_control()->mock, allow_suspend(testing::_));
+
+    press_power_button();
+    release_power_button();
+}
+
+TEST_F(ASuspendControl, display_is_not_turned_off_if_turned_on_before_brightness_reaches_off)
+{
+    turn_on_display();
+
+    std::function<void()> brightness_off;
+    EXPECT_CALL(*config.the_mock_brightness_control(), set_off_brightness(testing::_))
+        .WillOnce(testing::SaveArg<0>(&brightness_off));
+    press_power_button();
+    release_power_button();
+    daemon.flush();
+
+    turn_on_display();
+
+    EXPECT_CALL(*config.the_mock_display_power_control(), turn_off()).Times(0);
+
+    brightness_off();
+
+    expect_suspend_is_disallowed();
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Alexandros Frantzis <alexandros.frantzis@canonical.com>
+ */
+
+#include "src/core/task_graph.h"
+#include "wait_condition.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <gmock/gmock.h>
+
+namespace rt = repowerd::test;
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace
+{
+
+struct ATaskGraph : testing::Test
+{
+    void record(std::string const& name)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        completed.push_back(name);
+    }
+
+    size_t position_of(std::string const& name)
+    {
+        return std::find(completed.begin(), completed.end(), name) - completed.begin();
+    }
+
+    std::vector<std::string> names_of(std::vector<repowerd::TaskGraph::TaskTiming> const& timings)
+    {
+        std::vector<std::string> names;
+        for (auto const& timing : timings)
+            names.push_back(timing.name);
+        return names;
+    }
+
+    repowerd::TaskGraph task_graph;
+    std::mutex mutex;
+    std::vector<std::string> completed;
+};
+
+}
+
+TEST_F(ATaskGraph, runs_tasks_after_their_dependencies)
+{
+    task_graph.add_task("d", {"b", "c"}, [this] { record("d"); });
+    task_graph.add_task("b", {"a"}, [this] { record("b"); });
+    task_graph.add_task("c", {"a"}, [this] { record("c"); });
+    task_graph.add_task("a", {}, [this] { record("a"); });
+
+    task_graph.run(4);
+
+    ASSERT_THAT(completed, UnorderedElementsAre("a", "b", "c", "d"));
+    EXPECT_THAT(position_of("a"), Lt(position_of("b")));
+    EXPECT_THAT(position_of("a"), Lt(position_of("c")));
+    EXPECT_THAT(position_of("b"), Lt(position_of("d")));
+    EXPECT_THAT(position_of("c"), Lt(position_of("d")));
+}
+
+TEST_F(ATaskGraph, runs_independent_tasks_concurrently)
+{
+    rt::WaitCondition a_running;
+    rt::WaitCondition b_running;
+    bool a_saw_b_running{false};
+    bool b_saw_a_running{false};
+
+    task_graph.add_task("a", {},
+        [&]
+        {
+            a_running.wake_up();
+            b_running.wait_for(5s);
+            a_saw_b_running = b_running.woken();
+        });
+    task_graph.add_task("b", {},
+        [&]
+        {
+            b_running.wake_up();
+            a_running.wait_for(5s);
+            b_saw_a_running = a_running.woken();
+        });
+
+    task_graph.run(2);
+
+    EXPECT_TRUE(a_saw_b_running);
+    EXPECT_TRUE(b_saw_a_running);
+}
+
+TEST_F(ATaskGraph, runs_no_more_than_max_concurrency_tasks_at_a_time)
+{
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+
+    for (int i = 0; i < 8; ++i)
+    {
+        task_graph.add_task(std::to_string(i), {},
+            [&]
+            {
+                auto const now_running = ++running;
+                int prev_max = max_running;
+                while (now_running > prev_max &&
+                       !max_running.compare_exchange_weak(prev_max, now_running)) {}
+                std::this_thread::sleep_for(5ms);
+                --running;
+            });
+    }
+
+    task_graph.run(3);
+
+    EXPECT_THAT(max_running.load(), Le(3));
+}
+
+TEST_F(ATaskGraph, returns_timings_of_all_tasks_in_completion_order)
+{
+    task_graph.add_task("b", {"a"}, [] { std::this_thread::sleep_for(2ms); });
+    task_graph.add_task("a", {}, [] {});
+
+    auto const timings = task_graph.run(1);
+
+    EXPECT_THAT(names_of(timings), ElementsAre("a", "b"));
+    EXPECT_THAT(timings[1].duration, Ge(2ms));
+}
+
+TEST_F(ATaskGraph, throws_on_unknown_dependency)
+{
+    task_graph.add_task("a", {"b"}, [this] { record("a"); });
+
+    EXPECT_THROW({ task_graph.run(2); }, std::runtime_error);
+    EXPECT_THAT(completed, IsEmpty());
+}
+
+TEST_F(ATaskGraph, throws_on_dependency_cycle_without_running_tasks)
+{
+    task_graph.add_task("a", {}, [this] { record("a"); });
+    task_graph.add_task("b", {"a", "c"}, [this] { record("b"); });
+    task_graph.add_task("c", {"b"}, [this] { record("c"); });
+
+    EXPECT_THROW({ task_graph.run(2); }, std::runtime_error);
+    EXPECT_THAT(completed, IsEmpty());
+}
+
+TEST_F(ATaskGraph, rethrows_task_exception_and_does_not_run_dependents)
+{
+    task_graph.add_task("a", {}, [] { throw std::logic_error{"a failed"}; });
+    task_graph.add_task("b", {"a"}, [this] { record("b"); });
+
+    EXPECT_THROW({ task_graph.run(2); }, std::logic_error);
+    EXPECT_THAT(completed, IsEmpty());
+}
+
+TEST_F(ATaskGraph, allows_tasks_to_use_direct_and_indirect_dependencies)
+{
+    task_graph.add_task("a", {}, [] {});
+    task_graph.add_task("b", {"a"}, [] {});
+    task_graph.add_task("c", {"b"},
+        [this]
+        {
+            repowerd::TaskGraph::check_dependency("a");
+            repowerd::TaskGraph::check_dependency("b");
+            repowerd::TaskGraph::check_dependency("c");
+            record("c");
+        });
+
+    task_graph.run(2);
+
+    EXPECT_THAT(completed, ElementsAre("c"));
+}
+
+TEST_F(ATaskGraph, fails_task_that_uses_undeclared_dependency)
+{
+    task_graph.add_task("a", {}, [] {});
+    task_graph.add_task("b", {},
+        []
+        {
+            try { repowerd::TaskGraph::check_dependency("a"); }
+            catch (...) {}
+        });
+    task_graph.add_task("c", {"b"}, [this] { record("c"); });
+
+    EXPECT_THROW({ task_graph.run(2); }, std::logic_error);
+    EXPECT_THAT(completed, IsEmpty());
+}
+
+TEST_F(ATaskGraph, allows_any_dependency_outside_running_tasks)
+{
+    EXPECT_NO_THROW(repowerd::TaskGraph::check_dependency("a"));
+}
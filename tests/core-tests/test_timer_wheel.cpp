@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/core/timer_wheel.h"
+
+#include <map>
+#include <random>
+#include <set>
+
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace
+{
+
+struct ATimerWheel : testing::Test
+{
+    std::vector<int> advance_to(repowerd::TimerWheel::Tick tick)
+    {
+        std::vector<repowerd::TimerWheel::Expiration> expired;
+        wheel.advance_to(tick, expired);
+
+        std::vector<int> ids;
+        for (auto const& expiration : expired)
+        {
+            EXPECT_THAT(expiration.expiry, Le(tick));
+            ids.push_back(expiration.id);
+        }
+        return ids;
+    }
+
+    repowerd::TimerWheel::Tick const start{1000};
+    repowerd::TimerWheel wheel{start};
+};
+
+}
+
+TEST_F(ATimerWheel, expires_alarms_at_their_expiry_tick)
+{
+    wheel.add(1, start + 10);
+
+    EXPECT_THAT(advance_to(start + 9), IsEmpty());
+    EXPECT_THAT(advance_to(start + 10), ElementsAre(1));
+    EXPECT_THAT(wheel.size(), Eq(0u));
+}
+
+TEST_F(ATimerWheel, expires_alarms_in_expiry_order)
+{
+    wheel.add(1, start + 300000);
+    wheel.add(2, start + 5);
+    wheel.add(3, start + 70);
+    wheel.add(4, start + 5000);
+
+    EXPECT_THAT(advance_to(start + 1000000), ElementsAre(2, 3, 4, 1));
+}
+
+TEST_F(ATimerWheel, does_not_expire_removed_alarms)
+{
+    wheel.add(1, start + 10);
+    wheel.add(2, start + 20);
+    wheel.add(3, start + 30000);
+
+    EXPECT_TRUE(wheel.remove(2));
+    EXPECT_TRUE(wheel.remove(3));
+    EXPECT_FALSE(wheel.remove(3));
+
+    EXPECT_THAT(advance_to(start + 100000), ElementsAre(1));
+}
+
+TEST_F(ATimerWheel, replaces_alarm_added_again_with_same_id)
+{
+    wheel.add(1, start + 10);
+    wheel.add(1, start + 100);
+
+    EXPECT_THAT(advance_to(start + 50), IsEmpty());
+    EXPECT_THAT(advance_to(start + 100), ElementsAre(1));
+}
+
+TEST_F(ATimerWheel, expires_past_alarms_at_next_tick)
+{
+    wheel.add(1, start - 100);
+
+    EXPECT_THAT(wheel.next_expiry(), Eq(start + 1));
+    EXPECT_THAT(advance_to(start + 1), ElementsAre(1));
+}
+
+TEST_F(ATimerWheel, reports_earliest_expiry)
+{
+    EXPECT_THAT(wheel.next_expiry(), Eq(repowerd::TimerWheel::no_tick));
+
+    wheel.add(1, start + 100000);
+    EXPECT_THAT(wheel.next_expiry(), Eq(start + 100000));
+
+    wheel.add(2, start + 100);
+    EXPECT_THAT(wheel.next_expiry(), Eq(start + 100));
+
+    wheel.remove(2);
+    EXPECT_THAT(wheel.next_expiry(), Eq(start + 100000));
+}
+
+TEST_F(ATimerWheel, handles_alarms_beyond_its_range)
+{
+    auto const far = start + (repowerd::TimerWheel::Tick{1} << 40);
+
+    wheel.add(1, far);
+    wheel.add(2, far + 1);
+
+    EXPECT_THAT(wheel.next_expiry(), Eq(far));
+    EXPECT_THAT(advance_to(far - 1), IsEmpty());
+    EXPECT_THAT(wheel.next_expiry(), Eq(far));
+    EXPECT_THAT(advance_to(far + 1), ElementsAre(1, 2));
+}
+
+TEST_F(ATimerWheel, matches_reference_implementation_for_random_operations)
+{
+    std::mt19937 rng{1234};
+    std::multimap<repowerd::TimerWheel::Tick,int> reference;
+    std::map<int,repowerd::TimerWheel::Tick> active;
+    auto now = start;
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        auto const op = rng() % 10;
+
+        if (op < 5)
+        {
+            // Mix of short and long timeouts, like the ones repowerd uses
+            auto const scale = repowerd::TimerWheel::Tick{1} << (rng() % 28);
+            auto const expiry = now + 1 + rng() % scale;
+            auto const id = static_cast<int>(rng() % 500);
+
+            auto const iter = active.find(id);
+            if (iter != active.end())
+            {
+                auto const range = reference.equal_range(iter->second);
+                for (auto r = range.first; r != range.second; ++r)
+                    if (r->second == id) { reference.erase(r); break; }
+            }
+
+            wheel.add(id, expiry);
+            reference.emplace(expiry, id);
+            active[id] = expiry;
+        }
+        else if (op < 7 && !active.empty())
+        {
+            auto iter = active.begin();
+            std::advance(iter, rng() % active.size());
+            auto const range = reference.equal_range(iter->second);
+            for (auto r = range.first; r != range.second; ++r)
+                if (r->second == iter->first) { reference.erase(r); break; }
+
+            EXPECT_TRUE(wheel.remove(iter->first));
+            active.erase(iter);
+        }
+        else
+        {
+            auto const expected_next =
+                reference.empty() ? repowerd::TimerWheel::no_tick : reference.begin()->first;
+            ASSERT_THAT(wheel.next_expiry(), Eq(expected_next));
+
+            now += rng() % (repowerd::TimerWheel::Tick{1} << (rng() % 24));
+
+            std::multiset<int> expected_expired;
+            while (!reference.empty() && reference.begin()->first <= now)
+            {
+                expected_expired.insert(reference.begin()->second);
+                active.erase(reference.begin()->second);
+                reference.erase(reference.begin());
+            }
+
+            auto const expired = advance_to(now);
+            ASSERT_THAT(std::multiset<int>(expired.begin(), expired.end()),
+                        Eq(expected_expired));
+        }
+
+        ASSERT_THAT(wheel.size(), Eq(active.size()));
+    }
+}
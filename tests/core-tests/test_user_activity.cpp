@@ -17,6 +17,7 @@
  */
 
 #include "acceptance_test.h"
+#include "fake_timer.h"
 
 #include <gtest/gtest.h>
 
@@ -100,6 +101,22 @@ TEST_F(AUserActivity, extending_power_state_resets_display_off_timer)
     advance_time_by(1ms);
 }
 
+TEST_F(AUserActivity, extending_power_state_does_not_reschedule_alarms_every_time)
+{
+    turn_on_display();
+
+    auto const timer_operations_before = config.the_fake_timer()->num_timer_operations();
+
+    for (int i = 0; i < 100; ++i)
+    {
+        perform_user_activity_extending_power_state();
+        advance_time_by(100ms);
+    }
+
+    EXPECT_THAT(config.the_fake_timer()->num_timer_operations(),
+                testing::Eq(timer_operations_before));
+}
+
 TEST_F(AUserActivity, extending_power_state_brightens_dim_display)
 {
     turn_on_display();